@@ -226,6 +226,118 @@ def rover_plan():
         plt.grid()
 
 
+def derive_mpc(horizon=10, dt=0.1, iterations=20, tol=1e-4):
+    """
+    Short horizon path tracking MPC for the ackermann rover.
+
+    The reference is the bezier curve being followed, sampled every dt and
+    held at the end of the curve. Tracking error e = [along, cross, heading]
+    of the reference in the vehicle frame is linearized about the reference,
+    with input du = [dV, domega] relative to the reference velocities:
+
+        e_x' = omega_r e_y - dV
+        e_y' = -omega_r e_x + V_r e_theta
+        e_theta' = -domega
+
+    The condensed QP is only box constrained, so it is solved with a fixed
+    number of unrolled accelerated projected gradient iterations. The
+    generated code has no branches or loops depending on data, and the same
+    cycle count for every solve. The step size comes from a bound on the
+    Hessian norm, the iterations still moving the solution by more than tol
+    are counted and returned to monitor convergence.
+    """
+    n = 6
+    rover = derive_rover()
+    bezier6_rover = rover['bezier6_rover']
+
+    t = ca.SX.sym('t')
+    T = ca.SX.sym('T')
+    PX = ca.SX.sym('PX', 1, n)
+    PY = ca.SX.sym('PY', 1, n)
+    e0 = ca.SX.sym('e0', 3)  # se2_error of the reference at t
+    L = ca.SX.sym('L')  # wheel base
+    V_max = ca.SX.sym('V_max')
+    delta_max = ca.SX.sym('delta_max')
+    q = ca.SX.sym('q', 3)  # error weights
+    r = ca.SX.sym('r', 2)  # input weights
+    du0 = ca.SX.sym('du0', 2*horizon)  # warm start
+
+    # reference along the horizon
+    V_r = []
+    omega_r = []
+    for k in range(horizon):
+        tk = ca.fmin(t + k*dt, T)
+        ref = bezier6_rover(tk, T, PX, PY)
+        V_r.append(ref[3])
+        omega_r.append(ref[4])
+
+    # input bounds, 0 <= V <= V_max, |omega| <= V tan(delta_max)/L
+    lb = []
+    ub = []
+    for k in range(horizon):
+        omega_max = ca.fmax(V_r[k], 0)*ca.tan(delta_max)/L
+        lb += [-V_r[k], -omega_max - omega_r[k]]
+        ub += [V_max - V_r[k], omega_max - omega_r[k]]
+    lb = ca.vertcat(*lb)
+    ub = ca.vertcat(*ub)
+
+    # cost of the linearized prediction
+    du = ca.SX.sym('du', 2*horizon)
+    Q = ca.diag(q)
+    R = ca.diag(r)
+    e = e0
+    J = 0
+    for k in range(horizon):
+        u = du[2*k:2*k + 2]
+        J += u.T@R@u
+        e = ca.vertcat(
+            e[0] + dt*(omega_r[k]*e[1] - u[0]),
+            e[1] + dt*(-omega_r[k]*e[0] + V_r[k]*e[2]),
+            e[2] - dt*u[1])
+        J += e.T@Q@e
+    grad = ca.gradient(J, du)
+
+    # lipschitz constant of the gradient, 2 (|R| + |Q| |G|^2) where the
+    # prediction matrix G is block toeplitz with |A_k| <= a, |B_k| <= dt
+    a = 0
+    for k in range(horizon):
+        a = ca.fmax(a, 1 + dt*(ca.fabs(omega_r[k]) + ca.fabs(V_r[k])))
+    g = 0
+    for k in range(horizon):
+        g = g*a + dt
+    lipschitz = 2*(ca.mmax(r) + ca.mmax(q)*g**2)
+
+    # accelerated projected gradient, fixed iterations
+    x = ca.fmin(ca.fmax(du0, lb), ub)
+    y = x
+    theta = 1.0
+    n_iter = 0
+    for i in range(iterations):
+        x_next = ca.fmin(ca.fmax(y - ca.substitute(grad, du, y)/lipschitz, lb), ub)
+        n_iter += ca.if_else(ca.mmax(ca.fabs(x_next - x)) > tol, 1, 0)
+        theta_next = (1 + math.sqrt(1 + 4*theta**2))/2
+        y = x_next + (theta - 1)/theta_next*(x_next - x)
+        x = x_next
+        theta = theta_next
+
+    V = V_r[0] + x[0]
+    omega = omega_r[0] + x[1]
+
+    # shifted solution to warm start the next solve
+    du_next = ca.vertcat(x[2:], x[-2:])
+
+    functions = [
+        ca.Function(
+            'rover_mpc',
+            [t, T, PX, PY, e0, L, V_max, delta_max, q, r, du0],
+            [V, omega, du_next, n_iter],
+            ['t', 'T', 'PX', 'PY', 'e0', 'L', 'V_max', 'delta_max', 'q', 'r', 'du0'],
+            ['V', 'omega', 'du', 'iterations']),
+    ]
+
+    return { f.name(): f for f in functions }
+
+
 def derive_se2():
     # derive se2_error
     p = lie.SE2.elem(ca.SX.sym('p', 3))
@@ -341,6 +453,7 @@ def generate_code(eqs: dict, filename, dest_dir: str, **kwargs):
         "with_import": False,
         "include_math": True,
         "avoid_stack": True,
+        "casadi_real": "double",
     }
     for k, v in kwargs.items():
         assert k in p.keys()
@@ -351,9 +464,29 @@ def generate_code(eqs: dict, filename, dest_dir: str, **kwargs):
         gen.add(eq)
     gen.generate(str(dest_dir) + os.sep)
 
+def rename(eqs: dict, suffix: str):
+    """
+    Append suffix to function names, so that kernels generated with a
+    different casadi_real can be linked next to the default ones.
+    """
+    if not suffix:
+        return eqs
+    renamed = {}
+    for name, f in eqs.items():
+        f_in = f.sx_in()
+        g = ca.Function(name + suffix, f_in, f.call(f_in), f.name_in(), f.name_out())
+        renamed[g.name()] = g
+    return renamed
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser()
     parser.add_argument('dest_dir')
+    parser.add_argument('--float', action='store_true',
+        help='generate control kernels with single precision casadi_real')
+    parser.add_argument('--suffix', default='',
+        help='suffix appended to generated file and function names')
+    parser.add_argument('--mpc-horizon', type=int, default=10,
+        help='number of steps predicted by the path tracking mpc')
     args = parser.parse_args()
 
     print("generating casadi equations in {:s}".format(args.dest_dir))
@@ -368,10 +501,19 @@ if __name__ == "__main__":
     eqs.update(derive_bezier6())
     eqs.update(derive_rover())
     eqs.update(derive_se2())
-    eqs.update(derive_rover2d_estimator())
+    eqs.update(derive_mpc(horizon=args.mpc_horizon))
+    eqs = rename(eqs, args.suffix)
 
     for name, eq in eqs.items():
         print('eq: ', name)
 
-    generate_code(eqs, filename="b3rb.c", dest_dir=args.dest_dir)
+    casadi_real = "float" if args.float else "double"
+    generate_code(eqs, filename="b3rb" + args.suffix + ".c", dest_dir=args.dest_dir,
+        casadi_real=casadi_real)
+
+    # the estimator integrates absolute position, which loses too much
+    # resolution in single precision, so it is always generated as double
+    eqs_estimate = rename(derive_rover2d_estimator(), args.suffix)
+    generate_code(eqs_estimate, filename="b3rb_estimate" + args.suffix + ".c",
+        dest_dir=args.dest_dir)
     print("complete")
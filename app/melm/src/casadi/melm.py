@@ -334,6 +334,7 @@ def generate_code(eqs: dict, filename, dest_dir: str, **kwargs):
         "with_import": False,
         "include_math": True,
         "avoid_stack": True,
+        "casadi_real": "double",
     }
     for k, v in kwargs.items():
         assert k in p.keys()
@@ -344,9 +345,27 @@ def generate_code(eqs: dict, filename, dest_dir: str, **kwargs):
         gen.add(eq)
     gen.generate(str(dest_dir) + os.sep)
 
+def rename(eqs: dict, suffix: str):
+    """
+    Append suffix to function names, so that kernels generated with a
+    different casadi_real can be linked next to the default ones.
+    """
+    if not suffix:
+        return eqs
+    renamed = {}
+    for name, f in eqs.items():
+        f_in = f.sx_in()
+        g = ca.Function(name + suffix, f_in, f.call(f_in), f.name_in(), f.name_out())
+        renamed[g.name()] = g
+    return renamed
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser()
     parser.add_argument('dest_dir')
+    parser.add_argument('--float', action='store_true',
+        help='generate control kernels with single precision casadi_real')
+    parser.add_argument('--suffix', default='',
+        help='suffix appended to generated file and function names')
     args = parser.parse_args()
 
     print("generating casadi equations in {:s}".format(args.dest_dir))
@@ -361,10 +380,18 @@ if __name__ == "__main__":
     eqs.update(derive_bezier6())
     eqs.update(derive_rover())
     eqs.update(derive_se2())
-    eqs.update(derive_rover2d_estimator())
+    eqs = rename(eqs, args.suffix)
 
     for name, eq in eqs.items():
         print('eq: ', name)
 
-    generate_code(eqs, filename="melm.c", dest_dir=args.dest_dir)
+    casadi_real = "float" if args.float else "double"
+    generate_code(eqs, filename="melm" + args.suffix + ".c", dest_dir=args.dest_dir,
+        casadi_real=casadi_real)
+
+    # the estimator integrates absolute position, which loses too much
+    # resolution in single precision, so it is always generated as double
+    eqs_estimate = rename(derive_rover2d_estimator(), args.suffix)
+    generate_code(eqs_estimate, filename="melm_estimate" + args.suffix + ".c",
+        dest_dir=args.dest_dir)
     print("complete")
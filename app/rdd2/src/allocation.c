@@ -20,6 +20,8 @@
 
 #include <cerebri/core/casadi.h>
 
+#include "pipeline.h"
+
 #define MY_STACK_SIZE 3072
 #define MY_PRIORITY   4
 
@@ -29,7 +31,11 @@
 
 LOG_MODULE_REGISTER(rdd2_allocation, CONFIG_CEREBRI_RDD2_LOG_LEVEL);
 
+#if !defined(CONFIG_CEREBRI_RDD2_PIPELINE)
 static K_THREAD_STACK_DEFINE(g_my_stack_area, MY_STACK_SIZE);
+#endif
+
+CASADI_FUNC_DEFINE(control_allocation);
 
 struct context {
 	struct zros_node node;
@@ -63,8 +69,10 @@ static struct context g_ctx = {
 	.sub_moment_sp = {},
 	.pub_actuators = {},
 	.running = Z_SEM_INITIALIZER(g_ctx.running, 1, 1),
+#if !defined(CONFIG_CEREBRI_RDD2_PIPELINE)
 	.stack_size = MY_STACK_SIZE,
 	.stack_area = g_my_stack_area,
+#endif
 	.thread_data = {},
 };
 
@@ -73,7 +81,10 @@ static void rdd2_allocation_init(struct context *ctx)
 	zros_node_init(&ctx->node, "rdd2_allocation");
 	zros_sub_init(&ctx->sub_status, &ctx->node, &topic_status, &ctx->status, 10);
 	zros_sub_init(&ctx->sub_force_sp, &ctx->node, &topic_force_sp, &ctx->force_sp, 1000);
+#if !defined(CONFIG_CEREBRI_RDD2_PIPELINE)
+	// the control pipeline passes the moment setpoint directly when enabled
 	zros_sub_init(&ctx->sub_moment_sp, &ctx->node, &topic_moment_sp, &ctx->moment_sp, 1000);
+#endif
 	zros_pub_init(&ctx->pub_actuators, &ctx->node, &topic_actuators, &ctx->actuators);
 	k_sem_take(&ctx->running, K_FOREVER);
 	LOG_INF("init");
@@ -83,7 +94,9 @@ static void rdd2_allocation_fini(struct context *ctx)
 {
 	zros_sub_fini(&ctx->sub_status);
 	zros_sub_fini(&ctx->sub_force_sp);
+#if !defined(CONFIG_CEREBRI_RDD2_PIPELINE)
 	zros_sub_fini(&ctx->sub_moment_sp);
+#endif
 	zros_pub_fini(&ctx->pub_actuators);
 	zros_node_fini(&ctx->node);
 	k_sem_give(&ctx->running);
@@ -97,6 +110,83 @@ static void stop(struct context *ctx)
 	}
 }
 
+// compute and publish motor velocities, a NULL moment setpoint stops the motors
+static void rdd2_allocation_update(struct context *ctx, const synapse_pb_Vector3 *moment_sp)
+{
+	if (zros_sub_update_available(&ctx->sub_status)) {
+		zros_sub_update(&ctx->sub_status);
+	}
+
+	if (zros_sub_update_available(&ctx->sub_force_sp)) {
+		zros_sub_update(&ctx->sub_force_sp);
+	}
+
+	if (moment_sp == NULL) {
+		stop(ctx);
+		LOG_DBG("no data, stopped");
+	} else if (ctx->status.arming != synapse_pb_Status_Arming_ARMING_ARMED) {
+		stop(ctx);
+		LOG_DBG("not armed, stopped");
+	} else {
+		static double const F_max = 40.0;
+		static double const l = CONFIG_CEREBRI_RDD2_MOTOR_L_MM * 1e-3;
+		static double const Cm = CONFIG_CEREBRI_RDD2_MOTOR_CM * 1e-6;
+		static double const Ct = CONFIG_CEREBRI_RDD2_MOTOR_CT * 1e-9;
+		double omega[4];
+		double moment[3] = {moment_sp->x, moment_sp->y, moment_sp->z};
+
+		// LOG_INF("thrust: %10.4f", ctx->force_sp.z);
+
+		// control_allocation:(F_max,l,Cm,Ct,T,M[3])->(omega[4])
+		CASADI_FUNC_ARGS(control_allocation)
+		args[0] = &F_max;
+		args[1] = &l;
+		args[2] = &Cm;
+		args[3] = &Ct;
+		args[4] = &ctx->force_sp.z;
+		args[5] = moment;
+		res[0] = omega;
+		CASADI_FUNC_CALL(control_allocation)
+		for (int i = 0; i < 4; i++) {
+			if (!isfinite(omega[i])) {
+				LOG_WRN("omega is not finite: %10.4f", omega[i]);
+				omega[i] = 0;
+			} else if (omega[i] > 3000) {
+				LOG_WRN("omega too large: %10.4f", omega[i]);
+				omega[i] = 3000;
+			} else if (omega[i] < 0) {
+				LOG_WRN("omega negative: %10.4f", omega[i]);
+				omega[i] = 0;
+			}
+			ctx->actuators.velocity[i] = omega[i];
+		}
+	}
+
+	stamp_msg(&ctx->actuators.stamp, k_uptime_ticks());
+
+	// publish
+	synapse_pub_update(&ctx->pub_actuators, SYNAPSE_TOPIC_actuators);
+}
+
+#if defined(CONFIG_CEREBRI_RDD2_PIPELINE)
+
+void rdd2_allocation_pipeline_init(void)
+{
+	rdd2_allocation_init(&g_ctx);
+}
+
+void rdd2_allocation_pipeline_fini(void)
+{
+	rdd2_allocation_fini(&g_ctx);
+}
+
+void rdd2_allocation_pipeline_step(const synapse_pb_Vector3 *moment_sp)
+{
+	rdd2_allocation_update(&g_ctx, moment_sp);
+}
+
+#else
+
 static void rdd2_allocation_run(void *p0, void *p1, void *p2)
 {
 	struct context *ctx = p0;
@@ -116,63 +206,11 @@ static void rdd2_allocation_run(void *p0, void *p1, void *p2)
 			LOG_DBG("not receiving moment_sp");
 		}
 
-		if (zros_sub_update_available(&ctx->sub_status)) {
-			zros_sub_update(&ctx->sub_status);
-		}
-
-		if (zros_sub_update_available(&ctx->sub_force_sp)) {
-			zros_sub_update(&ctx->sub_force_sp);
-		}
-
 		if (zros_sub_update_available(&ctx->sub_moment_sp)) {
 			zros_sub_update(&ctx->sub_moment_sp);
 		}
 
-		if (rc < 0) {
-			stop(ctx);
-			LOG_DBG("no data, stopped");
-		} else if (ctx->status.arming != synapse_pb_Status_Arming_ARMING_ARMED) {
-			stop(ctx);
-			LOG_DBG("not armed, stopped");
-		} else {
-			static double const F_max = 40.0;
-			static double const l = CONFIG_CEREBRI_RDD2_MOTOR_L_MM * 1e-3;
-			static double const Cm = CONFIG_CEREBRI_RDD2_MOTOR_CM * 1e-6;
-			static double const Ct = CONFIG_CEREBRI_RDD2_MOTOR_CT * 1e-9;
-			double omega[4];
-			double moment[3] = {ctx->moment_sp.x, ctx->moment_sp.y, ctx->moment_sp.z};
-
-			// LOG_INF("thrust: %10.4f", ctx->force_sp.z);
-
-			// control_allocation:(F_max,l,Cm,Ct,T,M[3])->(omega[4])
-			CASADI_FUNC_ARGS(control_allocation)
-			args[0] = &F_max;
-			args[1] = &l;
-			args[2] = &Cm;
-			args[3] = &Ct;
-			args[4] = &ctx->force_sp.z;
-			args[5] = moment;
-			res[0] = omega;
-			CASADI_FUNC_CALL(control_allocation)
-			for (int i = 0; i < 4; i++) {
-				if (!isfinite(omega[i])) {
-					LOG_WRN("omega is not finite: %10.4f", omega[i]);
-					omega[i] = 0;
-				} else if (omega[i] > 3000) {
-					LOG_WRN("omega too large: %10.4f", omega[i]);
-					omega[i] = 3000;
-				} else if (omega[i] < 0) {
-					LOG_WRN("omega negative: %10.4f", omega[i]);
-					omega[i] = 0;
-				}
-				ctx->actuators.velocity[i] = omega[i];
-			}
-		}
-
-		stamp_msg(&ctx->actuators.stamp, k_uptime_ticks());
-
-		// publish
-		zros_pub_update(&ctx->pub_actuators);
+		rdd2_allocation_update(ctx, rc < 0 ? NULL : &ctx->moment_sp);
 	}
 
 	rdd2_allocation_fini(ctx);
@@ -224,4 +262,6 @@ static int rdd2_allocation_sys_init(void)
 
 SYS_INIT(rdd2_allocation_sys_init, APPLICATION, 4);
 
+#endif // CONFIG_CEREBRI_RDD2_PIPELINE
+
 // vi: ts=4 sw=4 et
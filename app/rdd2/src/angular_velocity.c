@@ -17,15 +17,21 @@
 #include <zros/zros_sub.h>
 
 #include <cerebri/core/casadi.h>
+#include <cerebri/core/freshness.h>
 
 #include "app/rdd2/casadi/rdd2.h"
+#include "pipeline.h"
 
 #define MY_STACK_SIZE 3072
 #define MY_PRIORITY   4
 
 LOG_MODULE_REGISTER(rdd2_angular_velocity, CONFIG_CEREBRI_RDD2_LOG_LEVEL);
 
+#if !defined(CONFIG_CEREBRI_RDD2_PIPELINE)
 static K_THREAD_STACK_DEFINE(g_my_stack_area, MY_STACK_SIZE);
+#endif
+
+CASADI_FUNC_DEFINE(attitude_rate_control);
 
 struct context {
 	struct zros_node node;
@@ -34,6 +40,9 @@ struct context {
 	synapse_pb_Odometry odometry_estimator;
 	struct zros_sub sub_status, sub_angular_velocity_sp, sub_odometry_estimator, sub_moment_ff;
 	struct zros_pub pub_moment_sp;
+#if !defined(CONFIG_CEREBRI_RDD2_PIPELINE)
+	struct freshness fresh_odometry;
+#endif
 	struct k_sem running;
 	size_t stack_size;
 	k_thread_stack_t *stack_area;
@@ -50,6 +59,7 @@ struct context {
 	double omega_e[3];
 	double domega_e[3];
 	double alpha;
+	int64_t ticks_last;
 };
 
 static struct context g_ctx = {
@@ -64,8 +74,10 @@ static struct context g_ctx = {
 	.sub_moment_ff = {},
 	.pub_moment_sp = {},
 	.running = Z_SEM_INITIALIZER(g_ctx.running, 1, 1),
+#if !defined(CONFIG_CEREBRI_RDD2_PIPELINE)
 	.stack_size = MY_STACK_SIZE,
 	.stack_area = g_my_stack_area,
+#endif
 	.thread_data = {},
 	.kp =
 		{
@@ -95,6 +107,7 @@ static struct context g_ctx = {
 	.omega_i = {},
 	.omega_e = {},
 	.domega_e = {},
+	.ticks_last = 0,
 };
 
 static void rdd2_angular_velocity_init(struct context *ctx)
@@ -103,10 +116,16 @@ static void rdd2_angular_velocity_init(struct context *ctx)
 	zros_sub_init(&ctx->sub_status, &ctx->node, &topic_status, &ctx->status, 10);
 	zros_sub_init(&ctx->sub_angular_velocity_sp, &ctx->node, &topic_angular_velocity_sp,
 		      &ctx->angular_velocity_sp, 1000);
+#if !defined(CONFIG_CEREBRI_RDD2_PIPELINE)
+	// the control pipeline passes odometry directly when enabled
 	zros_sub_init(&ctx->sub_odometry_estimator, &ctx->node, &topic_odometry_estimator,
 		      &ctx->odometry_estimator, 1000);
+	freshness_init(&ctx->fresh_odometry, "rdd2_angular_velocity odometry",
+		       CONFIG_CEREBRI_RDD2_ODOMETRY_MAX_AGE_MS);
+#endif
 	zros_sub_init(&ctx->sub_moment_ff, &ctx->node, &topic_moment_ff, &ctx->moment_ff, 1000);
 	zros_pub_init(&ctx->pub_moment_sp, &ctx->node, &topic_moment_sp, &ctx->moment_sp);
+	ctx->ticks_last = k_uptime_ticks();
 	k_sem_take(&ctx->running, K_FOREVER);
 	LOG_INF("init");
 }
@@ -115,7 +134,10 @@ static void rdd2_angular_velocity_fini(struct context *ctx)
 {
 	zros_sub_fini(&ctx->sub_status);
 	zros_sub_fini(&ctx->sub_angular_velocity_sp);
+#if !defined(CONFIG_CEREBRI_RDD2_PIPELINE)
+	freshness_fini(&ctx->fresh_odometry);
 	zros_sub_fini(&ctx->sub_odometry_estimator);
+#endif
 	zros_sub_fini(&ctx->sub_moment_ff);
 	zros_pub_fini(&ctx->pub_moment_sp);
 	zros_node_fini(&ctx->node);
@@ -123,6 +145,112 @@ static void rdd2_angular_velocity_fini(struct context *ctx)
 	LOG_INF("fini");
 }
 
+// compute the moment setpoint, returns true if it was published
+static bool rdd2_angular_velocity_update(struct context *ctx, const synapse_pb_Odometry *odometry,
+					 const synapse_pb_Vector3 *angular_velocity_sp)
+{
+	if (zros_sub_update_available(&ctx->sub_status)) {
+		zros_sub_update(&ctx->sub_status);
+	}
+
+	if (zros_sub_update_available(&ctx->sub_moment_ff)) {
+		zros_sub_update(&ctx->sub_moment_ff);
+	}
+
+	// calculate dt
+	int64_t ticks_now = k_uptime_ticks();
+	ctx->dt = (double)(ticks_now - ctx->ticks_last) / CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+	ctx->ticks_last = ticks_now;
+	if (ctx->dt < 0 || ctx->dt > 0.1) {
+		LOG_DBG("odometry rate too low");
+		return false;
+	}
+
+	double M[3];
+	{
+		// attitude_rate_control:(
+		//  kp[3],ki[3],kd[3],f_cut,i_max[3],
+		//  omega[3],omega_r[3],i0[3],e0[3],de0[3],dt)->(M[3],i1[3],e1[3],de1[3]) */
+		CASADI_FUNC_ARGS(attitude_rate_control);
+		ctx->omega[0] = odometry->twist.angular.x;
+		ctx->omega[1] = odometry->twist.angular.y;
+		ctx->omega[2] = odometry->twist.angular.z;
+		ctx->omega_r[0] = angular_velocity_sp->x;
+		ctx->omega_r[1] = angular_velocity_sp->y;
+		ctx->omega_r[2] = angular_velocity_sp->z;
+		args[0] = ctx->kp;
+		args[1] = ctx->ki;
+		args[2] = ctx->kd;
+		args[3] = &(ctx->f_cut);
+		args[4] = ctx->i_max;
+		args[5] = ctx->omega;
+		args[6] = ctx->omega_r;
+		args[7] = ctx->omega_i;
+		args[8] = ctx->omega_e;
+		args[9] = ctx->domega_e;
+		args[10] = &ctx->dt;
+		res[0] = M;
+		res[1] = ctx->omega_i;
+		res[2] = ctx->omega_e;
+		res[3] = ctx->domega_e;
+		res[4] = &ctx->alpha;
+		CASADI_FUNC_CALL(attitude_rate_control);
+	}
+
+	// LOG_INF("omega_i: %10.4f %10.4f %10.4f",
+	//     omega_i[0], omega_i[1], omega_i[2]);
+
+	for (int i = 0; i < 3; i++) {
+		if (!isfinite(ctx->omega_i[i])) {
+			LOG_ERR("omega_i[%d] not finite: %10.4f", i, ctx->omega_i[i]);
+			return false;
+		}
+		if (!isfinite(M[i])) {
+			LOG_ERR("M[%d] not finite: %10.4f", i, M[i]);
+			return false;
+		}
+	}
+
+	// publish moment setpoint
+	ctx->moment_sp.x = M[0] + ctx->moment_ff.x;
+	ctx->moment_sp.y = M[1] + ctx->moment_ff.y;
+	ctx->moment_sp.z = M[2] + ctx->moment_ff.z;
+	synapse_pub_update(&ctx->pub_moment_sp, SYNAPSE_TOPIC_moment_sp);
+	return true;
+}
+
+#if defined(CONFIG_CEREBRI_RDD2_PIPELINE)
+
+void rdd2_angular_velocity_pipeline_init(void)
+{
+	rdd2_angular_velocity_init(&g_ctx);
+}
+
+void rdd2_angular_velocity_pipeline_fini(void)
+{
+	rdd2_angular_velocity_fini(&g_ctx);
+}
+
+const synapse_pb_Vector3 *
+rdd2_angular_velocity_pipeline_step(const synapse_pb_Odometry *odometry,
+				    const synapse_pb_Vector3 *angular_velocity_sp)
+{
+	struct context *ctx = &g_ctx;
+
+	// without attitude control, the setpoint comes from the topic
+	if (angular_velocity_sp == NULL) {
+		if (zros_sub_update_available(&ctx->sub_angular_velocity_sp)) {
+			zros_sub_update(&ctx->sub_angular_velocity_sp);
+		}
+		angular_velocity_sp = &ctx->angular_velocity_sp;
+	}
+
+	return rdd2_angular_velocity_update(ctx, odometry, angular_velocity_sp) ? &ctx->moment_sp
+										 : NULL;
+}
+
+#else
+
 static void rdd2_angular_velocity_run(void *p0, void *p1, void *p2)
 {
 	struct context *ctx = p0;
@@ -135,96 +263,33 @@ static void rdd2_angular_velocity_run(void *p0, void *p1, void *p2)
 		*zros_sub_get_event(&ctx->sub_odometry_estimator),
 	};
 
-	int64_t ticks_last = k_uptime_ticks();
-
 	while (k_sem_take(&ctx->running, K_NO_WAIT) < 0) {
-		// wait for estimator odometry, publish at 10 Hz regardless
+		// wait for estimator odometry, at most until it goes stale
 		int rc = 0;
-		rc = k_poll(events, ARRAY_SIZE(events), K_MSEC(100));
+		rc = k_poll(events, ARRAY_SIZE(events),
+			    K_MSEC(CONFIG_CEREBRI_RDD2_ODOMETRY_MAX_AGE_MS));
 		if (rc != 0) {
 			LOG_DBG("not receiving estimator odometry");
 		}
 
-		if (zros_sub_update_available(&ctx->sub_status)) {
-			zros_sub_update(&ctx->sub_status);
-		}
-
 		if (zros_sub_update_available(&ctx->sub_odometry_estimator)) {
 			zros_sub_update(&ctx->sub_odometry_estimator);
+			freshness_update(&ctx->fresh_odometry);
 		}
 
 		if (zros_sub_update_available(&ctx->sub_angular_velocity_sp)) {
 			zros_sub_update(&ctx->sub_angular_velocity_sp);
 		}
 
-		if (zros_sub_update_available(&ctx->sub_moment_ff)) {
-			zros_sub_update(&ctx->sub_moment_ff);
-		}
-
-		// calculate dt
-		int64_t ticks_now = k_uptime_ticks();
-		ctx->dt = (double)(ticks_now - ticks_last) / CONFIG_SYS_CLOCK_TICKS_PER_SEC;
-		ticks_last = ticks_now;
-		if (ctx->dt < 0 || ctx->dt > 0.1) {
-			LOG_DBG("odometry rate too low");
+		// never control on old odometry, command zero moment instead
+		if (!freshness_check(&ctx->fresh_odometry)) {
+			ctx->moment_sp = (synapse_pb_Vector3)synapse_pb_Vector3_init_default;
+			synapse_pub_update(&ctx->pub_moment_sp, SYNAPSE_TOPIC_moment_sp);
 			continue;
 		}
 
-		double M[3];
-		{
-			// attitude_rate_control:(
-			//  kp[3],ki[3],kd[3],f_cut,i_max[3],
-			//  omega[3],omega_r[3],i0[3],e0[3],de0[3],dt)->(M[3],i1[3],e1[3],de1[3]) */
-			CASADI_FUNC_ARGS(attitude_rate_control);
-			ctx->omega[0] = ctx->odometry_estimator.twist.angular.x;
-			ctx->omega[1] = ctx->odometry_estimator.twist.angular.y;
-			ctx->omega[2] = ctx->odometry_estimator.twist.angular.z;
-			ctx->omega_r[0] = ctx->angular_velocity_sp.x;
-			ctx->omega_r[1] = ctx->angular_velocity_sp.y;
-			ctx->omega_r[2] = ctx->angular_velocity_sp.z;
-			args[0] = ctx->kp;
-			args[1] = ctx->ki;
-			args[2] = ctx->kd;
-			args[3] = &(ctx->f_cut);
-			args[4] = ctx->i_max;
-			args[5] = ctx->omega;
-			args[6] = ctx->omega_r;
-			args[7] = ctx->omega_i;
-			args[8] = ctx->omega_e;
-			args[9] = ctx->domega_e;
-			args[10] = &ctx->dt;
-			res[0] = M;
-			res[1] = ctx->omega_i;
-			res[2] = ctx->omega_e;
-			res[3] = ctx->domega_e;
-			res[4] = &ctx->alpha;
-			CASADI_FUNC_CALL(attitude_rate_control);
-		}
-
-		// LOG_INF("omega_i: %10.4f %10.4f %10.4f",
-		//     omega_i[0], omega_i[1], omega_i[2]);
-
-		bool data_ok = true;
-		for (int i = 0; i < 3; i++) {
-			if (!isfinite(ctx->omega_i[i])) {
-				LOG_ERR("omega_i[%d] not finite: %10.4f", i, ctx->omega_i[i]);
-				data_ok = false;
-				break;
-			}
-			if (!isfinite(M[i])) {
-				LOG_ERR("M[%d] not finite: %10.4f", i, M[i]);
-				data_ok = false;
-				break;
-			}
-		}
-
-		// publish moment setpoint
-		if (data_ok) {
-			ctx->moment_sp.x = M[0] + ctx->moment_ff.x;
-			ctx->moment_sp.y = M[1] + ctx->moment_ff.y;
-			ctx->moment_sp.z = M[2] + ctx->moment_ff.z;
-			zros_pub_update(&ctx->pub_moment_sp);
-		}
+		rdd2_angular_velocity_update(ctx, &ctx->odometry_estimator,
+					     &ctx->angular_velocity_sp);
 	}
 
 	rdd2_angular_velocity_fini(ctx);
@@ -296,4 +361,6 @@ static int rdd2_angular_velocity_sys_init(void)
 
 SYS_INIT(rdd2_angular_velocity_sys_init, APPLICATION, 4);
 
+#endif // CONFIG_CEREBRI_RDD2_PIPELINE
+
 // vi: ts=4 sw=4 et
@@ -25,12 +25,23 @@
 
 #include <synapse_topic_list.h>
 
+#include "pipeline.h"
+
 #define MY_STACK_SIZE 3072
 #define MY_PRIORITY   4
 
 LOG_MODULE_REGISTER(rdd2_attitude, CONFIG_CEREBRI_RDD2_LOG_LEVEL);
 
+#if !defined(CONFIG_CEREBRI_RDD2_PIPELINE)
 static K_THREAD_STACK_DEFINE(g_my_stack_area, MY_STACK_SIZE);
+#endif
+
+#if defined(CONFIG_CEREBRI_RDD2_LOG_LINEAR_ATTITUDE)
+CASADI_FUNC_DEFINE(se23_error);
+CASADI_FUNC_DEFINE(so3_attitude_control);
+#else
+CASADI_FUNC_DEFINE(attitude_control);
+#endif
 
 struct context {
 	struct zros_node node;
@@ -63,8 +74,10 @@ static struct context g_ctx = {
 	.sub_odometry_estimator = {},
 	.pub_angular_velocity_sp = {},
 	.running = Z_SEM_INITIALIZER(g_ctx.running, 1, 1),
+#if !defined(CONFIG_CEREBRI_RDD2_PIPELINE)
 	.stack_size = MY_STACK_SIZE,
 	.stack_area = g_my_stack_area,
+#endif
 	.thread_data = {},
 };
 
@@ -75,8 +88,11 @@ static void rdd2_attitude_init(struct context *ctx)
 	zros_sub_init(&ctx->sub_position_sp, &ctx->node, &topic_position_sp, &ctx->position_sp, 50);
 	zros_sub_init(&ctx->sub_velocity_sp, &ctx->node, &topic_velocity_sp, &ctx->velocity_sp, 50);
 	zros_sub_init(&ctx->sub_attitude_sp, &ctx->node, &topic_attitude_sp, &ctx->attitude_sp, 50);
+#if !defined(CONFIG_CEREBRI_RDD2_PIPELINE)
+	// the control pipeline passes odometry directly when enabled
 	zros_sub_init(&ctx->sub_odometry_estimator, &ctx->node, &topic_odometry_estimator,
 		      &ctx->odometry_estimator, 50);
+#endif
 	zros_sub_init(&ctx->sub_angular_velocity_ff, &ctx->node, &topic_angular_velocity_ff,
 		      &ctx->angular_velocity_ff, 50);
 	zros_pub_init(&ctx->pub_angular_velocity_sp, &ctx->node, &topic_angular_velocity_sp,
@@ -91,7 +107,9 @@ static void rdd2_attitude_fini(struct context *ctx)
 	zros_sub_fini(&ctx->sub_position_sp);
 	zros_sub_fini(&ctx->sub_velocity_sp);
 	zros_sub_fini(&ctx->sub_attitude_sp);
+#if !defined(CONFIG_CEREBRI_RDD2_PIPELINE)
 	zros_sub_fini(&ctx->sub_odometry_estimator);
+#endif
 	zros_sub_fini(&ctx->sub_angular_velocity_ff);
 	zros_pub_fini(&ctx->pub_angular_velocity_sp);
 	zros_node_fini(&ctx->node);
@@ -99,6 +117,133 @@ static void rdd2_attitude_fini(struct context *ctx)
 	LOG_INF("fini");
 }
 
+// compute the angular velocity setpoint, returns true if it was published
+static bool rdd2_attitude_update(struct context *ctx, const synapse_pb_Odometry *odometry)
+{
+	if (zros_sub_update_available(&ctx->sub_status)) {
+		zros_sub_update(&ctx->sub_status);
+	}
+
+	if (zros_sub_update_available(&ctx->sub_position_sp)) {
+		zros_sub_update(&ctx->sub_position_sp);
+	}
+
+	if (zros_sub_update_available(&ctx->sub_velocity_sp)) {
+		zros_sub_update(&ctx->sub_velocity_sp);
+	}
+
+	if (zros_sub_update_available(&ctx->sub_attitude_sp)) {
+		zros_sub_update(&ctx->sub_attitude_sp);
+	}
+
+	if (zros_sub_update_available(&ctx->sub_angular_velocity_ff)) {
+		zros_sub_update(&ctx->sub_angular_velocity_ff);
+	}
+
+	// attitude rate mode commands angular velocity directly
+	if (ctx->status.mode == synapse_pb_Status_Mode_MODE_ATTITUDE_RATE) {
+		return false;
+	}
+
+	double q_wb[4] = {odometry->pose.orientation.w, odometry->pose.orientation.x,
+			  odometry->pose.orientation.y, odometry->pose.orientation.z};
+
+	double q_r[4] = {ctx->attitude_sp.w, ctx->attitude_sp.x, ctx->attitude_sp.y,
+			 ctx->attitude_sp.z};
+
+	const double kp[3] = {
+		CONFIG_CEREBRI_RDD2_ROLL_KP * 1e-6,
+		CONFIG_CEREBRI_RDD2_PITCH_KP * 1e-6,
+		CONFIG_CEREBRI_RDD2_YAW_KP * 1e-6,
+	};
+
+	double omega[3];
+
+#if defined(CONFIG_CEREBRI_RDD2_LOG_LINEAR_ATTITUDE)
+	double zeta[9];
+	double p_w[3] = {odometry->pose.position.x, odometry->pose.position.y,
+			 odometry->pose.position.z};
+
+	double v_b[3] = {odometry->twist.linear.x, odometry->twist.linear.y,
+			 odometry->twist.linear.z};
+
+	double p_rw[3] = {ctx->position_sp.x, ctx->position_sp.y, ctx->position_sp.z};
+
+	double v_rw[3] = {ctx->velocity_sp.x, ctx->velocity_sp.y, ctx->velocity_sp.z};
+
+	// se23_error:(p_w[3],v_b[3],q_wb[4],p_rw[3],v_rw[3],q_r[4])->(zeta[9])
+
+	{
+		CASADI_FUNC_ARGS(se23_error);
+		args[0] = p_w;
+		args[1] = v_b;
+		args[2] = q_wb;
+		args[3] = p_rw;
+		args[4] = v_rw;
+		args[5] = q_r;
+		res[0] = zeta;
+		CASADI_FUNC_CALL(se23_error);
+	}
+
+	// se23_attitude_control:(kp[3],zeta[9])->(omega[3])
+	{
+		CASADI_FUNC_ARGS(so3_attitude_control);
+		args[0] = kp;
+		args[1] = q_wb;
+		args[2] = q_r;
+		res[0] = omega;
+		CASADI_FUNC_CALL(so3_attitude_control);
+	}
+#else
+	{
+		// attitude_control:(kp[3],q[4],q_r[4])->(omega[3])
+		CASADI_FUNC_ARGS(attitude_control);
+		args[0] = kp;
+		args[1] = q_wb;
+		args[2] = q_r;
+		res[0] = omega;
+		CASADI_FUNC_CALL(attitude_control);
+	}
+#endif
+
+	// publish
+	bool data_ok = true;
+	for (int i = 0; i < 3; i++) {
+		if (!isfinite(omega[i])) {
+			LOG_ERR("omega[0] not finite: %10.4f", omega[i]);
+			data_ok = false;
+		}
+	}
+
+	if (data_ok) {
+		ctx->angular_velocity_sp.x = omega[0] + ctx->angular_velocity_ff.x;
+		ctx->angular_velocity_sp.y = omega[1] + ctx->angular_velocity_ff.y;
+		ctx->angular_velocity_sp.z = omega[2] + ctx->angular_velocity_ff.z;
+		synapse_pub_update(&ctx->pub_angular_velocity_sp,
+				   SYNAPSE_TOPIC_angular_velocity_sp);
+	}
+	return data_ok;
+}
+
+#if defined(CONFIG_CEREBRI_RDD2_PIPELINE)
+
+void rdd2_attitude_pipeline_init(void)
+{
+	rdd2_attitude_init(&g_ctx);
+}
+
+void rdd2_attitude_pipeline_fini(void)
+{
+	rdd2_attitude_fini(&g_ctx);
+}
+
+const synapse_pb_Vector3 *rdd2_attitude_pipeline_step(const synapse_pb_Odometry *odometry)
+{
+	return rdd2_attitude_update(&g_ctx, odometry) ? &g_ctx.angular_velocity_sp : NULL;
+}
+
+#else
+
 static void rdd2_attitude_run(void *p0, void *p1, void *p2)
 {
 	struct context *ctx = p0;
@@ -118,114 +263,11 @@ static void rdd2_attitude_run(void *p0, void *p1, void *p2)
 			LOG_DBG("not receiving odometry_estimator");
 		}
 
-		if (zros_sub_update_available(&ctx->sub_status)) {
-			zros_sub_update(&ctx->sub_status);
-		}
-
 		if (zros_sub_update_available(&ctx->sub_odometry_estimator)) {
 			zros_sub_update(&ctx->sub_odometry_estimator);
 		}
 
-		if (zros_sub_update_available(&ctx->sub_position_sp)) {
-			zros_sub_update(&ctx->sub_position_sp);
-		}
-
-		if (zros_sub_update_available(&ctx->sub_velocity_sp)) {
-			zros_sub_update(&ctx->sub_velocity_sp);
-		}
-
-		if (zros_sub_update_available(&ctx->sub_attitude_sp)) {
-			zros_sub_update(&ctx->sub_attitude_sp);
-		}
-
-		if (zros_sub_update_available(&ctx->sub_angular_velocity_ff)) {
-			zros_sub_update(&ctx->sub_angular_velocity_ff);
-		}
-
-		if (ctx->status.mode != synapse_pb_Status_Mode_MODE_ATTITUDE_RATE) {
-			double q_wb[4] = {ctx->odometry_estimator.pose.orientation.w,
-					  ctx->odometry_estimator.pose.orientation.x,
-					  ctx->odometry_estimator.pose.orientation.y,
-					  ctx->odometry_estimator.pose.orientation.z};
-
-			double q_r[4] = {ctx->attitude_sp.w, ctx->attitude_sp.x, ctx->attitude_sp.y,
-					 ctx->attitude_sp.z};
-
-			const double kp[3] = {
-				CONFIG_CEREBRI_RDD2_ROLL_KP * 1e-6,
-				CONFIG_CEREBRI_RDD2_PITCH_KP * 1e-6,
-				CONFIG_CEREBRI_RDD2_YAW_KP * 1e-6,
-			};
-
-			double omega[3];
-
-#if defined(CONFIG_CEREBRI_RDD2_LOG_LINEAR_ATTITUDE)
-			double zeta[9];
-			double p_w[3] = {ctx->odometry_estimator.pose.position.x,
-					 ctx->odometry_estimator.pose.position.y,
-					 ctx->odometry_estimator.pose.position.z};
-
-			double v_b[3] = {ctx->odometry_estimator.twist.linear.x,
-					 ctx->odometry_estimator.twist.linear.y,
-					 ctx->odometry_estimator.twist.linear.z};
-
-			double p_rw[3] = {ctx->position_sp.x, ctx->position_sp.y,
-					  ctx->position_sp.z};
-
-			double v_rw[3] = {ctx->velocity_sp.x, ctx->velocity_sp.y,
-					  ctx->velocity_sp.z};
-
-			// se23_error:(p_w[3],v_b[3],q_wb[4],p_rw[3],v_rw[3],q_r[4])->(zeta[9])
-
-			{
-				CASADI_FUNC_ARGS(se23_error);
-				args[0] = p_w;
-				args[1] = v_b;
-				args[2] = q_wb;
-				args[3] = p_rw;
-				args[4] = v_rw;
-				args[5] = q_r;
-				res[0] = zeta;
-				CASADI_FUNC_CALL(se23_error);
-			}
-
-			// se23_attitude_control:(kp[3],zeta[9])->(omega[3])
-			{
-				CASADI_FUNC_ARGS(so3_attitude_control);
-				args[0] = kp;
-				args[1] = q_wb;
-				args[2] = q_r;
-				res[0] = omega;
-				CASADI_FUNC_CALL(so3_attitude_control);
-			}
-#else
-			{
-				// attitude_control:(kp[3],q[4],q_r[4])->(omega[3])
-				CASADI_FUNC_ARGS(attitude_control);
-				args[0] = kp;
-				args[1] = q_wb;
-				args[2] = q_r;
-				res[0] = omega;
-				CASADI_FUNC_CALL(attitude_control);
-			}
-#endif
-
-			// publish
-			bool data_ok = true;
-			for (int i = 0; i < 3; i++) {
-				if (!isfinite(omega[i])) {
-					LOG_ERR("omega[0] not finite: %10.4f", omega[i]);
-					data_ok = false;
-				}
-			}
-
-			if (data_ok) {
-				ctx->angular_velocity_sp.x = omega[0] + ctx->angular_velocity_ff.x;
-				ctx->angular_velocity_sp.y = omega[1] + ctx->angular_velocity_ff.y;
-				ctx->angular_velocity_sp.z = omega[2] + ctx->angular_velocity_ff.z;
-				zros_pub_update(&ctx->pub_angular_velocity_sp);
-			}
-		}
+		rdd2_attitude_update(ctx, &ctx->odometry_estimator);
 	}
 
 	rdd2_attitude_fini(ctx);
@@ -276,4 +318,6 @@ static int rdd2_attitude_sys_init(void)
 
 SYS_INIT(rdd2_attitude_sys_init, APPLICATION, 1);
 
+#endif // CONFIG_CEREBRI_RDD2_PIPELINE
+
 // vi: ts=4 sw=4 et
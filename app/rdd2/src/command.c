@@ -17,6 +17,7 @@
 #include <zros/zros_sub.h>
 
 #include <synapse_topic_list.h>
+#include <synapse_trajectory.h>
 
 #include <cerebri/core/casadi.h>
 
@@ -26,7 +27,7 @@
 
 #include "input_mapping.h"
 
-#define MY_STACK_SIZE 8192
+#define MY_STACK_SIZE 4096
 #define MY_PRIORITY   4
 
 #ifndef M_PI
@@ -36,6 +37,13 @@
 LOG_MODULE_REGISTER(rdd2_command, CONFIG_CEREBRI_RDD2_LOG_LEVEL);
 
 static K_THREAD_STACK_DEFINE(g_my_stack_area, MY_STACK_SIZE);
+
+CASADI_FUNC_DEFINE(joy_acro);
+CASADI_FUNC_DEFINE(joy_auto_level);
+CASADI_FUNC_DEFINE(quat_to_eulerB321);
+CASADI_FUNC_DEFINE(eulerB321_to_quat);
+CASADI_FUNC_DEFINE(bezier_multirotor);
+CASADI_FUNC_DEFINE(f_ref);
 static const double deg2rad = M_PI / 180.0;
 static const double thrust_trim = CONFIG_CEREBRI_RDD2_THRUST_TRIM * 1e-3;
 static const double thrust_delta = CONFIG_CEREBRI_RDD2_THRUST_DELTA * 1e-3;
@@ -46,15 +54,14 @@ struct context {
 	synapse_pb_Vector3 angular_velocity_ff, force_sp, accel_ff, moment_ff, velocity_sp,
 		position_sp;
 	synapse_pb_Quaternion attitude_sp, orientation_sp;
-	synapse_pb_BezierTrajectory bezier_trajectory;
+	struct synapse_trajectory trajectory;
 	synapse_pb_ClockOffset clock_offset;
 	synapse_pb_Status status;
 	synapse_pb_Status last_status;
 	synapse_pb_Odometry odometry_estimator;
 	synapse_pb_Twist cmd_vel;
-	struct zros_sub sub_bezier_trajectory_ethernet, sub_status, sub_input_ethernet,
-		sub_input_sbus, sub_odometry_estimator, sub_cmd_vel_ethernet,
-		sub_clock_offset_ethernet;
+	struct zros_sub sub_status, sub_input_ethernet, sub_input_sbus, sub_odometry_estimator,
+		sub_cmd_vel_ethernet, sub_clock_offset_ethernet;
 	struct zros_pub pub_attitude_sp, pub_angular_velocity_ff, pub_force_sp, pub_accel_ff,
 		pub_moment_ff, pub_velocity_sp, pub_orientation_sp, pub_position_sp, pub_input;
 	struct k_sem running;
@@ -70,7 +77,7 @@ static struct context g_ctx = {
 	.attitude_sp = synapse_pb_Quaternion_init_default,
 	.angular_velocity_ff = synapse_pb_Vector3_init_default,
 	.force_sp = synapse_pb_Vector3_init_default,
-	.bezier_trajectory = synapse_pb_BezierTrajectory_init_default,
+	.trajectory = {},
 	.status = synapse_pb_Status_init_default,
 	.last_status = synapse_pb_Status_init_default,
 	.velocity_sp = synapse_pb_Vector3_init_default,
@@ -82,7 +89,6 @@ static struct context g_ctx = {
 	.sub_input_ethernet = {},
 	.sub_input_sbus = {},
 	.sub_status = {},
-	.sub_bezier_trajectory_ethernet = {},
 	.sub_clock_offset_ethernet = {},
 	.sub_odometry_estimator = {},
 	.sub_cmd_vel_ethernet = {},
@@ -109,8 +115,6 @@ static void rdd2_command_init(struct context *ctx)
 		      200);
 	zros_sub_init(&ctx->sub_input_sbus, &ctx->node, &topic_input_sbus, &ctx->input, 200);
 	zros_sub_init(&ctx->sub_status, &ctx->node, &topic_status, &ctx->status, 10);
-	zros_sub_init(&ctx->sub_bezier_trajectory_ethernet, &ctx->node,
-		      &topic_bezier_trajectory_ethernet, &ctx->bezier_trajectory, 10);
 	zros_sub_init(&ctx->sub_clock_offset_ethernet, &ctx->node, &topic_clock_offset_ethernet,
 		      &ctx->clock_offset, 10);
 	zros_sub_init(&ctx->sub_odometry_estimator, &ctx->node, &topic_odometry_estimator,
@@ -128,6 +132,7 @@ static void rdd2_command_init(struct context *ctx)
 		      &ctx->orientation_sp);
 	zros_pub_init(&ctx->pub_position_sp, &ctx->node, &topic_position_sp, &ctx->position_sp);
 	zros_pub_init(&ctx->pub_input, &ctx->node, &topic_input, &ctx->input);
+	synapse_trajectory_init(&ctx->trajectory);
 	k_sem_take(&ctx->running, K_FOREVER);
 	LOG_INF("init");
 }
@@ -137,7 +142,6 @@ static void rdd2_command_fini(struct context *ctx)
 	zros_sub_fini(&ctx->sub_input_ethernet);
 	zros_sub_fini(&ctx->sub_input_sbus);
 	zros_sub_fini(&ctx->sub_status);
-	zros_sub_fini(&ctx->sub_bezier_trajectory_ethernet);
 	zros_sub_fini(&ctx->sub_odometry_estimator);
 	zros_sub_fini(&ctx->sub_cmd_vel_ethernet);
 	zros_pub_fini(&ctx->pub_attitude_sp);
@@ -164,7 +168,7 @@ static void rdd2_command_run(void *p0, void *p1, void *p2)
 		*zros_sub_get_event(&ctx->sub_input_ethernet),
 		*zros_sub_get_event(&ctx->sub_input_sbus),
 		*zros_sub_get_event(&ctx->sub_cmd_vel_ethernet),
-		*zros_sub_get_event(&ctx->sub_bezier_trajectory_ethernet),
+		synapse_trajectory_event(),
 	};
 
 	double dt = 0;
@@ -199,18 +203,20 @@ static void rdd2_command_run(void *p0, void *p1, void *p2)
 		// prioritize onboard sbus input
 		if (zros_sub_update_available(&ctx->sub_input_sbus)) {
 			zros_sub_update(&ctx->sub_input_sbus);
-			zros_pub_update(&ctx->pub_input);
+			synapse_pub_update(&ctx->pub_input, SYNAPSE_TOPIC_input);
 			ctx->status.input_source =
 				synapse_pb_Status_InputSource_INPUT_SOURCE_RADIO_CONTROL;
 		} else if (zros_sub_update_available(&ctx->sub_input_ethernet)) {
 			zros_sub_update(&ctx->sub_input_ethernet);
-			zros_pub_update(&ctx->pub_input);
+			synapse_pub_update(&ctx->pub_input, SYNAPSE_TOPIC_input);
 			ctx->status.input_source =
 				synapse_pb_Status_InputSource_INPUT_SOURCE_ETHERNET;
 		}
 
-		if (zros_sub_update_available(&ctx->sub_bezier_trajectory_ethernet)) {
-			zros_sub_update(&ctx->sub_bezier_trajectory_ethernet);
+		int64_t traj_time_nsec = k_ticks_to_ns_floor64(k_uptime_ticks()) +
+					 timestamp_to_ns(&ctx->clock_offset.offset);
+		if (synapse_trajectory_update(&ctx->trajectory, traj_time_nsec) < 0) {
+			LOG_ERR("bezier trajectory chunk rejected");
 		}
 
 		if (zros_sub_update_available(&ctx->sub_odometry_estimator)) {
@@ -281,11 +287,12 @@ static void rdd2_command_run(void *p0, void *p1, void *p2)
 				ctx->angular_velocity_ff.x = omega[0];
 				ctx->angular_velocity_ff.y = omega[1];
 				ctx->angular_velocity_ff.z = omega[2];
-				zros_pub_update(&ctx->pub_angular_velocity_ff);
+				synapse_pub_update(&ctx->pub_angular_velocity_ff,
+						   SYNAPSE_TOPIC_angular_velocity_sp);
 
 				// thrust pass through
 				ctx->force_sp.z = thrust;
-				zros_pub_update(&ctx->pub_force_sp);
+				synapse_pub_update(&ctx->pub_force_sp, SYNAPSE_TOPIC_force_sp);
 			}
 
 		} else if (ctx->status.mode == synapse_pb_Status_Mode_MODE_ATTITUDE) {
@@ -329,11 +336,12 @@ static void rdd2_command_run(void *p0, void *p1, void *p2)
 				ctx->attitude_sp.x = qr[1];
 				ctx->attitude_sp.y = qr[2];
 				ctx->attitude_sp.z = qr[3];
-				zros_pub_update(&ctx->pub_attitude_sp);
+				synapse_pub_update(&ctx->pub_attitude_sp,
+						   SYNAPSE_TOPIC_attitude_sp);
 
 				// thrust pass through
 				ctx->force_sp.z = thrust;
-				zros_pub_update(&ctx->pub_force_sp);
+				synapse_pub_update(&ctx->pub_force_sp, SYNAPSE_TOPIC_force_sp);
 			}
 
 		} else if (ctx->status.mode == synapse_pb_Status_Mode_MODE_VELOCITY) {
@@ -434,97 +442,58 @@ static void rdd2_command_run(void *p0, void *p1, void *p2)
 			}
 
 			// position setpoint
-			zros_pub_update(&ctx->pub_position_sp);
+			synapse_pub_update(&ctx->pub_position_sp, SYNAPSE_TOPIC_position_sp);
 
 			// velocity setpoint
 			ctx->velocity_sp.x = vw[0];
 			ctx->velocity_sp.y = vw[1];
 			ctx->velocity_sp.z = vw[2];
-			zros_pub_update(&ctx->pub_velocity_sp);
+			synapse_pub_update(&ctx->pub_velocity_sp, SYNAPSE_TOPIC_velocity_sp);
 
 			// orientation setpoint
 			ctx->orientation_sp.w = qc[0];
 			ctx->orientation_sp.x = qc[1];
 			ctx->orientation_sp.y = qc[2];
 			ctx->orientation_sp.z = qc[3];
-			zros_pub_update(&ctx->pub_orientation_sp);
+			synapse_pub_update(&ctx->pub_orientation_sp, SYNAPSE_TOPIC_orientation_sp);
 
 			// acceleration setpoint
 			ctx->accel_ff.x = 0;
 			ctx->accel_ff.y = 0;
 			ctx->accel_ff.z = 0;
-			zros_pub_update(&ctx->pub_accel_ff);
+			synapse_pub_update(&ctx->pub_accel_ff, SYNAPSE_TOPIC_accel_sp);
 
 		} else if (ctx->status.mode == synapse_pb_Status_Mode_MODE_BEZIER) {
-			// goal -> given position goal, find cmd_vel
-			uint64_t time_start_nsec =
-				(ctx->bezier_trajectory.time_start.seconds * 1e9 +
-				 ctx->bezier_trajectory.time_start.nanos);
-			uint64_t time_stop_nsec = time_start_nsec;
-
 			// get current time
-			uint64_t time_nsec =
-				(k_uptime_get() * 1e6 + ctx->clock_offset.offset.seconds * 1e9 +
-				 ctx->clock_offset.offset.nanos);
-
-			if (time_nsec < time_start_nsec) {
-				LOG_DBG("time current: %" PRIu64 " ns < time start: %" PRIu64
+			int64_t time_nsec = k_ticks_to_ns_floor64(k_uptime_ticks()) +
+					    timestamp_to_ns(&ctx->clock_offset.offset);
+
+			// find current trajectory index, time and duration of the curve
+			double t, T;
+			int curve_index =
+				synapse_trajectory_find(&ctx->trajectory, time_nsec, &t, &T);
+			if (curve_index == -EAGAIN) {
+				LOG_DBG("time current: %" PRId64 " ns < time start: %" PRId64
 					"  ns, time out of range of trajectory\n",
-					time_nsec, time_start_nsec);
+					time_nsec, synapse_trajectory_time_start(&ctx->trajectory));
 				// stop(ctx);
 				continue;
 			}
 
-			// find current trajectory index, time_start, and time_stop
-			int curve_index = 0;
-
-			while (true) {
-
-				synapse_pb_BezierTrajectory_Curve *curve =
-					&ctx->bezier_trajectory.curves[curve_index];
-				synapse_pb_BezierTrajectory_Curve *curve_prev =
-					&ctx->bezier_trajectory.curves[curve_index - 1];
-
-				uint64_t curve_stop_nsec =
-					curve->time_stop.seconds * 1e9 + curve->time_stop.nanos;
-				uint64_t curve_stop_prev_nsec =
-					curve_prev->time_stop.seconds * 1e9 +
-					curve_prev->time_stop.nanos;
-
-				// check if time handled by current trajectory
-				if (time_nsec < curve_stop_nsec) {
-					time_stop_nsec = curve_stop_nsec;
-					if (curve_index > 0) {
-						time_start_nsec = curve_stop_prev_nsec;
-					}
-					break;
-				}
-
-				// next index
-				curve_index++;
-
-				// check if index exceeds bounds
-				if (curve_index >= ctx->bezier_trajectory.curves_count) {
-					// LOG_DBG("curve index exceeds bounds");
-					// stop(ctx);
-					break;
-				}
-			}
-
-			if (curve_index < ctx->bezier_trajectory.curves_count) {
-				double T = (time_stop_nsec - time_start_nsec) * 1e-9;
-				double t = (time_nsec - time_start_nsec) * 1e-9;
+			if (curve_index >= 0) {
 				double x, y, z, psi, dpsi, ddpsi = 0;
 				double v[3], a[3], j[3], s[3];
 				double PX[8], PY[8], PZ[8], Ppsi[4];
+				const synapse_pb_BezierTrajectory_Curve *curve =
+					synapse_trajectory_curve(&ctx->trajectory, curve_index);
 				for (int i = 0; i < 8; i++) {
-					PX[i] = ctx->bezier_trajectory.curves[curve_index].x[i];
-					PY[i] = ctx->bezier_trajectory.curves[curve_index].y[i];
-					PZ[i] = ctx->bezier_trajectory.curves[curve_index].z[i];
+					PX[i] = curve->x[i];
+					PY[i] = curve->y[i];
+					PZ[i] = curve->z[i];
 				}
 
 				for (int i = 0; i < 4; i++) {
-					Ppsi[i] = ctx->bezier_trajectory.curves[curve_index].yaw[i];
+					Ppsi[i] = curve->yaw[i];
 				}
 
 				// bezier_multirotor:(t,T,PX[1x8],PY[1x8],PX[1x8],Ppsi[1x4])
@@ -587,19 +556,21 @@ static void rdd2_command_run(void *p0, void *p1, void *p2)
 				ctx->position_sp.x = x;
 				ctx->position_sp.y = y;
 				ctx->position_sp.z = z;
-				zros_pub_update(&ctx->pub_position_sp);
+				synapse_pub_update(&ctx->pub_position_sp,
+						   SYNAPSE_TOPIC_position_sp);
 
 				// velocity sp
 				ctx->velocity_sp.x = v[0];
 				ctx->velocity_sp.y = v[1];
 				ctx->velocity_sp.z = v[2];
-				zros_pub_update(&ctx->pub_velocity_sp);
+				synapse_pub_update(&ctx->pub_velocity_sp,
+						   SYNAPSE_TOPIC_velocity_sp);
 
 				// acceleration ff
 				ctx->accel_ff.x = a[0];
 				ctx->accel_ff.y = a[1];
 				ctx->accel_ff.z = a[2];
-				zros_pub_update(&ctx->pub_accel_ff);
+				synapse_pub_update(&ctx->pub_accel_ff, SYNAPSE_TOPIC_accel_sp);
 
 				// attitude sp
 				// ctx->attitude_sp.w = q_att[0];
@@ -611,20 +582,22 @@ static void rdd2_command_run(void *p0, void *p1, void *p2)
 				ctx->angular_velocity_ff.x = omega[0];
 				ctx->angular_velocity_ff.y = omega[1];
 				ctx->angular_velocity_ff.z = omega[2];
-				zros_pub_update(&ctx->pub_angular_velocity_ff);
+				synapse_pub_update(&ctx->pub_angular_velocity_ff,
+						   SYNAPSE_TOPIC_angular_velocity_sp);
 
 				// moment ff
 				ctx->moment_ff.x = 0; // M[0];
 				ctx->moment_ff.y = 0; // M[1];
 				ctx->moment_ff.z = 0; // M[2];
-				zros_pub_update(&ctx->pub_moment_ff);
+				synapse_pub_update(&ctx->pub_moment_ff, SYNAPSE_TOPIC_moment_ff);
 
 				// orientation sp
 				ctx->orientation_sp.w = q_orientation[0];
 				ctx->orientation_sp.x = q_orientation[1];
 				ctx->orientation_sp.y = q_orientation[2];
 				ctx->orientation_sp.z = q_orientation[3];
-				zros_pub_update(&ctx->pub_orientation_sp);
+				synapse_pub_update(&ctx->pub_orientation_sp,
+						   SYNAPSE_TOPIC_orientation_sp);
 			}
 
 		} else if (ctx->status.mode == synapse_pb_Status_Mode_MODE_UNKNOWN) {
@@ -663,6 +636,9 @@ static int rdd2_command_cmd_handler(const struct shell *sh, size_t argc, char **
 		}
 	} else if (strcmp(argv[0], "status") == 0) {
 		shell_print(sh, "running: %d", (int)k_sem_count_get(&g_ctx.running) == 0);
+		shell_print(sh, "trajectory chunks: %u dropped: %u pending: %d",
+			    ctx->trajectory.chunks, ctx->trajectory.dropped,
+			    ctx->trajectory.pending);
 	}
 	return 0;
 }
@@ -5,6 +5,7 @@
 
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 
 #include <zephyr/kernel.h>
@@ -25,17 +26,30 @@
 #include <cerebri/core/casadi.h>
 
 #include "app/rdd2/casadi/rdd2.h"
+#include "pipeline.h"
 
 #define MY_STACK_SIZE 4096
 #define MY_PRIORITY   4
 
+// imu sample period, the first sample has no previous one to measure dt from
+#define IMU_PERIOD_S 0.005
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
 LOG_MODULE_REGISTER(rdd2_estimate, CONFIG_CEREBRI_RDD2_LOG_LEVEL);
 
+#if defined(CONFIG_CEREBRI_RDD2_ESTIMATE_ALTIMETER)
+// altimeter older than this no longer corrects the altitude
+#define ALTIMETER_MAX_AGE_MS 500
+#endif
+
+#if !defined(CONFIG_CEREBRI_RDD2_PIPELINE)
 static K_THREAD_STACK_DEFINE(g_my_stack_area, MY_STACK_SIZE);
+#endif
+
+CASADI_FUNC_DEFINE(strapdown_ins_propagate);
 
 // private context
 struct context {
@@ -43,9 +57,13 @@ struct context {
 	synapse_pb_Odometry odometry_ethernet;
 	synapse_pb_Imu imu;
 	synapse_pb_Odometry odometry;
-	struct zros_sub sub_odometry_ethernet, sub_imu;
+	synapse_pb_Altimeter altimeter;
+	struct zros_sub sub_odometry_ethernet, sub_imu, sub_altimeter;
 	struct zros_pub pub_odometry;
-	double x[3];
+	double x[10];
+	int64_t ticks_last;
+	bool ticks_valid;
+	int64_t ticks_altimeter;
 	struct k_sem running;
 	size_t stack_size;
 	k_thread_stack_t *stack_area;
@@ -72,12 +90,19 @@ static struct context g_ctx = {
 			.twist.has_linear = true,
 		},
 	.sub_odometry_ethernet = {},
+	.altimeter = synapse_pb_Altimeter_init_default,
 	.sub_imu = {},
+	.sub_altimeter = {},
 	.pub_odometry = {},
 	.x = {},
+	.ticks_last = 0,
+	.ticks_valid = false,
+	.ticks_altimeter = 0,
 	.running = Z_SEM_INITIALIZER(g_ctx.running, 1, 1),
+#if !defined(CONFIG_CEREBRI_RDD2_PIPELINE)
 	.stack_size = MY_STACK_SIZE,
 	.stack_area = g_my_stack_area,
+#endif
 	.thread_data = {},
 	.perf = {},
 };
@@ -85,25 +110,198 @@ static struct context g_ctx = {
 static void rdd2_estimate_init(struct context *ctx)
 {
 	zros_node_init(&ctx->node, "rdd2_estimate");
+#if !defined(CONFIG_CEREBRI_RDD2_PIPELINE)
+	// the control pipeline owns the imu subscription when enabled
 	zros_sub_init(&ctx->sub_imu, &ctx->node, &topic_imu, &ctx->imu, 300);
+	perf_counter_init(&ctx->perf, "estimator imu", 1.0 / 100);
+#endif
 	zros_sub_init(&ctx->sub_odometry_ethernet, &ctx->node, &topic_odometry_ethernet,
 		      &ctx->odometry_ethernet, 10);
+#if defined(CONFIG_CEREBRI_RDD2_ESTIMATE_ALTIMETER)
+	zros_sub_init(&ctx->sub_altimeter, &ctx->node, &topic_altimeter, &ctx->altimeter, 20);
+#endif
 	zros_pub_init(&ctx->pub_odometry, &ctx->node, &topic_odometry_estimator, &ctx->odometry);
-	perf_counter_init(&ctx->perf, "estimator imu", 1.0 / 100);
+
+	// estimator states, at rest at the origin
+	const double x0[10] = {0, 0, 0, 0, 0, 0, 1, 0, 0, 0};
+	memcpy(ctx->x, x0, sizeof(x0));
+	ctx->ticks_last = 0;
+	ctx->ticks_valid = false;
+	ctx->ticks_altimeter = 0;
+
 	k_sem_take(&ctx->running, K_FOREVER);
 	LOG_INF("init");
 }
 
 static void rdd2_estimate_fini(struct context *ctx)
 {
+#if !defined(CONFIG_CEREBRI_RDD2_PIPELINE)
 	zros_sub_fini(&ctx->sub_imu);
+	perf_counter_fini(&ctx->perf);
+#endif
 	zros_sub_fini(&ctx->sub_odometry_ethernet);
+#if defined(CONFIG_CEREBRI_RDD2_ESTIMATE_ALTIMETER)
+	zros_sub_fini(&ctx->sub_altimeter);
+#endif
 	zros_pub_fini(&ctx->pub_odometry);
 	zros_node_fini(&ctx->node);
 	k_sem_give(&ctx->running);
 	LOG_INF("fini");
 }
 
+#if defined(CONFIG_CEREBRI_RDD2_ESTIMATE_ALTIMETER)
+// second order complementary filter, the strapdown integrates the accelerometer and the last
+// altimeter sample pulls altitude and vertical velocity, held between altimeter updates
+static void rdd2_estimate_correct_altitude(struct context *ctx, double dt, int64_t ticks_now)
+{
+	const double omega = 1e3 / CONFIG_CEREBRI_RDD2_ESTIMATE_ALTIMETER_TAU_MS;
+	double *x = ctx->x;
+
+	if (zros_sub_update_available(&ctx->sub_altimeter)) {
+		zros_sub_update(&ctx->sub_altimeter);
+		ctx->ticks_altimeter = ticks_now;
+	}
+
+	if (ctx->ticks_altimeter == 0 ||
+	    ticks_now - ctx->ticks_altimeter > k_ms_to_ticks_ceil64(ALTIMETER_MAX_AGE_MS)) {
+		return;
+	}
+
+	// the estimate starts at zero altitude, the altimeter reference is the first sample
+	double e = ctx->altimeter.vertical_position - ctx->altimeter.vertical_reference - x[2];
+	x[2] += 2 * omega * e * dt;
+	x[5] += omega * omega * e * dt;
+}
+#endif
+
+// propagate the estimate with one imu sample, returns true if odometry was published
+static bool rdd2_estimate_update(struct context *ctx, const synapse_pb_Imu *imu)
+{
+	double *x = ctx->x;
+
+	if (zros_sub_update_available(&ctx->sub_odometry_ethernet)) {
+		// LOG_INF("correct offboard odometry");
+		zros_sub_update(&ctx->sub_odometry_ethernet);
+
+#if defined(CONFIG_CEREBRI_RDD2_ESTIMATE_ODOMETRY_ETHERNET)
+		__ASSERT(fabs((ctx->odometry_ethernet.pose.orientation.w *
+				       ctx->odometry_ethernet.pose.orientation.w +
+			       ctx->odometry_ethernet.pose.orientation.x *
+				       ctx->odometry_ethernet.pose.orientation.x +
+			       ctx->odometry_ethernet.pose.orientation.y *
+				       ctx->odometry_ethernet.pose.orientation.y +
+			       ctx->odometry_ethernet.pose.orientation.z *
+				       ctx->odometry_ethernet.pose.orientation.z) -
+			      1) < 1e-2,
+			 "quaternion normal error");
+
+		// use offboard odometry to reset position
+		x[0] = ctx->odometry_ethernet.pose.position.x;
+		x[1] = ctx->odometry_ethernet.pose.position.y;
+		x[2] = ctx->odometry_ethernet.pose.position.z;
+
+		// use offboard odometry to reset velocity
+		x[3] = ctx->odometry_ethernet.twist.linear.x;
+		x[4] = ctx->odometry_ethernet.twist.linear.y;
+		x[5] = ctx->odometry_ethernet.twist.linear.z;
+
+		// use offboard odometry to reset orientation
+		x[6] = ctx->odometry_ethernet.pose.orientation.w;
+		x[7] = ctx->odometry_ethernet.pose.orientation.x;
+		x[8] = ctx->odometry_ethernet.pose.orientation.y;
+		x[9] = ctx->odometry_ethernet.pose.orientation.z;
+#endif
+	}
+
+	// calculate dt, nominal for the first sample
+	int64_t ticks_now = k_uptime_ticks();
+	double dt = IMU_PERIOD_S;
+	if (ctx->ticks_valid) {
+		dt = (double)(ticks_now - ctx->ticks_last) / CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+	}
+	ctx->ticks_last = ticks_now;
+	ctx->ticks_valid = true;
+	if (dt <= 0 || dt > 0.5) {
+		LOG_WRN("imu update rate too low");
+		return false;
+	}
+
+	{
+		CASADI_FUNC_ARGS(strapdown_ins_propagate)
+		/* strapdown_ins_propagate:(x0[10],a_b[3],omega_b[3],g,dt)->(x1[10]) */
+		const double g = 9.8;
+		double a_b[3] = {imu->linear_acceleration.x, imu->linear_acceleration.y,
+				 imu->linear_acceleration.z};
+		double omega_b[3] = {imu->angular_velocity.x, imu->angular_velocity.y,
+				     imu->angular_velocity.z};
+		args[0] = x;
+		args[1] = a_b;
+		args[2] = omega_b;
+		args[3] = &g;
+		args[4] = &dt;
+		res[0] = x;
+		CASADI_FUNC_CALL(strapdown_ins_propagate)
+	}
+
+#if defined(CONFIG_CEREBRI_RDD2_ESTIMATE_ALTIMETER)
+	rdd2_estimate_correct_altitude(ctx, dt, ticks_now);
+#endif
+
+	for (int i = 0; i < 10; i++) {
+		if (!isfinite(x[i])) {
+			LOG_ERR("x[%d] is not finite", i);
+			// TODO reinitialize
+			x[i] = 0;
+			return false;
+		}
+	}
+
+	// publish odometry
+	stamp_msg(&ctx->odometry.stamp, k_uptime_ticks());
+	ctx->odometry.pose.position.x = x[0];
+	ctx->odometry.pose.position.y = x[1];
+	ctx->odometry.pose.position.z = x[2];
+	ctx->odometry.twist.linear.x = x[3];
+	ctx->odometry.twist.linear.y = x[4];
+	ctx->odometry.twist.linear.z = x[5];
+	ctx->odometry.pose.orientation.w = x[6];
+	ctx->odometry.pose.orientation.x = x[7];
+	ctx->odometry.pose.orientation.y = x[8];
+	ctx->odometry.pose.orientation.z = x[9];
+	ctx->odometry.twist.angular.x = imu->angular_velocity.x;
+	ctx->odometry.twist.angular.y = imu->angular_velocity.y;
+	ctx->odometry.twist.angular.z = imu->angular_velocity.z;
+
+	// check quaternion normal
+	__ASSERT(fabs((ctx->odometry.pose.orientation.w * ctx->odometry.pose.orientation.w +
+		       ctx->odometry.pose.orientation.x * ctx->odometry.pose.orientation.x +
+		       ctx->odometry.pose.orientation.y * ctx->odometry.pose.orientation.y +
+		       ctx->odometry.pose.orientation.z * ctx->odometry.pose.orientation.z) -
+		      1) < 1e-2,
+		 "quaternion normal error");
+	synapse_pub_update(&ctx->pub_odometry, SYNAPSE_TOPIC_odometry_estimator);
+	return true;
+}
+
+#if defined(CONFIG_CEREBRI_RDD2_PIPELINE)
+
+void rdd2_estimate_pipeline_init(void)
+{
+	rdd2_estimate_init(&g_ctx);
+}
+
+void rdd2_estimate_pipeline_fini(void)
+{
+	rdd2_estimate_fini(&g_ctx);
+}
+
+const synapse_pb_Odometry *rdd2_estimate_pipeline_step(const synapse_pb_Imu *imu)
+{
+	return rdd2_estimate_update(&g_ctx, imu) ? &g_ctx.odometry : NULL;
+}
+
+#else
+
 static void rdd2_estimate_run(void *p0, void *p1, void *p2)
 {
 	struct context *ctx = p0;
@@ -130,21 +328,11 @@ static void rdd2_estimate_run(void *p0, void *p1, void *p2)
 		zros_sub_update(&ctx->sub_imu);
 	}
 
-	double dt = 0;
-	int64_t ticks_last = k_uptime_ticks();
-
-	// estimator states
-	double x[10] = {0, 0, 0, 0, 0, 0, 1, 0, 0, 0};
-
 	// poll on imu
 	events[0] = *zros_sub_get_event(&ctx->sub_imu);
 
-	// int j = 0;
-
 	while (k_sem_take(&ctx->running, K_NO_WAIT) < 0) {
 
-		// j += 1;
-
 		// poll for imu
 		rc = k_poll(events, ARRAY_SIZE(events), K_MSEC(1000));
 		if (rc != 0) {
@@ -157,122 +345,7 @@ static void rdd2_estimate_run(void *p0, void *p1, void *p2)
 			perf_counter_update(&ctx->perf);
 		}
 
-		/*
-		if (j % 100 == 0) {
-		    int offset = 0;
-		    static char buf[1024];
-		    int n = 1024;
-		    offset += snprintf(buf + offset, n - offset, "x: ");
-		    for (int i=0; i<10;i++) {
-			offset += snprintf(buf + offset, n - offset, " %6.2f", x[i]);
-		    }
-		    LOG_INF("%s", buf);
-		}
-		*/
-
-		if (zros_sub_update_available(&ctx->sub_odometry_ethernet)) {
-			// LOG_INF("correct offboard odometry");
-			zros_sub_update(&ctx->sub_odometry_ethernet);
-
-#if defined(CONFIG_CEREBRI_RDD2_ESTIMATE_ODOMETRY_ETHERNET)
-			__ASSERT(fabs((ctx->odometry_ethernet.pose.orientation.w *
-					       ctx->odometry_ethernet.pose.orientation.w +
-				       ctx->odometry_ethernet.pose.orientation.x *
-					       ctx->odometry_ethernet.pose.orientation.x +
-				       ctx->odometry_ethernet.pose.orientation.y *
-					       ctx->odometry_ethernet.pose.orientation.y +
-				       ctx->odometry_ethernet.pose.orientation.z *
-					       ctx->odometry_ethernet.pose.orientation.z) -
-				      1) < 1e-2,
-				 "quaternion normal error");
-
-			// use offboard odometry to reset position
-			x[0] = ctx->odometry_ethernet.pose.position.x;
-			x[1] = ctx->odometry_ethernet.pose.position.y;
-			x[2] = ctx->odometry_ethernet.pose.position.z;
-
-			// use offboard odometry to reset velocity
-			x[3] = ctx->odometry_ethernet.twist.linear.x;
-			x[4] = ctx->odometry_ethernet.twist.linear.y;
-			x[5] = ctx->odometry_ethernet.twist.linear.z;
-
-			// use offboard odometry to reset orientation
-			x[6] = ctx->odometry_ethernet.pose.orientation.w;
-			x[7] = ctx->odometry_ethernet.pose.orientation.x;
-			x[8] = ctx->odometry_ethernet.pose.orientation.y;
-			x[9] = ctx->odometry_ethernet.pose.orientation.z;
-#endif
-		}
-
-		// calculate dt
-		int64_t ticks_now = k_uptime_ticks();
-		dt = (double)(ticks_now - ticks_last) / CONFIG_SYS_CLOCK_TICKS_PER_SEC;
-		ticks_last = ticks_now;
-		if (dt <= 0 || dt > 0.5) {
-			LOG_WRN("imu update rate too low");
-			continue;
-		}
-
-		{
-			CASADI_FUNC_ARGS(strapdown_ins_propagate)
-			/* strapdown_ins_propagate:(x0[10],a_b[3],omega_b[3],g,dt)->(x1[10]) */
-			const double g = 9.8;
-			double a_b[3] = {ctx->imu.linear_acceleration.x,
-					 ctx->imu.linear_acceleration.y,
-					 ctx->imu.linear_acceleration.z};
-			double omega_b[3] = {ctx->imu.angular_velocity.x,
-					     ctx->imu.angular_velocity.y,
-					     ctx->imu.angular_velocity.z};
-			args[0] = x;
-			args[1] = a_b;
-			args[2] = omega_b;
-			args[3] = &g;
-			args[4] = &dt;
-			res[0] = x;
-			CASADI_FUNC_CALL(strapdown_ins_propagate)
-		}
-
-		bool data_ok = true;
-		for (int i = 0; i < 10; i++) {
-			if (!isfinite(x[i])) {
-				LOG_ERR("x[%d] is not finite", i);
-				// TODO reinitialize
-				x[i] = 0;
-				data_ok = false;
-				break;
-			}
-		}
-
-		// publish odometry
-		if (data_ok) {
-			stamp_msg(&ctx->odometry.stamp, k_uptime_ticks());
-			ctx->odometry.pose.position.x = x[0];
-			ctx->odometry.pose.position.y = x[1];
-			ctx->odometry.pose.position.z = x[2];
-			ctx->odometry.twist.linear.x = x[3];
-			ctx->odometry.twist.linear.y = x[4];
-			ctx->odometry.twist.linear.z = x[5];
-			ctx->odometry.pose.orientation.w = x[6];
-			ctx->odometry.pose.orientation.x = x[7];
-			ctx->odometry.pose.orientation.y = x[8];
-			ctx->odometry.pose.orientation.z = x[9];
-			ctx->odometry.twist.angular.x = ctx->imu.angular_velocity.x;
-			ctx->odometry.twist.angular.y = ctx->imu.angular_velocity.y;
-			ctx->odometry.twist.angular.z = ctx->imu.angular_velocity.z;
-
-			// check quaternion normal
-			__ASSERT(fabs((ctx->odometry.pose.orientation.w *
-					       ctx->odometry.pose.orientation.w +
-				       ctx->odometry.pose.orientation.x *
-					       ctx->odometry.pose.orientation.x +
-				       ctx->odometry.pose.orientation.y *
-					       ctx->odometry.pose.orientation.y +
-				       ctx->odometry.pose.orientation.z *
-					       ctx->odometry.pose.orientation.z) -
-				      1) < 1e-2,
-				 "quaternion normal error");
-			zros_pub_update(&ctx->pub_odometry);
-		}
+		rdd2_estimate_update(ctx, &ctx->imu);
 	}
 
 	rdd2_estimate_fini(ctx);
@@ -323,4 +396,6 @@ static int rdd2_estimate_sys_init(void)
 
 SYS_INIT(rdd2_estimate_sys_init, APPLICATION, 1);
 
+#endif // CONFIG_CEREBRI_RDD2_PIPELINE
+
 // vi: ts=4 sw=4 et
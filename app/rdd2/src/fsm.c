@@ -380,7 +380,7 @@ static void rdd2_fsm_run(void *p0, void *p1, void *p2)
 		fsm_compute_input(&ctx->status_input, ctx);
 		fsm_update(&ctx->status, &ctx->status_input);
 		status_add_extra_info(&ctx->status, &ctx->status_input, ctx);
-		zros_pub_update(&ctx->pub_status);
+		synapse_pub_update(&ctx->pub_status, SYNAPSE_TOPIC_status);
 	}
 
 	rdd2_fsm_fini(ctx);
@@ -207,7 +207,7 @@ static void rdd2_lighting_run(void *p0, void *p1, void *p2)
 		stamp_msg(&ctx->led_array.stamp, k_uptime_ticks());
 		ctx->led_array.led_count = led_msg_index;
 
-		zros_pub_update(&ctx->pub_led_array);
+		synapse_pub_update(&ctx->pub_led_array, SYNAPSE_TOPIC_led_array);
 	}
 
 	rdd2_lighting_fini(ctx);
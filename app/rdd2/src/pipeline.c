@@ -0,0 +1,180 @@
+/*
+ * Copyright CogniPilot Foundation 2024
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+
+#include <zros/private/zros_node_struct.h>
+#include <zros/private/zros_sub_struct.h>
+#include <zros/zros_node.h>
+#include <zros/zros_sub.h>
+
+#include <cerebri/core/perf_counter.h>
+#include <cerebri/core/perf_duration.h>
+
+#include <synapse_topic_list.h>
+
+#include "pipeline.h"
+
+#define MY_STACK_SIZE 6144
+#define MY_PRIORITY   4
+
+LOG_MODULE_REGISTER(rdd2_pipeline, CONFIG_CEREBRI_RDD2_LOG_LEVEL);
+
+static K_THREAD_STACK_DEFINE(g_my_stack_area, MY_STACK_SIZE);
+
+struct context {
+	struct zros_node node;
+	synapse_pb_Imu imu;
+	struct zros_sub sub_imu;
+	struct k_sem running;
+	size_t stack_size;
+	k_thread_stack_t *stack_area;
+	struct k_thread thread_data;
+	struct perf_counter perf;
+	struct perf_duration duration;
+};
+
+static struct context g_ctx = {
+	.node = {},
+	.imu = synapse_pb_Imu_init_default,
+	.sub_imu = {},
+	.running = Z_SEM_INITIALIZER(g_ctx.running, 1, 1),
+	.stack_size = MY_STACK_SIZE,
+	.stack_area = g_my_stack_area,
+	.thread_data = {},
+	.perf = {},
+	.duration = {},
+};
+
+static void rdd2_pipeline_init(struct context *ctx)
+{
+	zros_node_init(&ctx->node, "rdd2_pipeline");
+	zros_sub_init(&ctx->sub_imu, &ctx->node, &topic_imu, &ctx->imu, 1000);
+	perf_counter_init(&ctx->perf, "pipeline imu", 1.0 / 100);
+	perf_duration_init(&ctx->duration, "rdd2 pipeline",
+			   CONFIG_CEREBRI_RDD2_PIPELINE_DEADLINE_US * 1e-6);
+	rdd2_estimate_pipeline_init();
+	rdd2_attitude_pipeline_init();
+	rdd2_angular_velocity_pipeline_init();
+	rdd2_allocation_pipeline_init();
+	k_sem_take(&ctx->running, K_FOREVER);
+	LOG_INF("init");
+}
+
+static void rdd2_pipeline_fini(struct context *ctx)
+{
+	rdd2_allocation_pipeline_fini();
+	rdd2_angular_velocity_pipeline_fini();
+	rdd2_attitude_pipeline_fini();
+	rdd2_estimate_pipeline_fini();
+	perf_duration_fini(&ctx->duration);
+	perf_counter_fini(&ctx->perf);
+	zros_sub_fini(&ctx->sub_imu);
+	zros_node_fini(&ctx->node);
+	k_sem_give(&ctx->running);
+	LOG_INF("fini");
+}
+
+static void rdd2_pipeline_run(void *p0, void *p1, void *p2)
+{
+	struct context *ctx = p0;
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+
+	rdd2_pipeline_init(ctx);
+
+	struct k_poll_event events[] = {
+		*zros_sub_get_event(&ctx->sub_imu),
+	};
+
+	while (k_sem_take(&ctx->running, K_NO_WAIT) < 0) {
+		int rc = 0;
+		rc = k_poll(events, ARRAY_SIZE(events), K_MSEC(100));
+		if (rc != 0) {
+			// same as the allocation thread, stop motors without data
+			LOG_DBG("not receiving imu");
+			rdd2_allocation_pipeline_step(NULL);
+			continue;
+		}
+
+		if (!zros_sub_update_available(&ctx->sub_imu)) {
+			continue;
+		}
+		zros_sub_update(&ctx->sub_imu);
+		perf_counter_update(&ctx->perf);
+
+#if defined(CONFIG_SCHED_DEADLINE)
+		// preempt other threads of the same priority until this sample is done
+		k_thread_deadline_set(k_current_get(),
+				      k_us_to_cyc_ceil32(CONFIG_CEREBRI_RDD2_PIPELINE_DEADLINE_US));
+#endif
+
+		perf_duration_start(&ctx->duration);
+
+		const synapse_pb_Odometry *odometry = rdd2_estimate_pipeline_step(&ctx->imu);
+		if (odometry != NULL) {
+			const synapse_pb_Vector3 *angular_velocity_sp =
+				rdd2_attitude_pipeline_step(odometry);
+			const synapse_pb_Vector3 *moment_sp =
+				rdd2_angular_velocity_pipeline_step(odometry, angular_velocity_sp);
+			if (moment_sp != NULL) {
+				rdd2_allocation_pipeline_step(moment_sp);
+			}
+		}
+
+		perf_duration_stop(&ctx->duration);
+	}
+
+	rdd2_pipeline_fini(ctx);
+}
+
+static int start(struct context *ctx)
+{
+	k_tid_t tid =
+		k_thread_create(&ctx->thread_data, ctx->stack_area, ctx->stack_size,
+				rdd2_pipeline_run, ctx, NULL, NULL, MY_PRIORITY, 0, K_FOREVER);
+	k_thread_name_set(tid, "rdd2_pipeline");
+	k_thread_start(tid);
+	return 0;
+}
+
+static int rdd2_pipeline_cmd_handler(const struct shell *sh, size_t argc, char **argv, void *data)
+{
+	ARG_UNUSED(argc);
+	struct context *ctx = data;
+
+	if (strcmp(argv[0], "start") == 0) {
+		if (k_sem_count_get(&g_ctx.running) == 0) {
+			shell_print(sh, "already running");
+		} else {
+			start(ctx);
+		}
+	} else if (strcmp(argv[0], "stop") == 0) {
+		if (k_sem_count_get(&g_ctx.running) == 0) {
+			k_sem_give(&g_ctx.running);
+		} else {
+			shell_print(sh, "not running");
+		}
+	} else if (strcmp(argv[0], "status") == 0) {
+		shell_print(sh, "running: %d", (int)k_sem_count_get(&g_ctx.running) == 0);
+	}
+	return 0;
+}
+
+SHELL_SUBCMD_DICT_SET_CREATE(sub_rdd2_pipeline, rdd2_pipeline_cmd_handler, (start, &g_ctx, "start"),
+			     (stop, &g_ctx, "stop"), (status, &g_ctx, "status"));
+
+SHELL_CMD_REGISTER(rdd2_pipeline, &sub_rdd2_pipeline, "rdd2 control pipeline commands", NULL);
+
+static int rdd2_pipeline_sys_init(void)
+{
+	return start(&g_ctx);
+};
+
+SYS_INIT(rdd2_pipeline_sys_init, APPLICATION, 4);
+
+// vi: ts=4 sw=4 et
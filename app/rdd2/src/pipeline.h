@@ -0,0 +1,38 @@
+#ifndef CEREBRI_RDD2_PIPELINE_H_
+#define CEREBRI_RDD2_PIPELINE_H_
+
+#include <synapse_topic_list.h>
+
+/*
+ * Fused control pipeline, CONFIG_CEREBRI_RDD2_PIPELINE.
+ *
+ * Instead of running in their own threads, the estimate, attitude,
+ * angular_velocity and allocation stages are stepped back to back by
+ * pipeline.c for every imu sample. Each step takes the previous stage output
+ * directly and returns its own output, or NULL if nothing was published.
+ * Outputs are still published on their topics for logging.
+ */
+
+void rdd2_estimate_pipeline_init(void);
+void rdd2_estimate_pipeline_fini(void);
+const synapse_pb_Odometry *rdd2_estimate_pipeline_step(const synapse_pb_Imu *imu);
+
+void rdd2_attitude_pipeline_init(void);
+void rdd2_attitude_pipeline_fini(void);
+const synapse_pb_Vector3 *rdd2_attitude_pipeline_step(const synapse_pb_Odometry *odometry);
+
+// a NULL angular_velocity_sp uses the angular_velocity_sp topic instead
+void rdd2_angular_velocity_pipeline_init(void);
+void rdd2_angular_velocity_pipeline_fini(void);
+const synapse_pb_Vector3 *
+rdd2_angular_velocity_pipeline_step(const synapse_pb_Odometry *odometry,
+				    const synapse_pb_Vector3 *angular_velocity_sp);
+
+// a NULL moment_sp stops the motors
+void rdd2_allocation_pipeline_init(void);
+void rdd2_allocation_pipeline_fini(void);
+void rdd2_allocation_pipeline_step(const synapse_pb_Vector3 *moment_sp);
+
+#endif // CEREBRI_RDD2_PIPELINE_H_
+
+// vi: ts=4 sw=4 et
@@ -32,6 +32,13 @@ LOG_MODULE_REGISTER(rdd2_position, CONFIG_CEREBRI_RDD2_LOG_LEVEL);
 
 static K_THREAD_STACK_DEFINE(g_my_stack_area, MY_STACK_SIZE);
 
+#if defined(CONFIG_CEREBRI_RDD2_LOG_LINEAR_POSITION)
+CASADI_FUNC_DEFINE(se23_error);
+CASADI_FUNC_DEFINE(se23_position_control);
+#else
+CASADI_FUNC_DEFINE(position_control);
+#endif
+
 static const double thrust_trim = CONFIG_CEREBRI_RDD2_THRUST_TRIM * 1e-3;
 
 struct context {
@@ -273,10 +280,11 @@ static void rdd2_position_run(void *p0, void *p1, void *p2)
 				ctx->attitude_sp.x = qr_wb[1];
 				ctx->attitude_sp.y = qr_wb[2];
 				ctx->attitude_sp.z = qr_wb[3];
-				zros_pub_update(&ctx->pub_attitude_sp);
+				synapse_pub_update(&ctx->pub_attitude_sp,
+						   SYNAPSE_TOPIC_attitude_sp);
 
 				ctx->force_sp.z = nT;
-				zros_pub_update(&ctx->pub_force_sp);
+				synapse_pub_update(&ctx->pub_force_sp, SYNAPSE_TOPIC_force_sp);
 			}
 		}
 	}
@@ -20,6 +20,7 @@
 #include <zros/zros_sub.h>
 
 #include <cerebri/core/perf_duration.h>
+#include <synapse_esc_telemetry.h>
 #include <synapse_topic_list.h>
 
 LOG_MODULE_REGISTER(actuate_dshot, CONFIG_CEREBRI_ACTUATE_DSHOT_LOG_LEVEL);
@@ -41,14 +42,17 @@ typedef struct actuator_dshot_t {
 	uint32_t center;
 	double scale;
 	uint8_t index;
+	uint8_t pole_pairs;
 	dshot_type_t type;
 } actuator_dshot_t;
 
 struct context {
 	synapse_pb_Actuators actuators;
 	synapse_pb_Status status;
+	struct synapse_esc_telemetry esc_telemetry;
 	struct zros_node node;
 	struct zros_sub sub_actuators, sub_status;
+	struct zros_pub pub_esc_telemetry;
 	struct k_sem running;
 	size_t stack_size;
 	k_thread_stack_t *stack_area;
@@ -56,6 +60,7 @@ struct context {
 	const struct device *const dev;
 	uint8_t num_actuators;
 	const actuator_dshot_t *dshot_actuators;
+	uint16_t *throttle;
 };
 
 static int actuate_dshot_init(struct context *ctx)
@@ -68,6 +73,8 @@ static int actuate_dshot_init(struct context *ctx)
 	zros_node_init(&ctx->node, "actuate_dshot");
 	zros_sub_init(&ctx->sub_actuators, &ctx->node, &topic_actuators, &ctx->actuators, 1000);
 	zros_sub_init(&ctx->sub_status, &ctx->node, &topic_status, &ctx->status, 10);
+	zros_pub_init(&ctx->pub_esc_telemetry, &ctx->node, &topic_esc_telemetry,
+		      &ctx->esc_telemetry);
 	k_sem_take(&ctx->running, K_FOREVER);
 	return 0;
 }
@@ -77,14 +84,47 @@ static void actuate_dshot_fini(struct context *ctx)
 	LOG_INF("fini");
 	zros_sub_fini(&ctx->sub_actuators);
 	zros_sub_fini(&ctx->sub_status);
+	zros_pub_fini(&ctx->pub_esc_telemetry);
 	zros_node_fini(&ctx->node);
 	k_sem_give(&ctx->running);
 }
 
+// publish the responses to the previous command, the next trigger starts a new round
+static void dshot_telemetry_update(struct context *ctx)
+{
+	struct synapse_esc_telemetry *msg = &ctx->esc_telemetry;
+
+	msg->motor_count = MIN(ctx->num_actuators, SYNAPSE_ESC_TELEMETRY_MAX_MOTORS);
+	for (int i = 0; i < msg->motor_count; i++) {
+		struct synapse_esc_telemetry_motor *motor = &msg->motor[i];
+		struct nxp_flexio_dshot_telemetry telemetry = {};
+		int rc = nxp_flexio_dshot_telemetry_get(ctx->dev, i, &telemetry);
+
+		if (rc == -ENOTSUP || rc == -EINVAL) {
+			continue;
+		}
+		motor->valid = rc == 0;
+		synapse_esc_telemetry_rate_update(motor, rc != 0);
+		if (rc == 0) {
+			// responses carry erpm / 100
+			motor->erpm = 100 * telemetry.erpm;
+			motor->rpm = (float)motor->erpm / ctx->dshot_actuators[i].pole_pairs;
+			motor->cmd_age_us = telemetry.latency_us;
+		}
+		motor->crc_errors = telemetry.crc_error_cnt;
+		motor->frame_errors = telemetry.frame_error_cnt;
+		motor->no_response = telemetry.no_response_cnt;
+	}
+	stamp_msg(&msg->stamp, k_uptime_ticks());
+	synapse_pub_update(&ctx->pub_esc_telemetry, SYNAPSE_TOPIC_esc_telemetry);
+}
+
 static void dshot_update(struct context *ctx)
 {
 	bool armed = ctx->status.arming == synapse_pb_Status_Arming_ARMING_ARMED;
 
+	dshot_telemetry_update(ctx);
+
 	for (int i = 0; i < ctx->num_actuators; i++) {
 		actuator_dshot_t dshot = ctx->dshot_actuators[i];
 
@@ -102,12 +142,13 @@ static void dshot_update(struct context *ctx)
 			}
 		}
 
-		nxp_flexio_dshot_data_set(ctx->dev, i, (uint16_t)throttle, false);
-
-		perf_duration_stop(&control_latency);
+		ctx->throttle[i] = (uint16_t)throttle;
 	}
 
-	nxp_flexio_dshot_trigger(ctx->dev);
+	// all motors start in the same flexio trigger
+	nxp_flexio_dshot_update(ctx->dev, ctx->throttle, ctx->num_actuators, false);
+
+	perf_duration_stop(&control_latency);
 }
 
 static void dshot_beep(const struct shell *sh, struct context *ctx, int motor)
@@ -228,6 +269,18 @@ static int actuate_dshot_cmd_handler(const struct shell *sh, size_t argc, char *
 		}
 	} else if (strcmp(argv[0], "status") == 0) {
 		shell_print(sh, "running: %d", (int)k_sem_count_get(&ctx->running) == 0);
+	} else if (strcmp(argv[0], "telemetry") == 0) {
+		const struct synapse_esc_telemetry *msg = &ctx->esc_telemetry;
+		for (int i = 0; i < msg->motor_count; i++) {
+			const struct synapse_esc_telemetry_motor *motor = &msg->motor[i];
+			shell_print(sh,
+				    "motor %d: rpm %8.1f latency %5u us error rate %5.3f crc %u "
+				    "frame %u no response %u%s",
+				    i, (double)motor->rpm, motor->cmd_age_us,
+				    (double)motor->error_rate, motor->crc_errors,
+				    motor->frame_errors, motor->no_response,
+				    motor->valid ? "" : " STALE");
+		}
 	} else if (strcmp(argv[0], "beep") == 0) {
 		if (k_sem_count_get(&ctx->running) == 0) {
 			shell_print(sh, "must stop before using set");
@@ -270,6 +323,7 @@ static int actuate_dshot_device_init(const struct device *dev)
 		SHELL_CMD(start, NULL, "start", actuate_dshot_cmd_handler_##inst),                 \
 		SHELL_CMD(stop, NULL, "stop", actuate_dshot_cmd_handler_##inst),                   \
 		SHELL_CMD(status, NULL, "status", actuate_dshot_cmd_handler_##inst),               \
+		SHELL_CMD(telemetry, NULL, "telemetry", actuate_dshot_cmd_handler_##inst),         \
 		SHELL_CMD_ARG(beep, NULL, "beep <actuator_index>",                                 \
 			      actuate_dshot_cmd_handler_##inst, 2, 0),                             \
 		SHELL_CMD_ARG(dir, NULL,                                                           \
@@ -287,12 +341,14 @@ static int actuate_dshot_device_init(const struct device *dev)
 		.center = DT_PROP(node_id, center),                                                \
 		.scale = ((double)DT_PROP(node_id, scale)) / DT_PROP(node_id, scale_div),          \
 		.index = DT_PROP(node_id, input_index),                                            \
+		.pole_pairs = DT_PROP(node_id, pole_pairs),                                        \
 		.type = DT_ENUM_IDX(node_id, input_type),                                          \
 	},
 
 #define DSHOT_ACTUATORS_DEFINE(inst)                                                               \
 	static const actuator_dshot_t g_actuator_dshots_##inst[] = {                               \
 		DT_FOREACH_CHILD(DT_INST(inst, cerebri_dshot_actuators), DSHOT_ACTUATOR_DEFINE)};  \
+	static uint16_t g_throttle_##inst[DT_CHILD_NUM(DT_INST(inst, cerebri_dshot_actuators))];   \
 	static K_THREAD_STACK_DEFINE(g_my_stack_area_##inst, MY_STACK_SIZE);                       \
 	static struct context data_##inst = {                                                      \
 		.actuators = synapse_pb_Actuators_init_default,                                    \
@@ -301,11 +357,13 @@ static int actuate_dshot_device_init(const struct device *dev)
 		.node = {},                                                                        \
 		.sub_status = {},                                                                  \
 		.sub_actuators = {},                                                               \
+		.pub_esc_telemetry = {},                                                           \
 		.running = Z_SEM_INITIALIZER(data_##inst.running, 1, 1),                           \
 		.stack_size = MY_STACK_SIZE,                                                       \
 		.stack_area = g_my_stack_area_##inst,                                              \
 		.thread_data = {},                                                                 \
 		.dshot_actuators = g_actuator_dshots_##inst,                                       \
+		.throttle = g_throttle_##inst,                                                     \
 		.num_actuators = DT_CHILD_NUM(DT_INST(inst, cerebri_dshot_actuators)),             \
 	};                                                                                         \
 	DSHOT_ACTUATOR_SHELL(inst);                                                                \
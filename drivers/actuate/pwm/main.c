@@ -5,6 +5,7 @@
 
 #define DT_DRV_COMPAT cerebri_pwm_actuators
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <zephyr/drivers/pwm.h>
@@ -27,6 +28,8 @@ LOG_MODULE_REGISTER(actuate_pwm, CONFIG_CEREBRI_ACTUATE_PWM_LOG_LEVEL);
 #define CONFIG_PWM_ACTUATORS_INIT_PRIORITY 50
 #define MY_STACK_SIZE                      4096
 #define MY_PRIORITY                        4
+// never written to the hardware, forces the next commit of a channel
+#define PULSE_UNLATCHED                    UINT32_MAX
 
 extern struct perf_duration control_latency;
 
@@ -49,6 +52,14 @@ typedef struct actuator_pwm_t {
 	pwm_type_t type;
 } actuator_pwm_t;
 
+// per channel output state, cycles are converted once at init
+struct pwm_output {
+	uint64_t cycles_per_sec;
+	uint32_t period_cycles;
+	uint32_t staged;
+	uint32_t latched;
+};
+
 struct context {
 	synapse_pb_Actuators actuators;
 	synapse_pb_Status status;
@@ -63,8 +74,74 @@ struct context {
 	uint32_t test_pulse;
 	uint8_t num_actuators;
 	const actuator_pwm_t *actuator_pwms;
+	struct pwm_output *outputs;
+	int64_t pub_period_ticks;
+	int64_t pub_next_ticks;
+	uint64_t commits;
+	uint64_t writes;
+	uint32_t max_commit_us;
 };
 
+static int pwm_output_init(struct context *ctx)
+{
+	for (int i = 0; i < ctx->num_actuators; i++) {
+		const struct pwm_dt_spec *spec = &ctx->actuator_pwms[i].device;
+		struct pwm_output *out = &ctx->outputs[i];
+		int err = pwm_get_cycles_per_sec(spec->dev, spec->channel, &out->cycles_per_sec);
+		if (err) {
+			LOG_ERR("failed to get pwm_%d clock (err %d)", i, err);
+			return err;
+		}
+		out->period_cycles = spec->period * out->cycles_per_sec / NSEC_PER_SEC;
+		out->staged = PULSE_UNLATCHED;
+		out->latched = PULSE_UNLATCHED;
+	}
+	return 0;
+}
+
+// stage the pulse of a channel, in the unit of its configuration
+static void pwm_output_stage(struct context *ctx, int i, uint32_t pulse)
+{
+	const actuator_pwm_t *pwm = &ctx->actuator_pwms[i];
+	struct pwm_output *out = &ctx->outputs[i];
+	uint64_t unit = pwm->use_nano_seconds ? NSEC_PER_SEC : USEC_PER_SEC;
+
+	out->staged = pulse * out->cycles_per_sec / unit;
+}
+
+/*
+ * Write the staged pulses of all channels that changed back to back, or of
+ * all channels if force is set. Timers with preloaded compare registers latch
+ * them together at the next period boundary, the scheduler is locked so the
+ * writes are not spread over periods.
+ */
+static void pwm_output_commit(struct context *ctx, bool force)
+{
+	uint32_t start = k_cycle_get_32();
+
+	k_sched_lock();
+	for (int i = 0; i < ctx->num_actuators; i++) {
+		const struct pwm_dt_spec *spec = &ctx->actuator_pwms[i].device;
+		struct pwm_output *out = &ctx->outputs[i];
+		if (!force && out->staged == out->latched) {
+			continue;
+		}
+		int err = pwm_set_cycles(spec->dev, spec->channel, out->period_cycles, out->staged,
+					 spec->flags);
+		if (err) {
+			LOG_ERR("failed to set pwm_%d to %u cycles (err %d)", i, out->staged, err);
+			out->latched = PULSE_UNLATCHED;
+			continue;
+		}
+		out->latched = out->staged;
+		ctx->writes++;
+	}
+	k_sched_unlock();
+
+	ctx->commits++;
+	ctx->max_commit_us = MAX(ctx->max_commit_us, k_cyc_to_us_ceil32(k_cycle_get_32() - start));
+}
+
 static int actuate_pwm_init(struct context *ctx)
 {
 	LOG_INF("init");
@@ -77,6 +154,13 @@ static int actuate_pwm_init(struct context *ctx)
 		}
 	}
 
+	if (pwm_output_init(ctx) < 0) {
+		return -1;
+	}
+	ctx->pub_period_ticks =
+		CONFIG_SYS_CLOCK_TICKS_PER_SEC / CONFIG_CEREBRI_ACTUATE_PWM_PUB_RATE;
+	ctx->pub_next_ticks = k_uptime_ticks();
+
 	zros_node_init(&ctx->node, "actuate_pwm");
 	zros_sub_init(&ctx->sub_actuators, &ctx->node, &topic_actuators, &ctx->actuators, 1000);
 	zros_sub_init(&ctx->sub_status, &ctx->node, &topic_status, &ctx->status, 10);
@@ -98,7 +182,6 @@ static void actuate_pwm_fini(struct context *ctx)
 static void pwm_update(struct context *ctx)
 {
 	bool armed = ctx->status.arming == synapse_pb_Status_Arming_ARMING_ARMED;
-	int err = 0;
 
 	for (int i = 0; i < ctx->num_actuators; i++) {
 		actuator_pwm_t pwm = ctx->actuator_pwms[i];
@@ -128,21 +211,19 @@ static void pwm_update(struct context *ctx)
 		}
 
 		ctx->pwm.channel[i] = pulse;
+		pwm_output_stage(ctx, i, pulse);
+	}
 
-		if (pwm.use_nano_seconds) {
-			err = pwm_set_pulse_dt(&pwm.device, PWM_NSEC(pulse));
-		} else {
-			err = pwm_set_pulse_dt(&pwm.device, PWM_USEC(pulse));
-		}
-		perf_duration_stop(&control_latency);
+	pwm_output_commit(ctx, false);
+	perf_duration_stop(&control_latency);
 
-		if (err) {
-			LOG_ERR("Failed to set pulse %d on %d (err %d)", pulse, pwm.index, err);
-		}
+	// the pwm topic is only for monitoring, publish it at a reduced rate
+	int64_t now = k_uptime_ticks();
+	if (now >= ctx->pub_next_ticks) {
+		ctx->pub_next_ticks = MAX(ctx->pub_next_ticks + ctx->pub_period_ticks, now);
+		stamp_msg(&ctx->pwm.timestamp, now);
+		synapse_pub_update(&ctx->pub_pwm, SYNAPSE_TOPIC_pwm);
 	}
-
-	stamp_msg(&ctx->pwm.timestamp, k_uptime_ticks());
-	zros_pub_update(&ctx->pub_pwm);
 }
 
 static void actuate_pwm_run(void *p0, void *p1, void *p2)
@@ -201,17 +282,10 @@ static int start(struct context *ctx)
 static int set_pulse_all(struct context *ctx, uint32_t pulse)
 {
 	for (int i = 0; i < ctx->num_actuators; i++) {
-		actuator_pwm_t pwm = ctx->actuator_pwms[i];
-		int err = 0;
-		if (pwm.use_nano_seconds) {
-			err = pwm_set_pulse_dt(&pwm.device, PWM_NSEC(pulse));
-		} else {
-			err = pwm_set_pulse_dt(&pwm.device, PWM_USEC(pulse));
-		}
-		if (err) {
-			LOG_ERR("failed to set pulse %d on %d (err %d)", pwm.max, pwm.index, err);
-		}
+		pwm_output_stage(ctx, i, pulse);
 	}
+	// written even if unchanged, the outputs may have been set outside the driver
+	pwm_output_commit(ctx, true);
 	return 0;
 }
 
@@ -253,6 +327,14 @@ static int actuate_pwm_cmd_handler(const struct shell *sh, size_t argc, char **a
 		}
 	} else if (strcmp(argv[0], "status") == 0) {
 		shell_print(sh, "running: %d", (int)k_sem_count_get(&ctx->running) == 0);
+	} else if (strcmp(argv[0], "output") == 0) {
+		shell_print(sh, "commits %" PRIu64 " writes %" PRIu64 " max commit %u us",
+			    ctx->commits, ctx->writes, ctx->max_commit_us);
+		for (int i = 0; i < ctx->num_actuators; i++) {
+			const struct pwm_output *out = &ctx->outputs[i];
+			shell_print(sh, "pwm_%d: %u / %u cycles", i, out->latched,
+				    out->period_cycles);
+		}
 	} else {
 		shell_print(sh, "unknown command");
 	}
@@ -271,6 +353,7 @@ static int actuate_pwm_device_init(const struct device *dev)
 	SHELL_SUBCMD_DICT_SET_CREATE(sub_actuate_pwm_##inst, actuate_pwm_cmd_handler,              \
 				     (start, &data_##inst, "start"), (stop, &data_##inst, "stop"), \
 				     (status, &data_##inst, "status"),                             \
+				     (output, &data_##inst, "output"),                             \
 				     (set_all_1000, &data_##inst, "set_all_1000"),                 \
 				     (set_all_1500, &data_##inst, "set_all_1500"),                 \
 				     (set_all_2000, &data_##inst, "set_all_2000"));                \
@@ -294,6 +377,7 @@ static int actuate_pwm_device_init(const struct device *dev)
 #define PWM_ACTUATORS_DEFINE(inst)                                                                 \
 	static const actuator_pwm_t g_actuator_pwms_##inst[] = {                                   \
 		DT_FOREACH_CHILD(DT_INST(inst, cerebri_pwm_actuators), PWM_ACTUATOR_DEFINE)};      \
+	static struct pwm_output g_pwm_outputs_##inst[ARRAY_SIZE(g_actuator_pwms_##inst)];         \
 	static K_THREAD_STACK_DEFINE(g_my_stack_area_##inst, MY_STACK_SIZE);                       \
 	static struct context data_##inst = {                                                      \
 		.actuators = synapse_pb_Actuators_init_default,                                    \
@@ -315,6 +399,7 @@ static int actuate_pwm_device_init(const struct device *dev)
 		.thread_data = {},                                                                 \
 		.test_pulse = 0,                                                                   \
 		.actuator_pwms = g_actuator_pwms_##inst,                                           \
+		.outputs = g_pwm_outputs_##inst,                                                   \
 		.num_actuators = DT_CHILD_NUM(DT_INST(inst, cerebri_pwm_actuators)),               \
 	};                                                                                         \
 	PWM_ACTUATOR_SHELL(inst);                                                                  \
@@ -5,11 +5,13 @@
 
 #define DT_DRV_COMPAT cerebri_vesc_can_actuators
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/shell/shell.h>
+#include <zephyr/sys/byteorder.h>
 
 #include <zros/private/zros_node_struct.h>
 #include <zros/private/zros_pub_struct.h>
@@ -22,7 +24,9 @@
 #include <zephyr/net/socketcan.h>
 #include <zephyr/net/socketcan_utils.h>
 
+#include <cerebri/core/freshness.h>
 #include <cerebri/core/perf_duration.h>
+#include <synapse_esc_telemetry.h>
 #include <synapse_topic_list.h>
 
 LOG_MODULE_REGISTER(actuate_vesc_can, CONFIG_CEREBRI_ACTUATE_VESC_CAN_LOG_LEVEL);
@@ -32,13 +36,16 @@ LOG_MODULE_REGISTER(actuate_vesc_can, CONFIG_CEREBRI_ACTUATE_VESC_CAN_LOG_LEVEL)
 #define MY_PRIORITY                             4
 
 #define CAN_STATUS_ID_BASE 0x00000900
+#define CAN_RPM_ID_BASE    0x00000300
+// extended frame without data, stuff bits and interframe space
+#define CAN_FRAME_OVERHEAD_BITS 80
+// status samples buffered per motor between thread wakeups, power of two
+#define STATUS_RING_SIZE 8
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
-uint32_t g_send_count = 0;
-
 extern struct perf_duration control_latency;
 
 static void actuate_vesc_can_rx_callback(const struct device *dev, struct can_frame *frame,
@@ -50,6 +57,11 @@ typedef enum vesc_can_type_t {
 	VESC_CAN_TYPE_VELOCITY = 2,
 } vesc_can_type_t;
 
+struct vesc_status_sample {
+	int64_t ticks;
+	int32_t erpm;
+};
+
 struct actuator_vesc_can {
 	const char *label;
 	uint8_t id;
@@ -59,16 +71,51 @@ struct actuator_vesc_can {
 	vesc_can_type_t type;
 	struct can_filter rx_filter;
 	struct context *ctx;
+	// status samples, produced by the rx callback and consumed by the thread
+	struct vesc_status_sample ring[STATUS_RING_SIZE];
+	atomic_t ring_head;
+	atomic_t ring_tail;
+	uint32_t ring_overflows;
+	// integrated in thread context
 	double rotation;
+	int64_t sample_ticks;
+	uint8_t round_samples;
+	// last status frame, written by the rx callback under ctx->tx.lock
+	int32_t status_erpm;
+	uint32_t status_cyc;
+	// age of the last command when the status frame arrived
+	uint32_t cmd_age_cyc;
+	atomic_t status_count;
+	// last command sent
+	uint32_t tx_cyc;
+	bool tx_failed;
+};
+
+// written by the tx callback, protected by the lock, which also guards the
+// last status frame of every motor
+struct vesc_can_tx_stats {
+	struct k_spinlock lock;
+	uint32_t depth;
+	uint32_t max_depth;
+	uint64_t sent;
+	uint64_t dropped;
+	uint64_t errors;
+	uint64_t bits;
+	uint64_t latency_us;
+	uint32_t max_latency_us;
+	int64_t start_ticks;
 };
 
 struct context {
 	synapse_pb_Actuators actuators;
 	synapse_pb_WheelOdometry wheel_odometry;
 	synapse_pb_Status status;
+	struct synapse_esc_telemetry esc_telemetry;
 	struct zros_node node;
 	struct zros_sub sub_actuators, sub_status;
-	struct zros_pub pub_wheel_odometry;
+	struct zros_pub pub_wheel_odometry, pub_esc_telemetry;
+	struct freshness fresh_actuators;
+	struct k_poll_signal status_signal;
 	struct k_sem running;
 	size_t stack_size;
 	k_thread_stack_t *stack_area;
@@ -81,6 +128,13 @@ struct context {
 	const char *label;
 	uint16_t status_rate;
 	bool enable_pub_wheel_odom;
+	uint64_t odometry_rounds;
+	uint64_t odometry_missed;
+	uint32_t bitrate;
+	uint32_t bitrate_data;
+	struct can_frame *tx_frames;
+	uint32_t tx_frame_bits;
+	struct vesc_can_tx_stats tx;
 };
 
 static int actuate_vesc_can_stop(struct context *ctx)
@@ -108,6 +162,17 @@ static int actuate_vesc_can_stop(struct context *ctx)
 	return err;
 }
 
+// nominal bit times of one rpm command, used for the bus load
+static uint32_t vesc_can_frame_bits(const struct context *ctx)
+{
+	uint32_t data_bits = 8 * 4;
+	if (ctx->fd && ctx->bitrate_data > 0) {
+		// data phase at the fast rate, in nominal bit times
+		data_bits = data_bits * ctx->bitrate / ctx->bitrate_data;
+	}
+	return CAN_FRAME_OVERHEAD_BITS + data_bits;
+}
+
 static int actuate_vesc_can_init(struct context *ctx)
 {
 	int err = 0;
@@ -116,12 +181,17 @@ static int actuate_vesc_can_init(struct context *ctx)
 	zros_sub_init(&ctx->sub_status, &ctx->node, &topic_status, &ctx->status, 10);
 	zros_pub_init(&ctx->pub_wheel_odometry, &ctx->node, &topic_wheel_odometry,
 		      &ctx->wheel_odometry);
+	zros_pub_init(&ctx->pub_esc_telemetry, &ctx->node, &topic_esc_telemetry,
+		      &ctx->esc_telemetry);
 
 	if (ctx->ready) {
 		LOG_ERR("%s - already initialized", ctx->label);
 		return 0;
 	}
 
+	freshness_init(&ctx->fresh_actuators, "actuate_vesc_can actuators",
+		       CONFIG_CEREBRI_ACTUATE_VESC_CAN_ACTUATORS_MAX_AGE_MS);
+
 	// check if device ready
 	if (!device_is_ready(ctx->device)) {
 		LOG_ERR("%s - device not ready\n", ctx->label);
@@ -147,10 +217,16 @@ static int actuate_vesc_can_init(struct context *ctx)
 		return err;
 	}
 
+	k_poll_signal_init(&ctx->status_signal);
+
 	// add receive callback
 	for (int i = 0; i < ctx->num_actuators; i++) {
 		struct actuator_vesc_can *act = &ctx->actuator_vesc_cans[i];
 		act->ctx = ctx;
+		atomic_set(&act->ring_head, 0);
+		atomic_set(&act->ring_tail, 0);
+		act->sample_ticks = 0;
+		act->round_samples = 0;
 		act->rx_filter.flags = CAN_FILTER_IDE;
 		act->rx_filter.id = CAN_STATUS_ID_BASE + act->vesc_id;
 		act->rx_filter.mask = CAN_EXT_ID_MASK;
@@ -162,6 +238,10 @@ static int actuate_vesc_can_init(struct context *ctx)
 		}
 	}
 
+	ctx->tx = (struct vesc_can_tx_stats){
+		.start_ticks = k_uptime_ticks(),
+	};
+	ctx->tx_frame_bits = vesc_can_frame_bits(ctx);
 	ctx->ready = true;
 	LOG_DBG("%s - connected and properly initialized.\n", ctx->label);
 	k_sem_take(&ctx->running, K_FOREVER);
@@ -172,9 +252,11 @@ static int actuate_vesc_can_init(struct context *ctx)
 static int actuate_vesc_can_fini(struct context *ctx)
 {
 	actuate_vesc_can_stop(ctx);
+	freshness_fini(&ctx->fresh_actuators);
 	zros_sub_fini(&ctx->sub_actuators);
 	zros_sub_fini(&ctx->sub_status);
 	zros_pub_fini(&ctx->pub_wheel_odometry);
+	zros_pub_fini(&ctx->pub_esc_telemetry);
 	zros_node_fini(&ctx->node);
 	k_sem_give(&ctx->running);
 	LOG_INF("fini");
@@ -186,35 +268,56 @@ static void actuate_vesc_can_rx_callback(const struct device *dev, struct can_fr
 {
 	struct actuator_vesc_can *act = (struct actuator_vesc_can *)user_data;
 	struct context *ctx = act->ctx;
-	int64_t data = (frame->data[0] << 24) + (frame->data[1] << 16) + (frame->data[2] << 8) +
-		       frame->data[3];
-	act->rotation += 2 * M_PI * data / (act->pole_pair * ctx->status_rate * 60);
-	// LOG_INF("Data: %ld", data);
-	// LOG_INF("Angular: %f", act->rotation);
-	if (act->id == ctx->actuator_vesc_cans[0].id) {
-		double mean_rotation = 0;
-		for (int i = 0; i < ctx->num_actuators; i++) {
-			mean_rotation += ctx->actuator_vesc_cans[i].rotation;
-		}
-		mean_rotation /= ctx->num_actuators;
-		ctx->wheel_odometry.has_stamp = true;
-		stamp_msg(&ctx->wheel_odometry.stamp, k_uptime_ticks());
-		ctx->wheel_odometry.rotation = mean_rotation;
+	// status frame starts with the signed erpm, big endian
+	int32_t data = (int32_t)sys_get_be32(frame->data);
+	K_SPINLOCK(&ctx->tx.lock) {
+		act->status_cyc = k_cycle_get_32();
+		act->status_erpm = data;
+		act->cmd_age_cyc = act->status_cyc - act->tx_cyc;
+	}
+	atomic_inc(&act->status_count);
+
+	// single producer, the slot is written before the head is published
+	atomic_val_t head = atomic_get(&act->ring_head);
+	if (head - atomic_get(&act->ring_tail) >= STATUS_RING_SIZE) {
+		act->ring_overflows++;
+		return;
+	}
+	act->ring[head & (STATUS_RING_SIZE - 1)] = (struct vesc_status_sample){
+		.ticks = k_uptime_ticks(),
+		.erpm = data,
+	};
+	atomic_set(&act->ring_head, head + 1);
+	k_poll_signal_raise(&ctx->status_signal, 0);
+}
+
+static void actuate_vesc_can_tx_callback(const struct device *dev, int error, void *user_data)
+{
+	struct actuator_vesc_can *act = user_data;
+	struct context *ctx = act->ctx;
+	uint32_t latency_us = k_cyc_to_us_floor32(k_cycle_get_32() - act->tx_cyc);
+	k_spinlock_key_t key = k_spin_lock(&ctx->tx.lock);
+
+	ctx->tx.depth--;
+	if (error == 0) {
+		ctx->tx.sent++;
+		ctx->tx.bits += ctx->tx_frame_bits;
+		ctx->tx.latency_us += latency_us;
+		ctx->tx.max_latency_us = MAX(ctx->tx.max_latency_us, latency_us);
+	} else {
+		ctx->tx.errors++;
 	}
+	k_spin_unlock(&ctx->tx.lock, key);
 }
 
 static void actuate_vesc_can_update(struct context *ctx)
 {
 	bool armed = ctx->status.arming == synapse_pb_Status_Arming_ARMING_ARMED;
-	int err = 0;
 
+	// build the frames of all motors first, so they are queued back to back
 	for (int i = 0; i < ctx->num_actuators; i++) {
 		struct actuator_vesc_can *act = &ctx->actuator_vesc_cans[i];
-
-		struct can_frame frame = {
-			.dlc = can_bytes_to_dlc(4),
-			.flags = CAN_FRAME_IDE,
-		};
+		struct can_frame *frame = &ctx->tx_frames[i];
 		double input = 0;
 
 		if (act->type == VESC_CAN_TYPE_VELOCITY && armed) {
@@ -222,23 +325,146 @@ static void actuate_vesc_can_update(struct context *ctx)
 		}
 
 		int32_t erpm = act->pole_pair * input * 60 / (2 * M_PI);
-		frame.id = 768 + act->vesc_id;
-		frame.data[0] = erpm >> 24 & 255;
-		frame.data[1] = erpm >> 16 & 255;
-		frame.data[2] = erpm >> 8 & 255;
-		frame.data[3] = erpm & 255;
-
-		// send can data
-		g_send_count += 1;
-		err = can_send(ctx->device, &frame, K_NO_WAIT, NULL, NULL);
+		*frame = (struct can_frame){
+			.id = CAN_RPM_ID_BASE + act->vesc_id,
+			.dlc = can_bytes_to_dlc(4),
+			.flags = CAN_FRAME_IDE | (ctx->fd ? CAN_FRAME_FDF | CAN_FRAME_BRS : 0),
+		};
+		sys_put_be32(erpm, frame->data);
+	}
+
+	// a full mailbox delays the update up to the deadline, then frames are dropped
+	int64_t deadline = k_uptime_ticks() +
+			   k_us_to_ticks_ceil64(CONFIG_CEREBRI_ACTUATE_VESC_CAN_TX_TIMEOUT_US);
+	for (int i = 0; i < ctx->num_actuators; i++) {
+		struct actuator_vesc_can *act = &ctx->actuator_vesc_cans[i];
+		k_spinlock_key_t key = k_spin_lock(&ctx->tx.lock);
+		ctx->tx.depth++;
+		ctx->tx.max_depth = MAX(ctx->tx.max_depth, ctx->tx.depth);
+		k_spin_unlock(&ctx->tx.lock, key);
+
+		act->tx_cyc = k_cycle_get_32();
+		int err = can_send(ctx->device, &ctx->tx_frames[i], K_TIMEOUT_ABS_TICKS(deadline),
+				   actuate_vesc_can_tx_callback, act);
+		act->tx_failed = err != 0;
 		if (err != 0) {
-			ctx->ready = false;
-			LOG_ERR("%s - send failed to VESC ID: %d (%d)\n", act->label, act->vesc_id,
-				err);
+			key = k_spin_lock(&ctx->tx.lock);
+			ctx->tx.depth--;
+			if (err == -EAGAIN) {
+				ctx->tx.dropped++;
+			} else {
+				ctx->tx.errors++;
+			}
+			k_spin_unlock(&ctx->tx.lock, key);
+			if (err != -EAGAIN) {
+				ctx->ready = false;
+				LOG_ERR("%s - send failed to VESC ID: %d (%d)\n", act->label,
+					act->vesc_id, err);
+			}
+		}
+	}
+	perf_duration_stop(&control_latency);
+}
+
+// publish the latest status frame of every motor, a motor is stale after two status periods
+static void actuate_vesc_can_telemetry_update(struct context *ctx)
+{
+	struct synapse_esc_telemetry *msg = &ctx->esc_telemetry;
+	uint32_t now = k_cycle_get_32();
+	uint32_t max_age_cyc =
+		ctx->status_rate > 0 ? 2 * sys_clock_hw_cycles_per_sec() / ctx->status_rate : 0;
+
+	msg->motor_count = MIN(ctx->num_actuators, SYNAPSE_ESC_TELEMETRY_MAX_MOTORS);
+	for (int i = 0; i < msg->motor_count; i++) {
+		struct actuator_vesc_can *act = &ctx->actuator_vesc_cans[i];
+		struct synapse_esc_telemetry_motor *motor = &msg->motor[i];
+		int32_t erpm = 0;
+		uint32_t status_cyc = 0;
+		uint32_t cmd_age_cyc = 0;
+
+		K_SPINLOCK(&ctx->tx.lock) {
+			erpm = act->status_erpm;
+			status_cyc = act->status_cyc;
+			cmd_age_cyc = act->cmd_age_cyc;
+		}
+		motor->valid =
+			atomic_get(&act->status_count) > 0 && now - status_cyc <= max_age_cyc;
+		if (ctx->status_rate == 0) {
+			// status frames disabled, only send failures are reported
+			synapse_esc_telemetry_rate_update(motor, act->tx_failed);
+			continue;
+		}
+		synapse_esc_telemetry_rate_update(motor, act->tx_failed || !motor->valid);
+		if (!motor->valid) {
+			motor->no_response++;
 			continue;
 		}
-		perf_duration_stop(&control_latency);
+		motor->erpm = erpm;
+		motor->rpm = (float)erpm / act->pole_pair;
+		motor->cmd_age_us = k_cyc_to_us_floor32(cmd_age_cyc);
+	}
+	stamp_msg(&msg->stamp, k_uptime_ticks());
+	synapse_pub_update(&ctx->pub_esc_telemetry, SYNAPSE_TOPIC_esc_telemetry);
+}
+
+// integrate the buffered status samples, the wheel odometry is published once per status round
+static void actuate_vesc_can_odometry_update(struct context *ctx)
+{
+	int64_t period_ticks =
+		ctx->status_rate > 0 ? CONFIG_SYS_CLOCK_TICKS_PER_SEC / ctx->status_rate : 0;
+	bool complete = true;
+	bool overrun = false;
+	int64_t stamp_ticks = 0;
+
+	for (int i = 0; i < ctx->num_actuators; i++) {
+		struct actuator_vesc_can *act = &ctx->actuator_vesc_cans[i];
+		atomic_val_t tail = atomic_get(&act->ring_tail);
+		atomic_val_t head = atomic_get(&act->ring_head);
+
+		for (; tail != head; tail++) {
+			const struct vesc_status_sample *sample =
+				&act->ring[tail & (STATUS_RING_SIZE - 1)];
+			// integrate over the time between frames, nominal period after a gap
+			int64_t dt_ticks = sample->ticks - act->sample_ticks;
+			if (act->sample_ticks == 0 || dt_ticks > 2 * period_ticks) {
+				dt_ticks = period_ticks;
+			}
+			double dt = (double)dt_ticks / CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+			act->rotation += 2 * M_PI * sample->erpm * dt / (act->pole_pair * 60);
+			act->sample_ticks = sample->ticks;
+			act->round_samples++;
+		}
+		atomic_set(&act->ring_tail, tail);
+
+		complete = complete && act->round_samples > 0;
+		overrun = overrun || act->round_samples > 1;
+		stamp_ticks = MAX(stamp_ticks, act->sample_ticks);
+	}
+
+	// a motor that missed its frame does not hold back the others for more than a round
+	if (!(complete || overrun)) {
+		return;
+	}
+
+	double mean_rotation = 0;
+	for (int i = 0; i < ctx->num_actuators; i++) {
+		struct actuator_vesc_can *act = &ctx->actuator_vesc_cans[i];
+		mean_rotation += act->rotation;
+		act->round_samples = 0;
+	}
+	mean_rotation /= ctx->num_actuators;
+
+	ctx->odometry_rounds++;
+	if (!complete) {
+		ctx->odometry_missed++;
 	}
+	if (!ctx->enable_pub_wheel_odom) {
+		return;
+	}
+	ctx->wheel_odometry.has_stamp = true;
+	stamp_msg(&ctx->wheel_odometry.stamp, stamp_ticks);
+	ctx->wheel_odometry.rotation = mean_rotation;
+	synapse_pub_update(&ctx->pub_wheel_odometry, SYNAPSE_TOPIC_wheel_odometry);
 }
 
 static void actuate_vesc_can_run(void *p0, void *p1, void *p2)
@@ -256,18 +482,34 @@ static void actuate_vesc_can_run(void *p0, void *p1, void *p2)
 
 	struct k_poll_event events[] = {
 		*zros_sub_get_event(&ctx->sub_actuators),
+		K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY,
+					 &ctx->status_signal),
 	};
 
+	// absolute, so status frames do not postpone the actuator timeout
+	int64_t timeout_ticks =
+		k_ms_to_ticks_ceil64(CONFIG_CEREBRI_ACTUATE_VESC_CAN_ACTUATORS_MAX_AGE_MS);
+	int64_t deadline = k_uptime_ticks() + timeout_ticks;
+
 	while (k_sem_take(&ctx->running, K_NO_WAIT) < 0) {
 		int rc = 0;
-		rc = k_poll(events, ARRAY_SIZE(events), K_MSEC(1000));
+		rc = k_poll(events, ARRAY_SIZE(events), K_TIMEOUT_ABS_TICKS(deadline));
+
+		if (events[1].state != K_POLL_STATE_NOT_READY) {
+			events[1].state = K_POLL_STATE_NOT_READY;
+			k_poll_signal_reset(&ctx->status_signal);
+			actuate_vesc_can_odometry_update(ctx);
+		}
+
+		if (rc == 0 && events[0].state == K_POLL_STATE_NOT_READY) {
+			// only status frames arrived
+			continue;
+		}
+		events[0].state = K_POLL_STATE_NOT_READY;
+		deadline = k_uptime_ticks() + timeout_ticks;
+
 		if (rc != 0) {
 			LOG_DBG("no actuator message received");
-			// put motors in disarmed state
-			if (ctx->status.arming == synapse_pb_Status_Arming_ARMING_ARMED) {
-				ctx->status.arming = synapse_pb_Status_Arming_ARMING_DISARMED;
-				LOG_ERR("Disarming motors due to actuator msg timeout!");
-			}
 		}
 
 		if (zros_sub_update_available(&ctx->sub_status)) {
@@ -276,12 +518,19 @@ static void actuate_vesc_can_run(void *p0, void *p1, void *p2)
 
 		if (zros_sub_update_available(&ctx->sub_actuators)) {
 			zros_sub_update(&ctx->sub_actuators);
+			freshness_update(&ctx->fresh_actuators);
 		}
 
-		zros_pub_update(&ctx->pub_wheel_odometry);
+		// put motors in disarmed state
+		if (!freshness_check(&ctx->fresh_actuators) &&
+		    ctx->status.arming == synapse_pb_Status_Arming_ARMING_ARMED) {
+			ctx->status.arming = synapse_pb_Status_Arming_ARMING_DISARMED;
+			LOG_ERR("Disarming motors due to actuator msg timeout!");
+		}
 
 		// update vesc_can
 		actuate_vesc_can_update(ctx);
+		actuate_vesc_can_telemetry_update(ctx);
 	}
 
 	actuate_vesc_can_fini(ctx);
@@ -319,6 +568,42 @@ static int actuate_vesc_can_cmd_handler(const struct shell *sh, size_t argc, cha
 		}
 	} else if (strcmp(argv[0], "status") == 0) {
 		shell_print(sh, "running: %d", (int)k_sem_count_get(&ctx->running) == 0);
+	} else if (strcmp(argv[0], "telemetry") == 0) {
+		const struct synapse_esc_telemetry *msg = &ctx->esc_telemetry;
+		for (int i = 0; i < msg->motor_count; i++) {
+			const struct synapse_esc_telemetry_motor *motor = &msg->motor[i];
+			shell_print(sh,
+				    "motor %d: rpm %8.1f cmd age %6u us error rate %5.3f no "
+				    "response %u%s",
+				    i, (double)motor->rpm, motor->cmd_age_us,
+				    (double)motor->error_rate, motor->no_response,
+				    motor->valid ? "" : " STALE");
+		}
+	} else if (strcmp(argv[0], "odometry") == 0) {
+		shell_print(sh, "rounds %" PRIu64 " missed %" PRIu64 " rotation %10.4f",
+			    ctx->odometry_rounds, ctx->odometry_missed,
+			    ctx->wheel_odometry.rotation);
+		for (int i = 0; i < ctx->num_actuators; i++) {
+			const struct actuator_vesc_can *act = &ctx->actuator_vesc_cans[i];
+			shell_print(sh, "motor %d: rotation %10.4f overflows %u", i, act->rotation,
+				    act->ring_overflows);
+		}
+	} else if (strcmp(argv[0], "tx") == 0) {
+		k_spinlock_key_t key = k_spin_lock(&ctx->tx.lock);
+		struct vesc_can_tx_stats tx = ctx->tx;
+		k_spin_unlock(&ctx->tx.lock, key);
+
+		uint64_t elapsed_us = k_ticks_to_us_floor64(k_uptime_ticks() - tx.start_ticks);
+		uint32_t load_permille =
+			elapsed_us > 0 && ctx->bitrate > 0
+				? tx.bits * 1000000 / elapsed_us * 1000 / ctx->bitrate
+				: 0;
+		shell_print(sh, "bus load %u.%u%% depth %u max %u", load_permille / 10,
+			    load_permille % 10, tx.depth, tx.max_depth);
+		shell_print(sh, "latency avg %" PRIu64 " us max %u us",
+			    tx.sent ? tx.latency_us / tx.sent : 0, tx.max_latency_us);
+		shell_print(sh, "sent %" PRIu64 " dropped %" PRIu64 " errors %" PRIu64, tx.sent,
+			    tx.dropped, tx.errors);
 	} else {
 		shell_print(sh, "unknown command");
 	}
@@ -335,7 +620,10 @@ static int actuate_vesc_can_device_init(const struct device *dev)
 #define VESC_CAN_ACTUATOR_SHELL(inst)                                                              \
 	SHELL_SUBCMD_DICT_SET_CREATE(sub_actuate_vesc_can_##inst, actuate_vesc_can_cmd_handler,    \
 				     (start, &data_##inst, "start"), (stop, &data_##inst, "stop"), \
-				     (status, &data_##inst, "status"));                            \
+				     (status, &data_##inst, "status"),                             \
+				     (telemetry, &data_##inst, "telemetry"),                       \
+				     (odometry, &data_##inst, "odometry"),                         \
+				     (tx, &data_##inst, "tx"));                                    \
 	SHELL_CMD_REGISTER(actuate_vesc_can_##inst, &sub_actuate_vesc_can_##inst,                  \
 			   "actuate_vesc_can commands", NULL);
 
@@ -351,9 +639,15 @@ static int actuate_vesc_can_device_init(const struct device *dev)
 		.rotation = 0,                                                                     \
 	},
 
+// bus rate of the can controller, older controller bindings name it bus-speed
+#define VESC_CAN_BITRATE(inst, prop, legacy_prop)                                                  \
+	DT_PROP_OR(DT_INST_PROP(inst, device), prop,                                               \
+		   DT_PROP_OR(DT_INST_PROP(inst, device), legacy_prop, 0))
+
 #define VESC_CAN_ACTUATORS_DEFINE(inst)                                                            \
 	static struct actuator_vesc_can g_actuator_vesc_cans_##inst[] = {                          \
 		DT_FOREACH_CHILD(DT_DRV_INST(inst), VESC_CAN_ACTUATOR_DEFINE)};                    \
+	static struct can_frame g_tx_frames_##inst[DT_CHILD_NUM(DT_DRV_INST(inst))];               \
 	static K_THREAD_STACK_DEFINE(g_my_stack_area_##inst, MY_STACK_SIZE);                       \
 	static struct context data_##inst = {                                                      \
 		.actuators = synapse_pb_Actuators_init_default,                                    \
@@ -361,6 +655,7 @@ static int actuate_vesc_can_device_init(const struct device *dev)
 		.node = {},                                                                        \
 		.sub_status = {},                                                                  \
 		.sub_actuators = {},                                                               \
+		.pub_esc_telemetry = {},                                                           \
 		.running = Z_SEM_INITIALIZER(data_##inst.running, 1, 1),                           \
 		.stack_size = MY_STACK_SIZE,                                                       \
 		.stack_area = g_my_stack_area_##inst,                                              \
@@ -371,6 +666,9 @@ static int actuate_vesc_can_device_init(const struct device *dev)
 		.ready = false,                                                                    \
 		.fd = DT_INST_PROP(inst, fd),                                                      \
 		.status_rate = DT_INST_PROP(inst, status_rate),                                    \
+		.bitrate = VESC_CAN_BITRATE(inst, bitrate, bus_speed),                             \
+		.bitrate_data = VESC_CAN_BITRATE(inst, bitrate_data, bus_speed_data),              \
+		.tx_frames = g_tx_frames_##inst,                                                   \
 		.enable_pub_wheel_odom = DT_INST_PROP(inst, pub_wheel_odometry),                   \
 		.label = DT_NODE_FULL_NAME(DT_DRV_INST(inst)),                                     \
 	};                                                                                         \
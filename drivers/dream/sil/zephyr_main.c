@@ -20,6 +20,7 @@
 #include <zros/zros_node.h>
 #include <zros/zros_sub.h>
 
+#include <synapse_frame.h>
 #include <synapse_topic_list.h>
 
 #define RX_BUF_SIZE   8192
@@ -100,7 +101,7 @@ static void handle_frame(struct context *ctx)
 			stamp_msg(&clock_offset->stamp, k_uptime_ticks());
 			clock_offset->offset.seconds = sim_clock->sim.seconds;
 			clock_offset->offset.nanos = sim_clock->sim.nanos;
-			zros_topic_publish(&topic_clock_offset_ethernet, clock_offset);
+			synapse_topic_publish(SYNAPSE_TOPIC_clock_offset_ethernet, clock_offset);
 		}
 
 		// compute board time
@@ -129,18 +130,8 @@ static void handle_frame(struct context *ctx)
 		if (wait_usec > 0) {
 			k_usleep(wait_usec);
 		}
-	} else if (frame->which_msg == synapse_pb_Frame_nav_sat_fix_tag) {
-		zros_topic_publish(&topic_nav_sat_fix, &frame->msg.nav_sat_fix);
-	} else if (frame->which_msg == synapse_pb_Frame_imu_tag) {
-		zros_topic_publish(&topic_imu, &frame->msg.imu);
-	} else if (frame->which_msg == synapse_pb_Frame_magnetic_field_tag) {
-		zros_topic_publish(&topic_magnetic_field, &frame->msg.magnetic_field);
-	} else if (frame->which_msg == synapse_pb_Frame_battery_state_tag) {
-		zros_topic_publish(&topic_battery_state, &frame->msg.battery_state);
-	} else if (frame->which_msg == synapse_pb_Frame_wheel_odometry_tag) {
-		zros_topic_publish(&topic_wheel_odometry, &frame->msg.wheel_odometry);
-	} else if (frame->which_msg == synapse_pb_Frame_odometry_tag) {
-		zros_topic_publish(&topic_odometry_ethernet, &frame->msg.odometry);
+	} else if (synapse_frame_publish(frame, true) == -ENOENT) {
+		LOG_DBG("unhandled message: %d", frame->which_msg);
 	}
 }
 
@@ -332,8 +332,8 @@ static void accel_processing_callback(int result, uint8_t *buf, uint32_t buf_len
 		q31_to_double(accel_out[2], ctx->imu_q31_array.accel_shift);
 
 	if (gyro_updated || accel_updated) {
-		zros_pub_update(&ctx->pub_imu);
-		zros_pub_update(&ctx->pub_imu_q31_array);
+		synapse_pub_update(&ctx->pub_imu, SYNAPSE_TOPIC_imu);
+		synapse_pub_update(&ctx->pub_imu_q31_array, SYNAPSE_TOPIC_imu_q31_array);
 	}
 }
 
@@ -12,6 +12,9 @@
 
 #include <synapse_topic_list.h>
 
+#include <cerebri/core/sensor_bus.h>
+#include <cerebri/core/sensor_vote.h>
+
 #include <zephyr/device.h>
 #include <zephyr/drivers/sensor.h>
 #include <zephyr/logging/log.h>
@@ -20,31 +23,47 @@
 
 LOG_MODULE_REGISTER(sense_baro, CONFIG_CEREBRI_SENSE_BARO_LOG_LEVEL);
 
-#define MY_STACK_SIZE 4096
-#define MY_PRIORITY   6
+#define MY_STACK_SIZE  4096
+#define MY_PRIORITY    6
+#define BARO_PERIOD_MS 100
+
+// pressure to altitude table, altitude per kelvin of temperature every 0.25 kPa
+#define ALT_TABLE_PRESS_MIN  30.0f
+#define ALT_TABLE_PRESS_STEP 0.25f
+#define ALT_TABLE_SIZE       321
+#define SEA_PRESS            101.325f
+#define LAPSE_RATE           0.0065f
+// standard atmosphere temp in C, used if the barometers do not report temperature
+#define TEMP_DEFAULT         15.0f
+
+// alpha beta filter gains for the baro only vertical velocity
+#define ALPHA 0.5f
+#define BETA  0.1f
 
-void baro_timer_handler(struct k_timer *dummy);
-void baro_work_handler(struct k_work *work);
+static float g_alt_table[ALT_TABLE_SIZE];
 
 typedef struct context_t {
-	// work
-	struct k_work work_item;
-	struct k_timer timer;
+	// bus reads
+	struct sensor_bus_group group;
 	// node
 	struct zros_node node;
 	// data
 	synapse_pb_Altimeter altimeter;
 	// publications
 	struct zros_pub pub;
-	// devices
-	const struct device *baro_dev[CONFIG_CEREBRI_SENSE_BARO_COUNT];
-	// raw readings
-	double baro_raw[CONFIG_CEREBRI_SENSE_BARO_COUNT];
+	// redundant barometers
+	struct sensor_vote vote;
+	// altitude of the first sample, published as the vertical reference
+	bool has_reference;
+	float alt_ref;
+	// alpha beta filter states
+	float alt;
+	float vel;
+	int64_t ticks_last;
 } context_t;
 
 static context_t g_ctx = {
-	.work_item = Z_WORK_INITIALIZER(baro_work_handler),
-	.timer = Z_TIMER_INITIALIZER(g_ctx.timer, baro_timer_handler, NULL),
+	.group = {},
 	.node = {},
 	.altimeter =
 		{
@@ -54,95 +73,143 @@ static context_t g_ctx = {
 			.vertical_reference = 0,
 			.vertical_velocity = 0,
 		},
-	.baro_dev = {},
-	.baro_raw = {},
+	.vote = {},
 };
 
-extern struct k_work_q g_low_priority_work_q;
+SENSOR_DT_READ_IODEV(baro_iodev0, DT_ALIAS(baro0), {SENSOR_CHAN_PRESS, 0},
+		     {SENSOR_CHAN_AMBIENT_TEMP, 0});
+#if CONFIG_CEREBRI_SENSE_BARO_COUNT >= 2
+SENSOR_DT_READ_IODEV(baro_iodev1, DT_ALIAS(baro1), {SENSOR_CHAN_PRESS, 0},
+		     {SENSOR_CHAN_AMBIENT_TEMP, 0});
+#endif
+#if CONFIG_CEREBRI_SENSE_BARO_COUNT >= 3
+SENSOR_DT_READ_IODEV(baro_iodev2, DT_ALIAS(baro2), {SENSOR_CHAN_PRESS, 0},
+		     {SENSOR_CHAN_AMBIENT_TEMP, 0});
+#endif
+#if CONFIG_CEREBRI_SENSE_BARO_COUNT >= 4
+SENSOR_DT_READ_IODEV(baro_iodev3, DT_ALIAS(baro3), {SENSOR_CHAN_PRESS, 0},
+		     {SENSOR_CHAN_AMBIENT_TEMP, 0});
+#endif
 
-static const struct device *sensor_check(const struct device *const dev)
+static struct rtio_iodev *const g_iodevs[] = {
+	&baro_iodev0,
+#if CONFIG_CEREBRI_SENSE_BARO_COUNT >= 2
+	&baro_iodev1,
+#endif
+#if CONFIG_CEREBRI_SENSE_BARO_COUNT >= 3
+	&baro_iodev2,
+#endif
+#if CONFIG_CEREBRI_SENSE_BARO_COUNT >= 4
+	&baro_iodev3,
+#endif
+};
+
+static float baro_alt_per_kelvin(float press)
 {
-	if (dev == NULL) {
-		/* No such node, or the node does not have status "okay". */
-		LOG_ERR("no device found");
-		return NULL;
-	}
+	return (powf(SEA_PRESS / press, 1 / 5.257f) - 1.0f) / LAPSE_RATE;
+}
 
-	if (!device_is_ready(dev)) {
-		LOG_ERR("device %s is not ready, check the driver initialization logs for errors",
-			dev->name);
-		return NULL;
+static void baro_alt_table_init(void)
+{
+	for (int i = 0; i < ALT_TABLE_SIZE; i++) {
+		float press = ALT_TABLE_PRESS_MIN + i * ALT_TABLE_PRESS_STEP;
+		g_alt_table[i] = baro_alt_per_kelvin(press);
 	}
+}
 
-	LOG_INF("baro found device %s", dev->name);
-	return dev;
+// hypsometric altitude, linear interpolation of the table inside its range
+static float baro_altitude(float press, float temp)
+{
+	float x = (press - ALT_TABLE_PRESS_MIN) / ALT_TABLE_PRESS_STEP;
+	float alt_per_kelvin;
+	if (x >= 0 && x < ALT_TABLE_SIZE - 1) {
+		int i = (int)x;
+		float f = x - i;
+		alt_per_kelvin = g_alt_table[i] + f * (g_alt_table[i + 1] - g_alt_table[i]);
+	} else {
+		alt_per_kelvin = baro_alt_per_kelvin(press);
+	}
+	return alt_per_kelvin * (temp + 273.15f);
 }
 
-void baro_work_handler(struct k_work *work_item)
+// runs in the sensor bus thread once all barometers were read
+static void baro_bus_handler(struct sensor_bus_group *group)
 {
-	context_t *ctx = CONTAINER_OF(work_item, context_t, work_item);
-	double baro_data_array[CONFIG_CEREBRI_SENSE_BARO_COUNT][2] = {};
-	for (int i = 0; i < CONFIG_CEREBRI_SENSE_BARO_COUNT; i++) {
-		// default all data to zero
-		struct sensor_value baro_press = {};
-		struct sensor_value baro_temp = {};
-
-		// get accel if device present
-		if (ctx->baro_dev[i] != NULL) {
-			sensor_sample_fetch(ctx->baro_dev[i]);
-			sensor_channel_get(ctx->baro_dev[i], SENSOR_CHAN_PRESS, &baro_press);
-			sensor_channel_get(ctx->baro_dev[i], SENSOR_CHAN_AMBIENT_TEMP, &baro_temp);
-			LOG_DBG("baro %d: %d.%06d %d.%06d", i, baro_press.val1, baro_press.val2,
-				baro_temp.val1, baro_temp.val2);
+	context_t *ctx = CONTAINER_OF(group, context_t, group);
+	float temp_sum = 0;
+	int temp_count = 0;
+	for (size_t i = 0; i < group->count; i++) {
+		float value;
+		int rc = sensor_bus_decode(&group->read[i], SENSOR_CHAN_PRESS, &value);
+		if (rc == 0) {
+			sensor_vote_set(&ctx->vote, i, &value);
+		} else if (rc != -EAGAIN) {
+			sensor_vote_error(&ctx->vote, i, rc);
 		}
+		if (rc == 0 &&
+		    sensor_bus_decode(&group->read[i], SENSOR_CHAN_AMBIENT_TEMP, &value) == 0) {
+			temp_sum += value;
+			temp_count++;
+		}
+	}
 
-		baro_data_array[i][0] = baro_press.val1 + baro_press.val2 * 1e-6;
-		baro_data_array[i][1] = baro_temp.val1 + baro_temp.val2 * 1e-6;
+	float press = 0;
+	if (sensor_vote_update(&ctx->vote, &press) < 0) {
+		LOG_DBG("no baro data");
+		return;
 	}
 
-	// select first baro for data for now: TODO implement voting
-	// TODO add barmetric formula equation
-	double press = baro_data_array[0][0];
-	double temp = 15.0; // standard atmosphere temp in C
-	const double sea_press = 101.325;
-	double alt = ((pow((sea_press / press), 1 / 5.257) - 1.0) * (temp + 273.15)) / 0.0065;
+	float temp = temp_count > 0 ? temp_sum / temp_count : TEMP_DEFAULT;
+	float alt = baro_altitude(press, temp);
 	// LOG_DBG("press %10.4f, temp: %10.4f, alt: %10.4f", press, temp, alt);
 
+	int64_t now = k_uptime_ticks();
+	float dt = (float)(now - ctx->ticks_last) / CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+	if (!ctx->has_reference || dt <= 0 || dt > 10 * BARO_PERIOD_MS * 1e-3f) {
+		// first sample or long gap, restart the filter
+		if (!ctx->has_reference) {
+			ctx->has_reference = true;
+			ctx->alt_ref = alt;
+		}
+		ctx->alt = alt;
+		ctx->vel = 0;
+	} else {
+		// alpha beta filter, the estimator fuses the position with the imu
+		ctx->alt += ctx->vel * dt;
+		float r = alt - ctx->alt;
+		ctx->alt += ALPHA * r;
+		ctx->vel += BETA * r / dt;
+	}
+	ctx->ticks_last = now;
+
 	// publish altimeter
-	ctx->altimeter.vertical_reference = alt;
-	stamp_header(&ctx->altimeter.header, k_uptime_ticks());
+	stamp_header(&ctx->altimeter.header, now);
 	ctx->altimeter.header.seq++;
+	// absolute altitude, consumers subtract the reference for a relative one
 	ctx->altimeter.vertical_position = alt;
-	ctx->altimeter.vertical_velocity = 0;
-	ctx->altimeter.vertical_reference = 0;
-	zros_pub_update(&ctx->pub);
-}
-
-K_WORK_DEFINE(baro_work, baro_work_handler);
-
-void baro_timer_handler(struct k_timer *dummy)
-{
-	k_work_submit_to_queue(&g_low_priority_work_q, &baro_work);
+	ctx->altimeter.vertical_velocity = ctx->vel;
+	ctx->altimeter.vertical_reference = ctx->alt_ref;
+	synapse_pub_update(&ctx->pub, SYNAPSE_TOPIC_altimeter);
 }
 
-K_TIMER_DEFINE(baro_timer, baro_timer_handler, NULL);
-
 int sense_baro_entry_point(void *p0, void *p1, void *p2)
 {
 	LOG_INF("init");
 	context_t *ctx = p0;
 	ARG_UNUSED(p1);
 	ARG_UNUSED(p2);
-	ctx->baro_dev[0] = sensor_check(DEVICE_DT_GET(DT_ALIAS(baro0)));
-#if CONFIG_CEREBRI_SENSE_BARO_COUNT >= 2
-	ctx->baro_dev[1] = sensor_check(DEVICE_DT_GET(DT_ALIAS(baro1)));
-#elif CONFIG_CEREBRI_SENSE_BARO_COUNT >= 3
-	ctx->baro_dev[2] = sensor_check(DEVICE_DT_GET(DT_ALIAS(baro2)));
-#elif CONFIG_CEREBRI_SENSE_BARO_COUNT == 4
-	ctrx->baro_dev[3] = sensor_check(DEVICE_DT_GET(DT_ALIAS(baro3)));
-#endif
+	baro_alt_table_init();
+	sensor_vote_init(&ctx->vote, "baro", SENSOR_CHAN_PRESS, 1, 5 * BARO_PERIOD_MS,
+			 CONFIG_CEREBRI_SENSE_BARO_MAX_DEVIATION_PA * 1e-3f);
+	sensor_bus_group_init(&ctx->group, "baro", baro_bus_handler, BARO_PERIOD_MS);
+	for (int i = 0; i < ARRAY_SIZE(g_iodevs); i++) {
+		// vote instances and bus reads share their index
+		if (sensor_vote_add(&ctx->vote, sensor_bus_device(g_iodevs[i])) == 0) {
+			sensor_bus_group_add_read(&ctx->group, g_iodevs[i]);
+		}
+	}
 
-	k_timer_start(&baro_timer, K_MSEC(100), K_MSEC(100));
+	sensor_bus_add(&ctx->group);
 	return 0;
 }
 
@@ -7,10 +7,12 @@
 #include <zephyr/device.h>
 #include <zephyr/drivers/sensor.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
 
 // #include <cerebri/core/casadi.h>
 #include <cerebri/core/common.h>
 #include <cerebri/core/perf_duration.h>
+#include <cerebri/core/sensor_decode.h>
 
 #include <synapse_topic_list.h>
 
@@ -25,15 +27,52 @@ LOG_MODULE_REGISTER(sense_imu, CONFIG_CEREBRI_SENSE_IMU_LOG_LEVEL);
 
 #define THREAD_STACK_SIZE 1024
 #define THREAD_PRIORITY   6
-
-static const double g_accel = 9.8;
-static const int g_calibration_count = 100;
+#define IMU_BUF_SIZE      128
+
+// temperature bias table, bins of TEMP_BIN_C starting at TEMP_MIN_C
+#define TEMP_MIN_C         -40
+#define TEMP_BIN_C         5
+#define TEMP_BINS          28
+// read the die temperature every 1 s at the 5 ms imu period
+#define TEMP_READ_INTERVAL 200
+// consecutive failed die temperature reads before compensation is disabled
+#define TEMP_FAIL_MAX      5
+// fraction of each stationary window mean blended into the gyro bias
+#define BIAS_GAIN          0.125f
+
+static const float g_accel = 9.8f;
+static const uint32_t g_calibration_count = CONFIG_CEREBRI_SENSE_IMU_CALIBRATION_SAMPLES;
+static const float g_gyro_std_max = CONFIG_CEREBRI_SENSE_IMU_GYRO_STD_MAX_MRAD_S * 1e-3f;
+static const float g_accel_std_max = CONFIG_CEREBRI_SENSE_IMU_ACCEL_STD_MAX_MM_S2 * 1e-3f;
+static const float g_gyro_bias_step_max = CONFIG_CEREBRI_SENSE_IMU_GYRO_BIAS_STEP_MRAD_S * 1e-3f;
+static const float g_gyro_bias_drift_max = CONFIG_CEREBRI_SENSE_IMU_GYRO_BIAS_DRIFT_MRAD_S * 1e-3f;
+
+// accel and gyro on one device are read together to share the timestamp
+SENSOR_DT_READ_IODEV(imu_iodev, DT_ALIAS(accel0), {SENSOR_CHAN_ACCEL_XYZ, 0},
+		     {SENSOR_CHAN_GYRO_XYZ, 0});
+SENSOR_DT_READ_IODEV(imu_accel_iodev, DT_ALIAS(accel0), {SENSOR_CHAN_ACCEL_XYZ, 0});
+SENSOR_DT_READ_IODEV(imu_gyro_iodev, DT_ALIAS(gyro0), {SENSOR_CHAN_GYRO_XYZ, 0});
+SENSOR_DT_READ_IODEV(imu_temp_iodev, DT_ALIAS(gyro0), {SENSOR_CHAN_DIE_TEMP, 0});
+
+RTIO_DEFINE(imu_rtio, 1, 1);
 
 extern struct perf_duration control_latency;
 extern struct k_work_q g_high_priority_work_q;
 static void imu_work_handler(struct k_work *work);
 static void imu_timer_handler(struct k_timer *dummy);
 
+// running mean and sum of squared deviations per axis
+struct welford {
+	uint32_t n;
+	float mean[3];
+	float m2[3];
+};
+
+struct temp_bias {
+	bool valid;
+	float gyro[3];
+};
+
 typedef struct context_t {
 	// work
 	struct k_work work_item;
@@ -51,14 +90,33 @@ typedef struct context_t {
 	struct zros_sub sub_status;
 	// gyro
 	const struct device *gyro_dev;
-	double gyro_raw[3];
-	double gyro_bias[3];
+	float gyro_raw[3];
+	float gyro_bias[3];
+	// bias of the last accepted calibration, online updates stay near it
+	float gyro_bias_calibrated[3];
 
 	// accel
 	const struct device *accel_dev;
-	double accel_raw[3];
-	double accel_bias[3];
-	double accel_scale;
+	float accel_raw[3];
+	float accel_bias[3];
+	float accel_scale;
+
+	// calibration, one sample per work item
+	struct welford gyro_stats;
+	struct welford accel_stats;
+	uint32_t rejects;
+	uint32_t bias_updates;
+
+	// temperature compensation
+	bool temp_available;
+	bool temp_valid;
+	float temp;
+	uint32_t temp_countdown;
+	uint32_t temp_failures;
+	struct temp_bias temp_bias[TEMP_BINS];
+
+	// encoded sensor data
+	uint8_t buf[IMU_BUF_SIZE];
 
 	// 2nd order butterworth filter states
 } context_t;
@@ -85,11 +143,39 @@ static context_t g_ctx = {
 	.gyro_dev = NULL,
 	.gyro_raw = {},
 	.gyro_bias = {},
+	.gyro_bias_calibrated = {},
 	.accel_dev = NULL,
 	.accel_raw = {},
 	.accel_bias = {},
+	.accel_scale = 1,
+	.temp_available = true,
 };
 
+static void welford_reset(struct welford *w)
+{
+	*w = (struct welford){};
+}
+
+static void welford_update(struct welford *w, const float *x)
+{
+	w->n++;
+	for (int k = 0; k < 3; k++) {
+		float d = x[k] - w->mean[k];
+		w->mean[k] += d / w->n;
+		w->m2[k] += d * (x[k] - w->mean[k]);
+	}
+}
+
+static float welford_std(const struct welford *w, int k)
+{
+	return w->n > 0 ? sqrtf(w->m2[k] / w->n) : 0;
+}
+
+static float welford_std_max(const struct welford *w)
+{
+	return MAX(welford_std(w, 0), MAX(welford_std(w, 1), welford_std(w, 2)));
+}
+
 static void imu_init(context_t *ctx)
 {
 	LOG_INF("init");
@@ -97,7 +183,7 @@ static void imu_init(context_t *ctx)
 	// initialize node
 	zros_node_init(&ctx->node, "sense_imu");
 	zros_pub_init(&ctx->pub_imu, &ctx->node, &topic_imu, &ctx->imu);
-	zros_sub_init(&ctx->sub_status, &ctx->node, &topic_status, &ctx->status, 1);
+	zros_sub_init(&ctx->sub_status, &ctx->node, &topic_status, &ctx->status, 10);
 
 	// setup accel devices
 	ctx->accel_dev = get_device(DEVICE_DT_GET(DT_ALIAS(accel0)));
@@ -106,161 +192,216 @@ static void imu_init(context_t *ctx)
 	ctx->gyro_dev = get_device(DEVICE_DT_GET(DT_ALIAS(gyro0)));
 }
 
-void imu_read(context_t *ctx)
+// read through the driver decoder, q31 samples are scaled once per channel in float
+static int imu_read_iodev(context_t *ctx, struct rtio_iodev *iodev, const struct device *dev,
+			  enum sensor_channel chan, float *value)
+{
+	int rc = sensor_read(iodev, &imu_rtio, ctx->buf, sizeof(ctx->buf));
+	if (rc < 0) {
+		return rc;
+	}
+	return sensor_decode_float(dev, ctx->buf, chan, value);
+}
+
+static int imu_read(context_t *ctx)
 {
-	// default all data to zero
-	struct sensor_value accel_value[3] = {};
-	struct sensor_value gyro_value[3] = {};
-
-	// get accel if device present
-	if (ctx->accel_dev != NULL) {
-		sensor_sample_fetch(ctx->accel_dev);
-		sensor_channel_get(ctx->accel_dev, SENSOR_CHAN_ACCEL_XYZ, accel_value);
-		for (int j = 0; j < 3; j++) {
-			ctx->accel_raw[j] = accel_value[j].val1 + accel_value[j].val2 * 1e-6;
-
-			if (ctx->accel_raw[j] > 15 * g_accel || ctx->accel_raw[j] < -15 * g_accel) {
-				LOG_ERR("accel saturating: %d: %10.4f", j, ctx->accel_raw[j]);
-				continue;
-			}
+	int rc = 0;
+
+	if (ctx->accel_dev != NULL && ctx->accel_dev == ctx->gyro_dev) {
+		rc = sensor_read(&imu_iodev, &imu_rtio, ctx->buf, sizeof(ctx->buf));
+		if (rc == 0) {
+			rc = sensor_decode_float(ctx->accel_dev, ctx->buf, SENSOR_CHAN_ACCEL_XYZ,
+						 ctx->accel_raw);
+		}
+		if (rc == 0) {
+			rc = sensor_decode_float(ctx->gyro_dev, ctx->buf, SENSOR_CHAN_GYRO_XYZ,
+						 ctx->gyro_raw);
+		}
+	} else {
+		if (ctx->accel_dev != NULL) {
+			rc = imu_read_iodev(ctx, &imu_accel_iodev, ctx->accel_dev,
+					    SENSOR_CHAN_ACCEL_XYZ, ctx->accel_raw);
+		}
+		if (rc == 0 && ctx->gyro_dev != NULL) {
+			rc = imu_read_iodev(ctx, &imu_gyro_iodev, ctx->gyro_dev,
+					    SENSOR_CHAN_GYRO_XYZ, ctx->gyro_raw);
 		}
 	}
+	if (rc < 0) {
+		LOG_ERR("imu read failed: %d", rc);
+		return rc;
+	}
 
-	// get gyro if device present
-	if (ctx->gyro_dev != NULL) {
-		// don't resample if it is the same device as accel, want same timestamp
-		if (ctx->gyro_dev != ctx->accel_dev) {
-			sensor_sample_fetch(ctx->gyro_dev);
+	for (int j = 0; j < 3; j++) {
+		if (ctx->accel_raw[j] > 15 * g_accel || ctx->accel_raw[j] < -15 * g_accel) {
+			LOG_ERR("accel saturating: %d: %10.4f", j, (double)ctx->accel_raw[j]);
 		}
-		sensor_channel_get(ctx->gyro_dev, SENSOR_CHAN_GYRO_XYZ, gyro_value);
-		for (int j = 0; j < 3; j++) {
-			ctx->gyro_raw[j] = gyro_value[j].val1 + gyro_value[j].val2 * 1e-6;
-
-			if (ctx->gyro_raw[j] > 34 || ctx->gyro_raw[j] < -34) {
-				LOG_ERR("gyro saturating: %d: %10.4f", j, ctx->gyro_raw[j]);
-				continue;
-			}
+		if (ctx->gyro_raw[j] > 34 || ctx->gyro_raw[j] < -34) {
+			LOG_ERR("gyro saturating: %d: %10.4f", j, (double)ctx->gyro_raw[j]);
 		}
 	}
+	return 0;
 }
 
-void imu_calibrate(context_t *ctx)
+static void imu_read_temp(context_t *ctx)
 {
-	// data
-	double accel_samples[g_calibration_count][3];
-	double gyro_samples[g_calibration_count][3];
-
-	// mean and std
-	double accel_mean[3];
-	double gyro_mean[3];
-	double accel_std[3];
-	double gyro_std[3];
-
-	// repeat until calibrated
-	while (true) {
-
-		LOG_INF("calibration started, keep level, don't move");
-
-		// reset sum to zero
-		memset(gyro_samples, 0, sizeof(gyro_samples));
-		memset(accel_samples, 0, sizeof(accel_samples));
-		memset(accel_mean, 0, sizeof(accel_mean));
-		memset(accel_std, 0, sizeof(accel_std));
-		memset(gyro_mean, 0, sizeof(gyro_mean));
-		memset(gyro_std, 0, sizeof(gyro_std));
-
-		// attempt to get samples
-		for (int i = 0; i < g_calibration_count; i++) {
-			k_msleep(5);
-			imu_read(ctx);
-
-			// get accel data
-			for (int k = 0; k < 3; k++) {
-				accel_samples[i][k] = ctx->accel_raw[k];
-				accel_mean[k] += accel_samples[i][k];
-			}
-
-			// get gyro data
-			for (int k = 0; k < 3; k++) {
-				gyro_samples[i][k] = ctx->gyro_raw[k];
-				gyro_mean[k] += gyro_samples[i][k];
-			}
-		}
-
-		// find accel mean
-		for (int k = 0; k < 3; k++) {
-			accel_mean[k] /= g_calibration_count;
+	if (!ctx->temp_available || ctx->gyro_dev == NULL) {
+		return;
+	}
+	if (ctx->temp_countdown > 0) {
+		ctx->temp_countdown--;
+		return;
+	}
+	ctx->temp_countdown = TEMP_READ_INTERVAL;
+
+	float temp;
+	int rc = imu_read_iodev(ctx, &imu_temp_iodev, ctx->gyro_dev, SENSOR_CHAN_DIE_TEMP, &temp);
+	if (rc < 0) {
+		// a transient failure keeps the last temperature, a driver without
+		// die temperature or a sensor failing repeatedly keeps a single bias
+		if (rc == -ENOTSUP || ++ctx->temp_failures >= TEMP_FAIL_MAX) {
+			LOG_INF("no die temperature, thermal compensation disabled: %d", rc);
+			ctx->temp_available = false;
+			ctx->temp_valid = false;
 		}
+		return;
+	}
+	ctx->temp_failures = 0;
+	ctx->temp = temp;
+	ctx->temp_valid = true;
+}
 
-		// find gyro mean
-		for (int k = 0; k < 3; k++) {
-			gyro_mean[k] /= g_calibration_count;
-		}
+static struct temp_bias *imu_temp_bin(context_t *ctx)
+{
+	if (!ctx->temp_valid) {
+		return NULL;
+	}
+	int i = (int)floorf((ctx->temp - TEMP_MIN_C) / TEMP_BIN_C);
+	return &ctx->temp_bias[CLAMP(i, 0, TEMP_BINS - 1)];
+}
 
-		// find std deviation
-		for (int i = 0; i < g_calibration_count; i++) {
-			for (int k = 0; k < 3; k++) {
-				double e = accel_samples[i][k] - accel_mean[k];
-				accel_std[k] += e * e;
-			}
-
-			// get gyro data
-			for (int k = 0; k < 3; k++) {
-				double e = gyro_samples[i][k] - gyro_mean[k];
-				gyro_std[k] += e * e;
-			}
-		}
+// bias learned at the current temperature, the last estimate otherwise
+static const float *imu_gyro_bias(context_t *ctx)
+{
+	struct temp_bias *bin = imu_temp_bin(ctx);
+	return bin != NULL && bin->valid ? bin->gyro : ctx->gyro_bias;
+}
 
-		for (int k = 0; k < 3; k++) {
-			accel_std[k] = sqrt(accel_std[k] / g_calibration_count);
+static void imu_store_gyro_bias(context_t *ctx, const float *bias)
+{
+	struct temp_bias *bin = imu_temp_bin(ctx);
+	for (int k = 0; k < 3; k++) {
+		ctx->gyro_bias[k] = bias[k];
+		if (bin != NULL) {
+			bin->gyro[k] = bias[k];
 		}
+	}
+	if (bin != NULL) {
+		bin->valid = true;
+	}
+}
 
-		for (int k = 0; k < 3; k++) {
-			gyro_std[k] = sqrt(gyro_std[k] / g_calibration_count);
-		}
+static void imu_calibration_restart(context_t *ctx)
+{
+	welford_reset(&ctx->gyro_stats);
+	welford_reset(&ctx->accel_stats);
+}
 
-		// check if calibration acceptable, and break if it is
-		// TODO implement calibration check
-		break;
+// accept a full calibration window if the vehicle was still and the accel reads about 1 g
+static void imu_calibration_finish(context_t *ctx)
+{
+	const float *accel_mean = ctx->accel_stats.mean;
+	const float *gyro_mean = ctx->gyro_stats.mean;
+	float gyro_std = welford_std_max(&ctx->gyro_stats);
+	float accel_std = welford_std_max(&ctx->accel_stats);
+	float accel_norm = sqrtf(accel_mean[0] * accel_mean[0] + accel_mean[1] * accel_mean[1] +
+				 accel_mean[2] * accel_mean[2]);
+
+	if (gyro_std > g_gyro_std_max || accel_std > g_accel_std_max ||
+	    fabsf(accel_norm - g_accel) > 0.2f * g_accel) {
+		ctx->rejects++;
+		LOG_WRN("calibration rejected, keep level, don't move: gyro std %10.4f accel std "
+			"%10.4f norm %10.4f",
+			(double)gyro_std, (double)accel_std, (double)accel_norm);
+		imu_calibration_restart(ctx);
+		return;
 	}
 
 	LOG_INF("calibration completed");
 	ctx->accel_bias[0] = accel_mean[0];
 	ctx->accel_bias[1] = accel_mean[1];
 	ctx->accel_bias[2] = 0;
-	ctx->accel_scale = sqrt(accel_mean[0] * accel_mean[0] + accel_mean[1] * accel_mean[1] +
-				accel_mean[2] * accel_mean[2]) /
-			   g_accel;
+	ctx->accel_scale = accel_norm / g_accel;
 	LOG_INF("accel");
-	LOG_INF("mean: %10.4f %10.4f %10.4f", accel_mean[0], accel_mean[1], accel_mean[2]);
-	LOG_INF("std: %10.4f %10.4f %10.4f", accel_std[0], accel_std[1], accel_std[2]);
-	LOG_INF("scale %10.4f", ctx->accel_scale);
+	LOG_INF("mean: %10.4f %10.4f %10.4f", (double)accel_mean[0], (double)accel_mean[1],
+		(double)accel_mean[2]);
+	LOG_INF("std: %10.4f %10.4f %10.4f", (double)welford_std(&ctx->accel_stats, 0),
+		(double)welford_std(&ctx->accel_stats, 1),
+		(double)welford_std(&ctx->accel_stats, 2));
+	LOG_INF("scale %10.4f", (double)ctx->accel_scale);
 
 	LOG_INF("gyro");
-	LOG_INF("mean: %10.4f %10.4f %10.4f", gyro_mean[0], gyro_mean[1], gyro_mean[2]);
-	LOG_INF("std: %10.4f %10.4f %10.4f", gyro_std[0], gyro_std[1], gyro_std[2]);
+	LOG_INF("mean: %10.4f %10.4f %10.4f", (double)gyro_mean[0], (double)gyro_mean[1],
+		(double)gyro_mean[2]);
+	LOG_INF("std: %10.4f %10.4f %10.4f", (double)welford_std(&ctx->gyro_stats, 0),
+		(double)welford_std(&ctx->gyro_stats, 1),
+		(double)welford_std(&ctx->gyro_stats, 2));
 	for (int k = 0; k < 3; k++) {
-		ctx->gyro_bias[k] = gyro_mean[k];
+		ctx->gyro_bias_calibrated[k] = gyro_mean[k];
 	}
+	imu_store_gyro_bias(ctx, gyro_mean);
+	imu_calibration_restart(ctx);
 	ctx->calibrated = true;
 }
 
-void imu_publish(context_t *ctx)
+// while disarmed and stationary, blend each window mean into the gyro bias to track drift
+static void imu_bias_update(context_t *ctx)
 {
+	const float *bias = imu_gyro_bias(ctx);
+	const float *gyro_mean = ctx->gyro_stats.mean;
+	float step = 0;
+
+	if (ctx->status.arming != synapse_pb_Status_Arming_ARMING_DISARMED) {
+		return;
+	}
+
+	for (int k = 0; k < 3; k++) {
+		step = MAX(step, fabsf(gyro_mean[k] - bias[k]));
+	}
+
+	// a steady rotation also has a low std, only follow small bias changes
+	if (welford_std_max(&ctx->gyro_stats) > g_gyro_std_max ||
+	    welford_std_max(&ctx->accel_stats) > g_accel_std_max || step > g_gyro_bias_step_max) {
+		return;
+	}
+
+	// steps within the limit must not add up to a large drift from calibration
+	float next[3];
+	for (int k = 0; k < 3; k++) {
+		next[k] = CLAMP(bias[k] + BIAS_GAIN * (gyro_mean[k] - bias[k]),
+				ctx->gyro_bias_calibrated[k] - g_gyro_bias_drift_max,
+				ctx->gyro_bias_calibrated[k] + g_gyro_bias_drift_max);
+	}
+	imu_store_gyro_bias(ctx, next);
+	ctx->bias_updates++;
+}
+
+static void imu_publish(context_t *ctx)
+{
+	float accel_gain = 1.0f / ctx->accel_scale;
+	const float *gyro_bias = imu_gyro_bias(ctx);
+
 	// update message
 	stamp_msg(&ctx->imu.stamp, k_uptime_ticks());
-	ctx->imu.angular_velocity.x = ctx->gyro_raw[0] - ctx->gyro_bias[0];
-	ctx->imu.angular_velocity.y = ctx->gyro_raw[1] - ctx->gyro_bias[1];
-	ctx->imu.angular_velocity.z = ctx->gyro_raw[2] - ctx->gyro_bias[2];
-	ctx->imu.linear_acceleration.x =
-		(ctx->accel_raw[0] - ctx->accel_bias[0]) / ctx->accel_scale;
-	ctx->imu.linear_acceleration.y =
-		(ctx->accel_raw[1] - ctx->accel_bias[1]) / ctx->accel_scale;
-	ctx->imu.linear_acceleration.z =
-		(ctx->accel_raw[2] - ctx->accel_bias[2]) / ctx->accel_scale;
+	ctx->imu.angular_velocity.x = ctx->gyro_raw[0] - gyro_bias[0];
+	ctx->imu.angular_velocity.y = ctx->gyro_raw[1] - gyro_bias[1];
+	ctx->imu.angular_velocity.z = ctx->gyro_raw[2] - gyro_bias[2];
+	ctx->imu.linear_acceleration.x = (ctx->accel_raw[0] - ctx->accel_bias[0]) * accel_gain;
+	ctx->imu.linear_acceleration.y = (ctx->accel_raw[1] - ctx->accel_bias[1]) * accel_gain;
+	ctx->imu.linear_acceleration.z = (ctx->accel_raw[2] - ctx->accel_bias[2]) * accel_gain;
 
 	// publish message
-	zros_pub_update(&ctx->pub_imu);
+	synapse_pub_update(&ctx->pub_imu, SYNAPSE_TOPIC_imu);
 	// LOG_INF("publish imu");
 }
 
@@ -276,18 +417,34 @@ void imu_work_handler(struct k_work *work)
 	// handle calibration request
 	if (ctx->status.mode == synapse_pb_Status_Mode_MODE_CALIBRATION &&
 	    ctx->last_mode != synapse_pb_Status_Mode_MODE_CALIBRATION) {
+		LOG_INF("calibration started, keep level, don't move");
 		ctx->calibrated = false;
+		imu_calibration_restart(ctx);
 	}
 	ctx->last_mode = ctx->status.mode;
 
+	if (imu_read(ctx) < 0) {
+		return;
+	}
+	if (ctx->calibrated) {
+		perf_duration_start(&control_latency);
+	}
+	imu_read_temp(ctx);
+
+	welford_update(&ctx->gyro_stats, ctx->gyro_raw);
+	welford_update(&ctx->accel_stats, ctx->accel_raw);
+
 	if (!ctx->calibrated) {
-		LOG_INF("calibrating");
-		imu_calibrate(ctx);
+		if (ctx->gyro_stats.n >= g_calibration_count) {
+			imu_calibration_finish(ctx);
+		}
 		return;
 	}
 
-	perf_duration_start(&control_latency);
-	imu_read(ctx);
+	if (ctx->gyro_stats.n >= g_calibration_count) {
+		imu_bias_update(ctx);
+		imu_calibration_restart(ctx);
+	}
 	imu_publish(ctx);
 }
 
@@ -302,6 +459,7 @@ int sense_imu_entry_point(context_t *ctx)
 	imu_init(ctx);
 	// delay initiali calibration 1 s
 	k_msleep(1000);
+	LOG_INF("calibration started, keep level, don't move");
 	k_timer_start(&ctx->timer, K_MSEC(5), K_MSEC(5));
 	return 0;
 }
@@ -309,4 +467,40 @@ int sense_imu_entry_point(context_t *ctx)
 K_THREAD_DEFINE(sense_imu, THREAD_STACK_SIZE, sense_imu_entry_point, &g_ctx, NULL, NULL,
 		THREAD_PRIORITY, 0, 100);
 
+static int sense_imu_cmd_calibration(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+	context_t *ctx = &g_ctx;
+
+	shell_print(sh, "calibrated %d rejects %u bias updates %u", ctx->calibrated, ctx->rejects,
+		    ctx->bias_updates);
+	shell_print(sh, "gyro bias: %10.6f %10.6f %10.6f", (double)ctx->gyro_bias[0],
+		    (double)ctx->gyro_bias[1], (double)ctx->gyro_bias[2]);
+	shell_print(sh, "accel bias: %10.4f %10.4f %10.4f scale %10.4f",
+		    (double)ctx->accel_bias[0], (double)ctx->accel_bias[1],
+		    (double)ctx->accel_bias[2], (double)ctx->accel_scale);
+	if (!ctx->temp_valid) {
+		shell_print(sh, "no die temperature");
+		return 0;
+	}
+	shell_print(sh, "die temperature: %6.1f C", (double)ctx->temp);
+	for (int i = 0; i < TEMP_BINS; i++) {
+		const struct temp_bias *bin = &ctx->temp_bias[i];
+		if (bin->valid) {
+			shell_print(sh, "  %4d C: %10.6f %10.6f %10.6f",
+				    TEMP_MIN_C + i * TEMP_BIN_C, (double)bin->gyro[0],
+				    (double)bin->gyro[1], (double)bin->gyro[2]);
+		}
+	}
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_sense_imu,
+			       SHELL_CMD(calibration, NULL, "Calibration and gyro bias table.",
+					 sense_imu_cmd_calibration),
+			       SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(sense_imu, &sub_sense_imu, "Sense imu commands.", NULL);
+
 // vi: ts=4 sw=4 et
@@ -7,6 +7,8 @@
 #include <zephyr/logging/log.h>
 
 #include <cerebri/core/common.h>
+#include <cerebri/core/sensor_bus.h>
+#include <cerebri/core/sensor_vote.h>
 
 #include <zros/private/zros_node_struct.h>
 #include <zros/private/zros_pub_struct.h>
@@ -19,20 +21,42 @@ LOG_MODULE_REGISTER(sense_mag, CONFIG_CEREBRI_SENSE_MAG_LOG_LEVEL);
 
 #define MY_STACK_SIZE 2048
 #define MY_PRIORITY   6
+#define MAG_PERIOD_MS 20
 
-extern struct k_work_q g_high_priority_work_q;
-void mag_work_handler(struct k_work *work);
+SENSOR_DT_READ_IODEV(mag_iodev0, DT_ALIAS(mag0), {SENSOR_CHAN_MAGN_XYZ, 0});
+#if CONFIG_CEREBRI_SENSE_MAG_COUNT >= 2
+SENSOR_DT_READ_IODEV(mag_iodev1, DT_ALIAS(mag1), {SENSOR_CHAN_MAGN_XYZ, 0});
+#endif
+#if CONFIG_CEREBRI_SENSE_MAG_COUNT >= 3
+SENSOR_DT_READ_IODEV(mag_iodev2, DT_ALIAS(mag2), {SENSOR_CHAN_MAGN_XYZ, 0});
+#endif
+#if CONFIG_CEREBRI_SENSE_MAG_COUNT >= 4
+SENSOR_DT_READ_IODEV(mag_iodev3, DT_ALIAS(mag3), {SENSOR_CHAN_MAGN_XYZ, 0});
+#endif
+
+static struct rtio_iodev *const g_iodevs[] = {
+	&mag_iodev0,
+#if CONFIG_CEREBRI_SENSE_MAG_COUNT >= 2
+	&mag_iodev1,
+#endif
+#if CONFIG_CEREBRI_SENSE_MAG_COUNT >= 3
+	&mag_iodev2,
+#endif
+#if CONFIG_CEREBRI_SENSE_MAG_COUNT >= 4
+	&mag_iodev3,
+#endif
+};
 
 typedef struct context {
-	struct k_work work_item;
-	const struct device *device[CONFIG_CEREBRI_SENSE_MAG_COUNT];
+	struct sensor_bus_group group;
+	struct sensor_vote vote;
 	struct zros_node node;
 	struct zros_pub pub;
 	synapse_pb_MagneticField data;
 } context_t;
 
-static context_t g_ctx = {.work_item = Z_WORK_INITIALIZER(mag_work_handler),
-			  .device = {},
+static context_t g_ctx = {.group = {},
+			  .vote = {},
 			  .node = {},
 			  .pub = {},
 			  .data = {
@@ -45,61 +69,50 @@ static context_t g_ctx = {.work_item = Z_WORK_INITIALIZER(mag_work_handler),
 				  .magnetic_field_covariance_count = 0,
 			  }};
 
-void mag_work_handler(struct k_work *work)
+// runs in the sensor bus thread once all magnetometers were read
+static void mag_bus_handler(struct sensor_bus_group *group)
 {
-	context_t *ctx = CONTAINER_OF(work, context_t, work_item);
-	double mag_data_array[CONFIG_CEREBRI_SENSE_MAG_COUNT][3] = {};
-	for (int i = 0; i < CONFIG_CEREBRI_SENSE_MAG_COUNT; i++) {
-		// default all data to zero
-		struct sensor_value mag_value[3] = {};
-
-		// get accel if device present
-		if (ctx->device[i] != NULL) {
-			sensor_sample_fetch(ctx->device[i]);
-			sensor_channel_get(ctx->device[i], SENSOR_CHAN_MAGN_XYZ, mag_value);
-			LOG_DBG("mag %d: %d.%06d %d.%06d %d.%06d", i, mag_value[0].val1,
-				mag_value[0].val2, mag_value[1].val1, mag_value[1].val2,
-				mag_value[2].val1, mag_value[2].val2);
-		}
-
-		for (int j = 0; j < 3; j++) {
-			mag_data_array[i][j] = mag_value[j].val1 + mag_value[j].val2 * 1e-6;
+	context_t *ctx = CONTAINER_OF(group, context_t, group);
+	for (size_t i = 0; i < group->count; i++) {
+		float value[3];
+		int rc = sensor_bus_decode(&group->read[i], SENSOR_CHAN_MAGN_XYZ, value);
+		if (rc == 0) {
+			sensor_vote_set(&ctx->vote, i, value);
+		} else if (rc != -EAGAIN) {
+			sensor_vote_error(&ctx->vote, i, rc);
 		}
 	}
 
-	// select first mag for data for now: TODO implement voting
-	double mag[3] = {mag_data_array[0][0], mag_data_array[0][1], mag_data_array[0][2]};
+	float mag[3] = {};
+	if (sensor_vote_update(&ctx->vote, mag) < 0) {
+		LOG_DBG("no mag data");
+		return;
+	}
 
 	// publish
 	stamp_msg(&ctx->data.stamp, k_uptime_ticks());
 	ctx->data.magnetic_field.x = mag[0];
 	ctx->data.magnetic_field.y = mag[1];
 	ctx->data.magnetic_field.z = mag[2];
-	zros_pub_update(&ctx->pub);
-}
-
-void mag_timer_handler(struct k_timer *dummy)
-{
-	k_work_submit_to_queue(&g_high_priority_work_q, &g_ctx.work_item);
+	synapse_pub_update(&ctx->pub, SYNAPSE_TOPIC_magnetic_field);
 }
 
-K_TIMER_DEFINE(mag_timer, mag_timer_handler, NULL);
-
 int sense_mag_entry_point(context_t *ctx)
 {
 	LOG_INF("init");
-	ctx->device[0] = get_device(DEVICE_DT_GET(DT_ALIAS(mag0)));
-#if CONFIG_CEREBRI_SENSE_MAG_COUNT >= 2
-	ctx->device[1] = get_device(DEVICE_DT_GET(DT_ALIAS(mag1)));
-#elif CONFIG_CEREBRI_SENSE_MAG_COUNT >= 3
-	ctx->device[2] = get_device(DEVICE_DT_GET(DT_ALIAS(mag2)));
-#elif CONFIG_CEREBRI_SENSE_MAG_COUNT >= 4
-	ctx->device[3] = get_device(DEVICE_DT_GET(DT_ALIAS(mag3)));
-#endif
+	sensor_vote_init(&ctx->vote, "mag", SENSOR_CHAN_MAGN_XYZ, 3, 5 * MAG_PERIOD_MS,
+			 CONFIG_CEREBRI_SENSE_MAG_MAX_DEVIATION_MGAUSS * 1e-3f);
+	sensor_bus_group_init(&ctx->group, "mag", mag_bus_handler, MAG_PERIOD_MS);
+	for (int i = 0; i < ARRAY_SIZE(g_iodevs); i++) {
+		// vote instances and bus reads share their index
+		if (sensor_vote_add(&ctx->vote, sensor_bus_device(g_iodevs[i])) == 0) {
+			sensor_bus_group_add_read(&ctx->group, g_iodevs[i]);
+		}
+	}
 
 	zros_node_init(&ctx->node, "sense_mag");
 	zros_pub_init(&ctx->pub, &ctx->node, &topic_magnetic_field, &ctx->data);
-	k_timer_start(&mag_timer, K_MSEC(20), K_MSEC(20));
+	sensor_bus_add(&ctx->group);
 	return 0;
 }
 
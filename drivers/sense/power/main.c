@@ -11,6 +11,9 @@
 #include <zephyr/shell/shell.h>
 
 #include <synapse_topic_list.h>
+
+#include <cerebri/core/sensor_bus.h>
+
 #include <zros/private/zros_node_struct.h>
 #include <zros/private/zros_pub_struct.h>
 #include <zros/zros_node.h>
@@ -21,23 +24,20 @@ LOG_MODULE_REGISTER(sense_power, CONFIG_CEREBRI_SENSE_POWER_LOG_LEVEL);
 #define MY_STACK_SIZE 2048
 #define MY_PRIORITY   6
 
-extern struct k_work_q g_low_priority_work_q;
-
-#define N_SENSORS 1
+#define POWER_PERIOD_MS 100
 
-void power_work_handler(struct k_work *work);
+SENSOR_DT_READ_IODEV(power_iodev0, DT_ALIAS(power0), {SENSOR_CHAN_VOLTAGE, 0},
+		     {SENSOR_CHAN_CURRENT, 0});
 
 typedef struct context {
-	struct k_work work_item;
-	const struct device *device[N_SENSORS];
+	struct sensor_bus_group group;
 	struct zros_node node;
 	struct zros_pub pub;
 	synapse_pb_BatteryState data;
 } context_t;
 
 static context_t g_ctx = {
-	.work_item = Z_WORK_INITIALIZER(power_work_handler),
-	.device = {},
+	.group = {},
 	.node = {},
 	.pub = {},
 	.data = {
@@ -63,43 +63,38 @@ static context_t g_ctx = {
 		.voltage = 0,
 	}};
 
-void power_work_handler(struct k_work *work)
+// runs in the sensor bus thread
+static void power_bus_handler(struct sensor_bus_group *group)
 {
-	context_t *ctx = CONTAINER_OF(work, context_t, work_item);
-	int ret = sensor_sample_fetch(ctx->device[0]);
-	if (ret) {
-		LOG_ERR("Could not fetch sensor data");
+	context_t *ctx = CONTAINER_OF(group, context_t, group);
+	float voltage, current;
+
+	if (sensor_bus_decode(&group->read[0], SENSOR_CHAN_VOLTAGE, &voltage) < 0 ||
+	    sensor_bus_decode(&group->read[0], SENSOR_CHAN_CURRENT, &current) < 0) {
+		LOG_DBG("no power data");
 		return;
 	}
-	struct sensor_value voltage, current;
-
-	sensor_channel_get(ctx->device[0], SENSOR_CHAN_VOLTAGE, &voltage);
-	sensor_channel_get(ctx->device[0], SENSOR_CHAN_CURRENT, &current);
 
 	stamp_msg(&ctx->data.stamp, k_uptime_ticks());
-	ctx->data.voltage = sensor_value_to_double(&voltage);
-	ctx->data.current = sensor_value_to_double(&current);
+	ctx->data.voltage = voltage;
+	ctx->data.current = current;
 
-	zros_pub_update(&ctx->pub);
+	synapse_pub_update(&ctx->pub, SYNAPSE_TOPIC_battery_state);
 }
 
-void power_timer_handler(struct k_timer *dummy)
-{
-	k_work_submit_to_queue(&g_low_priority_work_q, &g_ctx.work_item);
-}
-
-K_TIMER_DEFINE(power_timer, power_timer_handler, NULL);
-
 int sense_power_entry_point(context_t *ctx)
 {
 	LOG_INF("init");
-	ctx->device[0] = DEVICE_DT_GET(DT_ALIAS(power0));
-	if (!device_is_ready(ctx->device[0])) {
-		LOG_ERR("Device %s is not ready", ctx->device[0]->name);
+	const struct device *dev = sensor_bus_device(&power_iodev0);
+	if (!device_is_ready(dev)) {
+		LOG_ERR("Device %s is not ready", dev->name);
+		return -ENODEV;
 	}
 	zros_node_init(&ctx->node, "sense_power");
 	zros_pub_init(&ctx->pub, &ctx->node, &topic_battery_state, &ctx->data);
-	k_timer_start(&power_timer, K_MSEC(100), K_MSEC(100));
+	sensor_bus_group_init(&ctx->group, "power", power_bus_handler, POWER_PERIOD_MS);
+	sensor_bus_group_add_read(&ctx->group, &power_iodev0);
+	sensor_bus_add(&ctx->group);
 	return 0;
 }
 
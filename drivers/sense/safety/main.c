@@ -81,7 +81,7 @@ static void sense_safety_run(void *p0, void *p1, void *p2)
 		if (ret < 0) {
 			continue;
 		}
-		zros_pub_update(&ctx->pub);
+		synapse_pub_update(&ctx->pub, SYNAPSE_TOPIC_safety);
 		k_sem_give(&ctx->data_sem);
 	}
 
@@ -118,7 +118,7 @@ static void input_cb(struct input_event *evt, void *userdata)
 				ctx->data.status = synapse_pb_Safety_Status_SAFETY_SAFE;
 			}
 			stamp_msg(&ctx->data.stamp, k_uptime_ticks());
-			zros_pub_update(&ctx->pub);
+			synapse_pub_update(&ctx->pub, SYNAPSE_TOPIC_safety);
 			k_sem_give(&ctx->data_sem);
 		}
 	}
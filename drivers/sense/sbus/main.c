@@ -107,7 +107,7 @@ static void input_cb(struct input_event *evt, void *userdata)
 
 	if (evt->sync == true) {
 		stamp_msg(&ctx->input.timestamp, k_uptime_ticks());
-		zros_pub_update(&ctx->pub_input);
+		synapse_pub_update(&ctx->pub_input, SYNAPSE_TOPIC_input_sbus);
 	}
 	ctx->last_event = evt->code;
 }
@@ -67,7 +67,7 @@ void publish_gnss_data(uDeviceHandle_t devHandle, int32_t errorCode, const uLoca
 		stamp_msg(&ctx->data.stamp, k_uptime_ticks());
 
 		// TODO Covariance
-		zros_pub_update(&ctx->pub);
+		synapse_pub_update(&ctx->pub, SYNAPSE_TOPIC_nav_sat_fix);
 		LOG_DBG("lat %f long %f\n", msg.latitude, msg.longitude);
 	} else if (errorCode == U_ERROR_COMMON_TIMEOUT) {
 		// LOG_ERR("Tiemout error");
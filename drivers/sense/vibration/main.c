@@ -0,0 +1,422 @@
+/*
+ * Copyright CogniPilot Foundation 2024
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+
+#include <zros/private/zros_node_struct.h>
+#include <zros/private/zros_sub_struct.h>
+#include <zros/zros_node.h>
+#include <zros/zros_sub.h>
+
+#include <arm_math.h>
+
+#include <synapse_topic_list.h>
+
+#define MY_STACK_SIZE 4096
+#define MY_PRIORITY   10
+
+#define FFT_SIZE      CONFIG_CEREBRI_SENSE_VIBRATION_FFT_SIZE
+#define FFT_BINS      (FFT_SIZE / 2)
+#define NUM_PEAKS     3
+#define NUM_BANDS     4
+#define SPECTRUM_ROWS 32
+
+BUILD_ASSERT(IS_POWER_OF_TWO(FFT_SIZE), "vibration fft size must be a power of two");
+
+LOG_MODULE_REGISTER(sense_vibration, CONFIG_CEREBRI_SENSE_VIBRATION_LOG_LEVEL);
+
+static K_THREAD_STACK_DEFINE(g_my_stack_area, MY_STACK_SIZE);
+
+enum channel {
+	CH_GYRO_X,
+	CH_GYRO_Y,
+	CH_GYRO_Z,
+	CH_ACCEL_X,
+	CH_ACCEL_Y,
+	CH_ACCEL_Z,
+	CH_COUNT,
+};
+
+static const char *const g_channel_name[CH_COUNT] = {
+	"gyro_x", "gyro_y", "gyro_z", "accel_x", "accel_y", "accel_z",
+};
+
+// upper band edges in Hz, the last band ends at nyquist
+static const float g_band_edge[NUM_BANDS - 1] = {20, 80, 200};
+
+struct result {
+	float rms;
+	float peak_hz[NUM_PEAKS];
+	float peak_rms[NUM_PEAKS];
+	float band_rms[NUM_BANDS];
+	// one sided power per bin, sums to the variance of the window
+	float power[FFT_BINS];
+};
+
+// private context
+struct context {
+	struct zros_node node;
+	synapse_pb_ImuQ31Array imu_q31_array;
+	struct zros_sub sub_imu_q31_array;
+	// window being filled, one row per channel
+	q31_t window[CH_COUNT][FFT_SIZE];
+	size_t fill;
+	int32_t gyro_shift;
+	int32_t accel_shift;
+	// sample period estimated from consecutive array stamps
+	uint64_t last_stamp_ns;
+	size_t last_count;
+	float period_ns;
+	arm_rfft_fast_instance_f32 rfft;
+	float hann[FFT_SIZE];
+	float hann_power;
+	float buf[FFT_SIZE];
+	float fft[FFT_SIZE];
+	// results of the last complete window
+	struct k_mutex lock;
+	struct result result[CH_COUNT];
+	float sample_rate;
+	uint64_t windows;
+	uint64_t gaps;
+	uint32_t clipped[CH_COUNT];
+	struct k_sem running;
+	size_t stack_size;
+	k_thread_stack_t *stack_area;
+	struct k_thread thread_data;
+};
+
+// private initialization
+static struct context g_ctx = {
+	.node = {},
+	.imu_q31_array = {},
+	.sub_imu_q31_array = {},
+	.fill = 0,
+	.lock = Z_MUTEX_INITIALIZER(g_ctx.lock),
+	.running = Z_SEM_INITIALIZER(g_ctx.running, 1, 1),
+	.stack_size = MY_STACK_SIZE,
+	.stack_area = g_my_stack_area,
+	.thread_data = {},
+};
+
+static int sense_vibration_init(struct context *ctx)
+{
+	if (arm_rfft_fast_init_f32(&ctx->rfft, FFT_SIZE) != ARM_MATH_SUCCESS) {
+		LOG_ERR("unsupported fft size %d", FFT_SIZE);
+		return -EINVAL;
+	}
+
+	// hann window, its power normalizes the spectrum
+	ctx->hann_power = 0;
+	for (int i = 0; i < FFT_SIZE; i++) {
+		float w = 0.5f - 0.5f * cosf(2 * PI * i / FFT_SIZE);
+		ctx->hann[i] = w;
+		ctx->hann_power += w * w;
+	}
+
+	ctx->fill = 0;
+	ctx->last_count = 0;
+	ctx->period_ns = 0;
+	zros_node_init(&ctx->node, "sense_vibration");
+	zros_sub_init(&ctx->sub_imu_q31_array, &ctx->node, &topic_imu_q31_array,
+		      &ctx->imu_q31_array, 1000);
+	k_sem_take(&ctx->running, K_FOREVER);
+	LOG_INF("init");
+	return 0;
+}
+
+static void sense_vibration_fini(struct context *ctx)
+{
+	zros_sub_fini(&ctx->sub_imu_q31_array);
+	zros_node_fini(&ctx->node);
+	k_sem_give(&ctx->running);
+	LOG_INF("fini");
+}
+
+// q31 magnitude at which a sample counts as clipped, for a given shift
+static int64_t clip_threshold(float limit, int32_t shift)
+{
+	float q = ldexpf(limit, 31 - shift);
+	return q >= (float)INT32_MAX ? INT32_MAX : (int64_t)q;
+}
+
+static void analyze_channel(struct context *ctx, enum channel ch, int32_t shift,
+			    float sample_rate, struct result *r)
+{
+	float mean = 0;
+	float bin_hz = sample_rate / FFT_SIZE;
+
+	// remove the gravity and bias offset, rms is of the vibration only
+	arm_q31_to_float(ctx->window[ch], ctx->buf, FFT_SIZE);
+	arm_scale_f32(ctx->buf, ldexpf(1.0f, shift), ctx->buf, FFT_SIZE);
+	arm_mean_f32(ctx->buf, FFT_SIZE, &mean);
+	arm_offset_f32(ctx->buf, -mean, ctx->buf, FFT_SIZE);
+	arm_rms_f32(ctx->buf, FFT_SIZE, &r->rms);
+
+	arm_mult_f32(ctx->buf, ctx->hann, ctx->buf, FFT_SIZE);
+	arm_rfft_fast_f32(&ctx->rfft, ctx->buf, ctx->fft, 0);
+
+	// fft[1] holds the nyquist bin packed next to dc, dc is zero after removing the mean
+	ctx->fft[1] = 0;
+	arm_cmplx_mag_squared_f32(ctx->fft, r->power, FFT_BINS);
+	arm_scale_f32(r->power, 2.0f / (FFT_SIZE * ctx->hann_power), r->power, FFT_BINS);
+
+	// largest local maxima, refined by parabolic interpolation
+	for (int j = 0; j < NUM_PEAKS; j++) {
+		r->peak_hz[j] = 0;
+		r->peak_rms[j] = 0;
+	}
+	float peak_power[NUM_PEAKS] = {};
+	for (int k = 1; k < FFT_BINS - 1; k++) {
+		float a = r->power[k - 1];
+		float b = r->power[k];
+		float c = r->power[k + 1];
+		if (b <= a || b < c || b <= peak_power[NUM_PEAKS - 1]) {
+			continue;
+		}
+		float denom = a - 2 * b + c;
+		float delta = denom < 0 ? 0.5f * (a - c) / denom : 0;
+		int j = NUM_PEAKS - 1;
+		for (; j > 0 && peak_power[j - 1] < b; j--) {
+			peak_power[j] = peak_power[j - 1];
+			r->peak_hz[j] = r->peak_hz[j - 1];
+		}
+		peak_power[j] = b;
+		r->peak_hz[j] = (k + delta) * bin_hz;
+	}
+	for (int j = 0; j < NUM_PEAKS; j++) {
+		r->peak_rms[j] = sqrtf(peak_power[j]);
+	}
+
+	int band = 0;
+	float band_power[NUM_BANDS] = {};
+	for (int k = 1; k < FFT_BINS; k++) {
+		while (band < NUM_BANDS - 1 && k * bin_hz >= g_band_edge[band]) {
+			band++;
+		}
+		band_power[band] += r->power[k];
+	}
+	for (int j = 0; j < NUM_BANDS; j++) {
+		r->band_rms[j] = sqrtf(band_power[j]);
+	}
+}
+
+static void analyze_window(struct context *ctx)
+{
+	if (ctx->period_ns <= 0) {
+		return;
+	}
+	float sample_rate = 1e9f / ctx->period_ns;
+
+	k_mutex_lock(&ctx->lock, K_FOREVER);
+	for (int ch = 0; ch < CH_COUNT; ch++) {
+		int32_t shift = ch < CH_ACCEL_X ? ctx->gyro_shift : ctx->accel_shift;
+		analyze_channel(ctx, ch, shift, sample_rate, &ctx->result[ch]);
+	}
+	ctx->sample_rate = sample_rate;
+	ctx->windows++;
+	k_mutex_unlock(&ctx->lock);
+}
+
+static void handle_array(struct context *ctx)
+{
+	const synapse_pb_ImuQ31Array *msg = &ctx->imu_q31_array;
+	uint64_t stamp_ns = msg->stamp.seconds * 1000000000ULL + msg->stamp.nanos;
+
+	// a window must be continuous and of a single scale, start over otherwise
+	bool restart = msg->gyro_shift != ctx->gyro_shift || msg->accel_shift != ctx->accel_shift;
+	if (ctx->last_count > 0) {
+		float period_ns = (float)(int64_t)(stamp_ns - ctx->last_stamp_ns) / ctx->last_count;
+		if (period_ns <= 0 || (ctx->period_ns > 0 && period_ns > 1.5f * ctx->period_ns)) {
+			// arrays missed, this thread runs at low priority
+			ctx->gaps++;
+			restart = true;
+		} else if (ctx->period_ns <= 0) {
+			ctx->period_ns = period_ns;
+		} else {
+			ctx->period_ns += (period_ns - ctx->period_ns) / 16;
+		}
+	}
+	ctx->last_stamp_ns = stamp_ns;
+	ctx->last_count = msg->frame_count;
+
+	if (restart) {
+		ctx->fill = 0;
+		ctx->gyro_shift = msg->gyro_shift;
+		ctx->accel_shift = msg->accel_shift;
+	}
+
+	int64_t gyro_clip = clip_threshold(CONFIG_CEREBRI_SENSE_VIBRATION_GYRO_CLIP_MRAD_S * 1e-3f,
+					   msg->gyro_shift);
+	int64_t accel_clip = clip_threshold(
+		CONFIG_CEREBRI_SENSE_VIBRATION_ACCEL_CLIP_MM_S2 * 1e-3f, msg->accel_shift);
+
+	for (size_t i = 0; i < msg->frame_count; i++) {
+		const int32_t sample[CH_COUNT] = {
+			msg->frame[i].gyro_x,  msg->frame[i].gyro_y,  msg->frame[i].gyro_z,
+			msg->frame[i].accel_x, msg->frame[i].accel_y, msg->frame[i].accel_z,
+		};
+		for (int ch = 0; ch < CH_COUNT; ch++) {
+			int64_t clip = ch < CH_ACCEL_X ? gyro_clip : accel_clip;
+			if (llabs((int64_t)sample[ch]) >= clip) {
+				ctx->clipped[ch]++;
+			}
+			ctx->window[ch][ctx->fill] = sample[ch];
+		}
+		if (++ctx->fill == FFT_SIZE) {
+			analyze_window(ctx);
+			ctx->fill = 0;
+		}
+	}
+}
+
+static void sense_vibration_run(void *p0, void *p1, void *p2)
+{
+	struct context *ctx = p0;
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+
+	if (sense_vibration_init(ctx) < 0) {
+		return;
+	}
+
+	struct k_poll_event events[] = {
+		*zros_sub_get_event(&ctx->sub_imu_q31_array),
+	};
+
+	while (k_sem_take(&ctx->running, K_NO_WAIT) < 0) {
+		int rc = 0;
+		rc = k_poll(events, ARRAY_SIZE(events), K_MSEC(1000));
+		if (rc != 0) {
+			LOG_DBG("not receiving imu_q31_array");
+			continue;
+		}
+
+		if (zros_sub_update_available(&ctx->sub_imu_q31_array)) {
+			zros_sub_update(&ctx->sub_imu_q31_array);
+			handle_array(ctx);
+		}
+	}
+
+	sense_vibration_fini(ctx);
+}
+
+static int start(struct context *ctx)
+{
+	k_tid_t tid = k_thread_create(&ctx->thread_data, ctx->stack_area, ctx->stack_size,
+				      sense_vibration_run, ctx, NULL, NULL, MY_PRIORITY, 0,
+				      K_FOREVER);
+	k_thread_name_set(tid, "sense_vibration");
+	k_thread_start(tid);
+	return 0;
+}
+
+static void print_status(const struct shell *sh, struct context *ctx)
+{
+	shell_print(sh, "running: %d", (int)k_sem_count_get(&g_ctx.running) == 0);
+	k_mutex_lock(&ctx->lock, K_FOREVER);
+	shell_print(sh,
+		    "windows: %" PRIu64 " gaps: %" PRIu64
+		    " sample rate: %.1f Hz resolution: %.2f Hz",
+		    ctx->windows, ctx->gaps, (double)ctx->sample_rate,
+		    (double)(ctx->sample_rate / FFT_SIZE));
+	shell_print(sh, "%-8s %9s %24s %33s %8s", "channel", "rms", "peaks Hz",
+		    "band rms <20 <80 <200 >200 Hz", "clipped");
+	for (int ch = 0; ch < CH_COUNT; ch++) {
+		const struct result *r = &ctx->result[ch];
+		shell_print(sh, "%-8s %9.4f %7.1f %7.1f %7.1f %8.4f %8.4f %8.4f %8.4f %8u",
+			    g_channel_name[ch], (double)r->rms, (double)r->peak_hz[0],
+			    (double)r->peak_hz[1], (double)r->peak_hz[2], (double)r->band_rms[0],
+			    (double)r->band_rms[1], (double)r->band_rms[2], (double)r->band_rms[3],
+			    ctx->clipped[ch]);
+	}
+	k_mutex_unlock(&ctx->lock);
+}
+
+// spectrum in dB, bins merged into at most SPECTRUM_ROWS rows by their maximum
+static void print_spectrum(const struct shell *sh, struct context *ctx, enum channel ch)
+{
+	static const char bar[] = "##################################################";
+	const int bins_per_row = MAX(FFT_BINS / SPECTRUM_ROWS, 1);
+
+	k_mutex_lock(&ctx->lock, K_FOREVER);
+	const struct result *r = &ctx->result[ch];
+	float bin_hz = ctx->sample_rate / FFT_SIZE;
+	float max_db = -200;
+	float row_db[SPECTRUM_ROWS];
+	int rows = 0;
+	for (int k = 0; k < FFT_BINS && rows < SPECTRUM_ROWS; k += bins_per_row, rows++) {
+		float p = 0;
+		for (int j = k; j < k + bins_per_row; j++) {
+			p = MAX(p, r->power[j]);
+		}
+		row_db[rows] = 10 * log10f(MAX(p, 1e-20f));
+		max_db = MAX(max_db, row_db[rows]);
+	}
+	shell_print(sh, "%s spectrum, peak %.1f dB, 60 dB range", g_channel_name[ch],
+		    (double)max_db);
+	for (int i = 0; i < rows; i++) {
+		int len = (int)((row_db[i] - max_db + 60) * (sizeof(bar) - 1) / 60);
+		len = CLAMP(len, 0, (int)sizeof(bar) - 1);
+		shell_print(sh, "%7.1f Hz %7.1f dB |%.*s", (double)(i * bins_per_row * bin_hz),
+			    (double)row_db[i], len, bar);
+	}
+	k_mutex_unlock(&ctx->lock);
+}
+
+static int sense_vibration_cmd_handler(const struct shell *sh, size_t argc, char **argv,
+				       void *data)
+{
+	ARG_UNUSED(argc);
+	struct context *ctx = data;
+
+	if (strcmp(argv[0], "start") == 0) {
+		if (k_sem_count_get(&g_ctx.running) == 0) {
+			shell_print(sh, "already running");
+		} else {
+			start(ctx);
+		}
+	} else if (strcmp(argv[0], "stop") == 0) {
+		if (k_sem_count_get(&g_ctx.running) == 0) {
+			k_sem_give(&g_ctx.running);
+		} else {
+			shell_print(sh, "not running");
+		}
+	} else if (strcmp(argv[0], "status") == 0) {
+		print_status(sh, ctx);
+	} else {
+		for (int ch = 0; ch < CH_COUNT; ch++) {
+			if (strcmp(argv[0], g_channel_name[ch]) == 0) {
+				print_spectrum(sh, ctx, ch);
+			}
+		}
+	}
+	return 0;
+}
+
+SHELL_SUBCMD_DICT_SET_CREATE(sub_sense_vibration, sense_vibration_cmd_handler,
+			     (start, &g_ctx, "start"), (stop, &g_ctx, "stop"),
+			     (status, &g_ctx, "status"), (gyro_x, &g_ctx, "gyro x spectrum"),
+			     (gyro_y, &g_ctx, "gyro y spectrum"),
+			     (gyro_z, &g_ctx, "gyro z spectrum"),
+			     (accel_x, &g_ctx, "accel x spectrum"),
+			     (accel_y, &g_ctx, "accel y spectrum"),
+			     (accel_z, &g_ctx, "accel z spectrum"));
+
+SHELL_CMD_REGISTER(sense_vibration, &sub_sense_vibration, "sense vibration commands", NULL);
+
+static int sense_vibration_sys_init(void)
+{
+	return start(&g_ctx);
+};
+
+SYS_INIT(sense_vibration_sys_init, APPLICATION, 0);
+
+// vi: ts=4 sw=4 et
@@ -18,25 +18,24 @@
 
 LOG_MODULE_REGISTER(sense_wheel_odometry, CONFIG_CEREBRI_SENSE_WHEEL_ODOMETRY_LOG_LEVEL);
 
-#define MY_STACK_SIZE 1024
-#define MY_PRIORITY   6
+#define MY_STACK_SIZE            1024
+#define MY_PRIORITY              6
+#define WHEEL_ODOMETRY_PERIOD_MS 10
 
 extern struct k_work_q g_high_priority_work_q;
 
-#define N_SENSORS 1
-
 void wheel_odometry_work_handler(struct k_work *work);
 
 typedef struct context {
 	struct k_work work_item;
-	const struct device *device[N_SENSORS];
+	const struct device *device;
 	struct zros_node node;
 	struct zros_pub pub;
 	synapse_pb_WheelOdometry data;
 } context_t;
 
 static context_t g_ctx = {.work_item = Z_WORK_INITIALIZER(wheel_odometry_work_handler),
-			  .device = {},
+			  .device = NULL,
 			  .node = {},
 			  .pub = {},
 			  .data = {
@@ -48,30 +47,28 @@ static context_t g_ctx = {.work_item = Z_WORK_INITIALIZER(wheel_odometry_work_ha
 void wheel_odometry_work_handler(struct k_work *work)
 {
 	context_t *ctx = CONTAINER_OF(work, context_t, work_item);
-	double data_array[N_SENSORS];
-	for (int i = 0; i < N_SENSORS; i++) {
-		// default all data to zero
-		struct sensor_value value = {};
-
-		// get accel if device present
-		if (ctx->device[i] != NULL) {
-			sensor_sample_fetch(ctx->device[i]);
-			sensor_channel_get(ctx->device[i], SENSOR_CHAN_ROTATION, &value);
-			LOG_DBG("rotation %d: %d.%06d", i, value.val1, value.val2);
-		}
-
-		for (int j = 0; j < N_SENSORS; j++) {
-			data_array[i] = value.val1 + value.val2 * 1e-6;
-		}
+	struct sensor_value value;
+
+	if (ctx->device == NULL) {
+		return;
+	}
+	int rc = sensor_sample_fetch(ctx->device);
+	if (rc == 0) {
+		rc = sensor_channel_get(ctx->device, SENSOR_CHAN_ROTATION, &value);
+	}
+	if (rc < 0) {
+		LOG_DBG("rotation read failed: %d", rc);
+		return;
 	}
 
-	// select first wheel encoder for data for now: TODO implement voting
-	double rotation = -data_array[0]; // account for negative rotation of encoder
+	// rotation accumulates without bound, kept in double to not lose resolution, negated to
+	// account for negative rotation of encoder
+	double rotation = -sensor_value_to_double(&value);
 
 	// publish msg
 	stamp_msg(&ctx->data.stamp, k_uptime_ticks());
 	ctx->data.rotation = rotation;
-	zros_pub_update(&ctx->pub);
+	synapse_pub_update(&ctx->pub, SYNAPSE_TOPIC_wheel_odometry);
 }
 
 void wheel_odometry_timer_handler(struct k_timer *dummy)
@@ -84,10 +81,11 @@ K_TIMER_DEFINE(wheel_odometry_timer, wheel_odometry_timer_handler, NULL);
 int sense_wheel_odometry_entry_point(context_t *ctx)
 {
 	LOG_INF("init");
-	ctx->device[0] = get_device(DEVICE_DT_GET(DT_ALIAS(wheel_odometry0)));
+	ctx->device = get_device(DEVICE_DT_GET(DT_ALIAS(wheel_odometry0)));
 	zros_node_init(&ctx->node, "sense_wheel_odometry");
 	zros_pub_init(&ctx->pub, &ctx->node, &topic_wheel_odometry, &ctx->data);
-	k_timer_start(&wheel_odometry_timer, K_MSEC(10), K_MSEC(10));
+	k_timer_start(&wheel_odometry_timer, K_MSEC(WHEEL_ODOMETRY_PERIOD_MS),
+		      K_MSEC(WHEEL_ODOMETRY_PERIOD_MS));
 	return 0;
 }
 
@@ -12,6 +12,7 @@
 #include <zros/zros_sub.h>
 
 #include "proto/udp_rx.h"
+#include <synapse_frame.h>
 #include <synapse_topic_list.h>
 
 #include <pb_decode.h>
@@ -46,48 +47,13 @@ static struct context g_ctx = {
 static void handle_frame(struct context *ctx)
 {
 	synapse_pb_Frame *frame = &ctx->rx_frame;
-	void *msg = NULL;
-	struct zros_topic *topic = NULL;
-
-	// determine topic for data
-	if (frame->which_msg == synapse_pb_Frame_bezier_trajectory_tag) {
-		msg = &frame->msg.bezier_trajectory;
-		topic = &topic_bezier_trajectory_ethernet;
-	} else if (frame->which_msg == synapse_pb_Frame_clock_offset_tag) {
-		msg = &frame->msg.clock_offset;
-		topic = &topic_clock_offset_ethernet;
-	} else if (frame->which_msg == synapse_pb_Frame_input_tag) {
-		msg = &frame->msg.input;
-		topic = &topic_input_ethernet;
-	} else if (frame->which_msg == synapse_pb_Frame_twist_tag) {
-		msg = &frame->msg.twist;
-		topic = &topic_cmd_vel_ethernet;
-#ifdef CONFIG_CEREBRI_DREAM_HIL
-	} else if (frame->which_msg == synapse_pb_Frame_battery_state_tag) {
-		msg = &frame->msg.battery_state;
-		topic = &topic_battery_state;
-	} else if (frame->which_msg == synapse_pb_Frame_imutag) {
-		msg = &frame->msg.imu;
-		topic = &topic_imu;
-	} else if (frame->which_msg == synapse_pb_Frame_magnetic_fieldtag) {
-		msg = &frame->msg.magnetic_field;
-		topic = &topic_magnetic_field;
-	} else if (frame->which_msg == synapse_pb_Frame_nav_sat_fixtag) {
-		msg = &frame->msg.nav_sat_fix;
-		zros_topic_publish(&topic_nav_sat_fix, msg);
-	} else if (frame->which_msg == synapse_pb_Frame_wheel_odometrytag) {
-		msg = &frame->msg.wheel_odometry;
-		topic = &topic_wheel_odometry;
-#endif
-	}
 
-	if (msg == NULL) {
+	// sensor messages are only accepted in hardware in the loop
+	int ret = synapse_frame_publish(frame, IS_ENABLED(CONFIG_CEREBRI_DREAM_HIL));
+	if (ret == -ENOENT || ret == -EPERM) {
 		LOG_ERR("unhandled message: %d", frame->which_msg);
-	} else {
-		int ret = zros_topic_publish(topic, msg);
-		if (ret != 0) {
-			LOG_ERR("failed to publish msg: %d", frame->which_msg);
-		}
+	} else if (ret != 0) {
+		LOG_ERR("failed to publish msg: %d", frame->which_msg);
 	}
 }
 
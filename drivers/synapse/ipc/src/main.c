@@ -0,0 +1,353 @@
+/*
+ * Copyright CogniPilot Foundation 2024
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/device.h>
+#include <zephyr/ipc/ipc_service.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+
+#include <zros/private/zros_node_struct.h>
+#include <zros/private/zros_sub_struct.h>
+#include <zros/zros_node.h>
+#include <zros/zros_sub.h>
+#include <zros/zros_topic.h>
+
+#include <synapse_topic_list.h>
+
+#define MY_STACK_SIZE 4096
+#define MY_PRIORITY   6
+
+// header id of the schema handshake, topic ids are below SYNAPSE_TOPIC_COUNT
+#define IPC_ID_HELLO 0xff
+
+LOG_MODULE_REGISTER(synapse_ipc, CONFIG_CEREBRI_SYNAPSE_IPC_LOG_LEVEL);
+
+static K_THREAD_STACK_DEFINE(g_my_stack_area, MY_STACK_SIZE);
+
+struct ipc_header {
+	uint8_t id;
+	uint8_t reserved;
+	uint16_t size;
+};
+
+// both cores share the layout, the message is copied as is
+struct ipc_packet {
+	struct ipc_header header;
+	union {
+		union synapse_topic_msg msg;
+		uint32_t schema_hash;
+	};
+};
+
+struct context {
+	struct zros_node node;
+	struct zros_sub sub[CONFIG_CEREBRI_SYNAPSE_IPC_MAX_TX_TOPICS];
+	enum synapse_topic_id tx_id[CONFIG_CEREBRI_SYNAPSE_IPC_MAX_TX_TOPICS];
+	size_t tx_count;
+	// topics received from the other core, never sent back
+	bool imported[SYNAPSE_TOPIC_COUNT];
+	struct ipc_packet tx, rx;
+	struct ipc_ept ept;
+	struct ipc_ept_cfg ept_cfg;
+	struct k_sem bound;
+	uint32_t schema_hash;
+	bool remote_ok;
+	uint64_t tx_packets, tx_dropped, rx_packets, rx_dropped;
+	struct k_sem running;
+	size_t stack_size;
+	k_thread_stack_t *stack_area;
+	struct k_thread thread_data;
+};
+
+static void ipc_bound(void *priv);
+static void ipc_recv(const void *data, size_t len, void *priv);
+
+static struct context g_ctx = {
+	.node = {},
+	.sub = {},
+	.tx_count = 0,
+	.imported = {},
+	.ept = {},
+	.ept_cfg =
+		{
+			.name = "synapse",
+			.cb =
+				{
+					.bound = ipc_bound,
+					.received = ipc_recv,
+				},
+			.priv = &g_ctx,
+		},
+	.bound = Z_SEM_INITIALIZER(g_ctx.bound, 0, 1),
+	.remote_ok = false,
+	.running = Z_SEM_INITIALIZER(g_ctx.running, 1, 1),
+	.stack_size = MY_STACK_SIZE,
+	.stack_area = g_my_stack_area,
+	.thread_data = {},
+};
+
+// fnv-1a of topic names and message sizes, differs if the cores disagree on the schema
+static uint32_t schema_hash(void)
+{
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < SYNAPSE_TOPIC_COUNT; i++) {
+		for (const char *c = synapse_topic_info[i].name; *c != '\0'; c++) {
+			hash = (hash ^ (uint8_t)*c) * 16777619u;
+		}
+		hash = (hash ^ (uint32_t)synapse_topic_info[i].size) * 16777619u;
+	}
+	return hash;
+}
+
+static int topic_id(const char *name)
+{
+	for (size_t i = 0; i < SYNAPSE_TOPIC_COUNT; i++) {
+		if (strcmp(synapse_topic_info[i].name, name) == 0) {
+			return i;
+		}
+	}
+	return -ENOENT;
+}
+
+static void ipc_bound(void *priv)
+{
+	struct context *ctx = priv;
+	k_sem_give(&ctx->bound);
+}
+
+// runs in the ipc service work queue
+static void ipc_recv(const void *data, size_t len, void *priv)
+{
+	struct context *ctx = priv;
+	struct ipc_header header;
+	size_t offset = offsetof(struct ipc_packet, msg);
+
+	if (len < offset) {
+		ctx->rx_dropped++;
+		return;
+	}
+	memcpy(&header, data, sizeof(header));
+
+	if (header.id == IPC_ID_HELLO) {
+		uint32_t remote_hash;
+		memcpy(&remote_hash, (const uint8_t *)data + offset, sizeof(remote_hash));
+		ctx->remote_ok = remote_hash == ctx->schema_hash;
+		if (!ctx->remote_ok) {
+			LOG_ERR("topic schema differs from other core, not bridging");
+		} else {
+			LOG_INF("bridge up");
+		}
+		return;
+	}
+
+	if (!ctx->remote_ok || header.id >= SYNAPSE_TOPIC_COUNT ||
+	    header.size != synapse_topic_info[header.id].size || len != offset + header.size) {
+		ctx->rx_dropped++;
+		return;
+	}
+
+	// shared memory alignment is not guaranteed, copy before publishing
+	memcpy(&ctx->rx.msg, (const uint8_t *)data + offset, header.size);
+	ctx->imported[header.id] = true;
+	synapse_topic_publish(header.id, &ctx->rx.msg);
+	ctx->rx_packets++;
+}
+
+static int send_hello(struct context *ctx)
+{
+	ctx->tx.header.id = IPC_ID_HELLO;
+	ctx->tx.header.size = sizeof(ctx->tx.schema_hash);
+	ctx->tx.schema_hash = ctx->schema_hash;
+	return ipc_service_send(&ctx->ept, &ctx->tx,
+				offsetof(struct ipc_packet, msg) + sizeof(ctx->tx.schema_hash));
+}
+
+static int synapse_ipc_init(struct context *ctx)
+{
+	int ret = 0;
+	const struct device *ipc = DEVICE_DT_GET(DT_NODELABEL(ipc0));
+
+	ctx->schema_hash = schema_hash();
+	zros_node_init(&ctx->node, "synapse_ipc");
+
+	// subscribe to the topics sent to the other core
+	char topics[] = CONFIG_CEREBRI_SYNAPSE_IPC_TX_TOPICS;
+	char *save = NULL;
+	ctx->tx_count = 0;
+	for (char *name = strtok_r(topics, " ,", &save); name != NULL;
+	     name = strtok_r(NULL, " ,", &save)) {
+		int id = topic_id(name);
+		if (id < 0) {
+			LOG_ERR("unknown topic: %s", name);
+			continue;
+		}
+		if (ctx->tx_count >= ARRAY_SIZE(ctx->sub)) {
+			LOG_ERR("too many topics, %s not sent", name);
+			break;
+		}
+		ctx->tx_id[ctx->tx_count] = id;
+		zros_sub_init(&ctx->sub[ctx->tx_count], &ctx->node, synapse_topic_info[id].topic,
+			      &ctx->tx.msg, CONFIG_CEREBRI_SYNAPSE_IPC_MAX_RATE);
+		ctx->tx_count++;
+	}
+
+	ret = ipc_service_open_instance(ipc);
+	if (ret < 0 && ret != -EALREADY) {
+		LOG_ERR("ipc open failed: %d", ret);
+		return ret;
+	}
+
+	ret = ipc_service_register_endpoint(ipc, &ctx->ept, &ctx->ept_cfg);
+	if (ret < 0) {
+		LOG_ERR("ipc endpoint register failed: %d", ret);
+		return ret;
+	}
+
+	k_sem_take(&ctx->running, K_FOREVER);
+	LOG_INF("init");
+	return 0;
+}
+
+static void synapse_ipc_fini(struct context *ctx)
+{
+	ipc_service_deregister_endpoint(&ctx->ept);
+	ctx->remote_ok = false;
+	for (size_t i = 0; i < ctx->tx_count; i++) {
+		zros_sub_fini(&ctx->sub[i]);
+	}
+	ctx->tx_count = 0;
+	zros_node_fini(&ctx->node);
+	k_sem_give(&ctx->running);
+	LOG_INF("fini");
+}
+
+static void synapse_ipc_run(void *p0, void *p1, void *p2)
+{
+	struct context *ctx = p0;
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+
+	if (synapse_ipc_init(ctx) < 0) {
+		synapse_ipc_fini(ctx);
+		return;
+	}
+
+	// wait for the other core, then exchange schema hashes
+	while (k_sem_take(&ctx->bound, K_MSEC(1000)) < 0) {
+		if (k_sem_take(&ctx->running, K_NO_WAIT) == 0) {
+			synapse_ipc_fini(ctx);
+			return;
+		}
+		LOG_DBG("waiting for other core");
+	}
+	if (send_hello(ctx) < 0) {
+		LOG_ERR("failed to send hello");
+	}
+
+	struct k_poll_event events[CONFIG_CEREBRI_SYNAPSE_IPC_MAX_TX_TOPICS];
+	for (size_t i = 0; i < ctx->tx_count; i++) {
+		events[i] = *zros_sub_get_event(&ctx->sub[i]);
+	}
+
+	while (k_sem_take(&ctx->running, K_NO_WAIT) < 0) {
+		if (ctx->tx_count == 0) {
+			k_msleep(100);
+			continue;
+		}
+
+		int rc = k_poll(events, ctx->tx_count, K_MSEC(100));
+		if (rc != 0) {
+			continue;
+		}
+
+		for (size_t i = 0; i < ctx->tx_count; i++) {
+			events[i].state = K_POLL_STATE_NOT_READY;
+			if (!zros_sub_update_available(&ctx->sub[i])) {
+				continue;
+			}
+			zros_sub_update(&ctx->sub[i]);
+
+			enum synapse_topic_id id = ctx->tx_id[i];
+			if (!ctx->remote_ok || ctx->imported[id]) {
+				continue;
+			}
+
+			ctx->tx.header.id = id;
+			ctx->tx.header.size = synapse_topic_info[id].size;
+			if (ipc_service_send(&ctx->ept, &ctx->tx,
+					     offsetof(struct ipc_packet, msg) +
+						     synapse_topic_info[id].size) < 0) {
+				ctx->tx_dropped++;
+			} else {
+				ctx->tx_packets++;
+			}
+		}
+	}
+
+	synapse_ipc_fini(ctx);
+}
+
+static int start(struct context *ctx)
+{
+	k_tid_t tid = k_thread_create(&ctx->thread_data, ctx->stack_area, ctx->stack_size,
+				      synapse_ipc_run, ctx, NULL, NULL, MY_PRIORITY, 0, K_FOREVER);
+	k_thread_name_set(tid, "synapse_ipc");
+	k_thread_start(tid);
+	return 0;
+}
+
+static int synapse_ipc_cmd_handler(const struct shell *sh, size_t argc, char **argv, void *data)
+{
+	ARG_UNUSED(argc);
+	struct context *ctx = data;
+
+	if (strcmp(argv[0], "start") == 0) {
+		if (k_sem_count_get(&g_ctx.running) == 0) {
+			shell_print(sh, "already running");
+		} else {
+			start(ctx);
+		}
+	} else if (strcmp(argv[0], "stop") == 0) {
+		if (k_sem_count_get(&g_ctx.running) == 0) {
+			k_sem_give(&g_ctx.running);
+		} else {
+			shell_print(sh, "not running");
+		}
+	} else if (strcmp(argv[0], "status") == 0) {
+		shell_print(sh, "running: %d", (int)k_sem_count_get(&g_ctx.running) == 0);
+		shell_print(sh, "schema match: %d", ctx->remote_ok);
+		shell_print(sh, "tx packets: %" PRIu64 " dropped: %" PRIu64, ctx->tx_packets,
+			    ctx->tx_dropped);
+		shell_print(sh, "rx packets: %" PRIu64 " dropped: %" PRIu64, ctx->rx_packets,
+			    ctx->rx_dropped);
+		for (size_t i = 0; i < ctx->tx_count; i++) {
+			shell_print(sh, "tx: %s", synapse_topic_info[ctx->tx_id[i]].name);
+		}
+		for (size_t i = 0; i < SYNAPSE_TOPIC_COUNT; i++) {
+			if (ctx->imported[i]) {
+				shell_print(sh, "rx: %s", synapse_topic_info[i].name);
+			}
+		}
+	}
+	return 0;
+}
+
+SHELL_SUBCMD_DICT_SET_CREATE(sub_synapse_ipc, synapse_ipc_cmd_handler, (start, &g_ctx, "start"),
+			     (stop, &g_ctx, "stop"), (status, &g_ctx, "status"));
+
+SHELL_CMD_REGISTER(synapse_ipc, &sub_synapse_ipc, "synapse inter-core bridge commands", NULL);
+
+static int synapse_ipc_sys_init(void)
+{
+	return start(&g_ctx);
+};
+
+SYS_INIT(synapse_ipc_sys_init, APPLICATION, 0);
+
+// vi: ts=4 sw=4 et
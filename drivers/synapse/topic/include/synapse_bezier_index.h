@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2024 CogniPilot Foundation
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef SYNAPSE_BEZIER_INDEX_H
+#define SYNAPSE_BEZIER_INDEX_H
+
+#include <zephyr/kernel.h>
+
+#include <synapse_pb/bezier_trajectory.pb.h>
+
+#define SYNAPSE_BEZIER_INDEX_MAX_CURVES ARRAY_SIZE(((synapse_pb_BezierTrajectory *)0)->curves)
+
+/*
+ * Segment table of a bezier trajectory, built once when a trajectory arrives
+ * so each control tick only does an integer time lookup. Curve i spans
+ * [time_stop_ns[i - 1], time_stop_ns[i]), curve 0 starts at time_start_ns.
+ */
+struct synapse_bezier_index {
+	int64_t time_start_ns;
+	int64_t time_stop_ns[SYNAPSE_BEZIER_INDEX_MAX_CURVES];
+	double T[SYNAPSE_BEZIER_INDEX_MAX_CURVES];
+	int count;
+	int cursor;
+};
+
+int64_t timestamp_to_ns(const synapse_pb_Timestamp *ts);
+
+// returns -EINVAL and an empty index if curve stop times are not increasing
+int synapse_bezier_index_build(struct synapse_bezier_index *index,
+			       const synapse_pb_BezierTrajectory *traj);
+
+// returns the curve index with time t and duration T of the curve in seconds,
+// -EAGAIN before the trajectory starts, -ERANGE after it ends
+int synapse_bezier_index_find(struct synapse_bezier_index *index, int64_t time_ns, double *t,
+			      double *T);
+
+#endif // SYNAPSE_BEZIER_INDEX_H
+// vi: ts=4 sw=4 et
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2024 CogniPilot Foundation
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef SYNAPSE_ESC_TELEMETRY_H
+#define SYNAPSE_ESC_TELEMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <synapse_pb/timestamp.pb.h>
+
+/********************************************************************
+ * esc telemetry
+ *
+ * Synapse has no message for motor telemetry yet, so the esc_telemetry
+ * topic of SYNAPSE_TOPIC_SCHEMA carries this plain struct. It is published
+ * every control update by actuate_dshot from bidirectional dshot responses
+ * and by actuate_vesc_can from vesc status frames.
+ ********************************************************************/
+#define SYNAPSE_ESC_TELEMETRY_MAX_MOTORS 8
+// commands averaged by the error rate
+#define SYNAPSE_ESC_TELEMETRY_RATE_WINDOW 100
+
+struct synapse_esc_telemetry_motor {
+	// electrical rpm
+	int32_t erpm;
+	// mechanical rpm
+	float rpm;
+	// a response was received for the last command
+	bool valid;
+	// fraction of recent commands without a valid response
+	float error_rate;
+	// age of the last command when the response or status frame arrived,
+	// the round trip latency for escs answering every command
+	uint32_t cmd_age_us;
+	uint32_t crc_errors;
+	uint32_t frame_errors;
+	uint32_t no_response;
+};
+
+struct synapse_esc_telemetry {
+	synapse_pb_Timestamp stamp;
+	uint8_t motor_count;
+	struct synapse_esc_telemetry_motor motor[SYNAPSE_ESC_TELEMETRY_MAX_MOTORS];
+};
+
+// moving average of the error rate, called once per command
+static inline void synapse_esc_telemetry_rate_update(struct synapse_esc_telemetry_motor *motor,
+						     bool error)
+{
+	motor->error_rate += ((error ? 1.0f : 0.0f) - motor->error_rate) /
+			     SYNAPSE_ESC_TELEMETRY_RATE_WINDOW;
+}
+
+#endif // SYNAPSE_ESC_TELEMETRY_H
+// vi: ts=4 sw=4 et
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2024 CogniPilot Foundation
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef SYNAPSE_FRAME_H
+#define SYNAPSE_FRAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <synapse_topic_list.h>
+
+/*
+ * Frame dispatch.
+ *
+ * Received frames are routed to their topic by a table indexed by the Frame
+ * msg tag, so the cost of dispatch does not grow with the number of messages
+ * in the protocol. Every receiving transport shares the table, which is
+ * generated from the frame column of SYNAPSE_TOPIC_SCHEMA.
+ */
+
+// route only accepted from transports that carry simulated sensors (sil, hil)
+#define SYNAPSE_FRAME_ROUTE_SIM BIT(0)
+
+struct synapse_frame_route {
+	struct zros_topic *topic;
+	enum synapse_topic_id id;
+	// offset of the message within synapse_pb_Frame
+	size_t offset;
+	uint32_t flags;
+};
+
+// route of a frame tag, NULL if the tag is not routed
+const struct synapse_frame_route *synapse_frame_route(pb_size_t tag);
+
+/*
+ * Publish a received frame on its topic. Returns -ENOENT if the tag has no
+ * route, -EPERM for a sim route on a transport that does not carry sim
+ * sensors, else the result of synapse_topic_publish. Bezier trajectories are
+ * also submitted to the trajectory follower as a single committed chunk,
+ * -ENOMEM if its queue is full.
+ */
+int synapse_frame_publish(synapse_pb_Frame *frame, bool sim);
+
+#endif // SYNAPSE_FRAME_H
+// vi: ts=4 sw=4 et
@@ -18,6 +18,7 @@ int snprint_battery_state(char *buf, size_t n, synapse_pb_BatteryState *m);
 int snprint_bezier_curve(char *buf, size_t n, synapse_pb_BezierTrajectory_Curve *m);
 int snprint_bezier_trajectory(char *buf, size_t n, synapse_pb_BezierTrajectory *m);
 int snprint_clock_offset(char *buf, size_t n, synapse_pb_ClockOffset *m);
+int snprint_esc_telemetry(char *buf, size_t n, struct synapse_esc_telemetry *m);
 int snprint_imu(char *buf, size_t n, synapse_pb_Imu *m);
 int snprint_imu_q31_array(char *buf, size_t n, synapse_pb_ImuQ31Array *m);
 int snprint_input(char *buf, size_t n, synapse_pb_Input *m);
@@ -32,6 +33,7 @@ int snprint_rates_sp(char *buf, size_t n, synapse_pb_Vector3 *m);
 int snprint_safety(char *buf, size_t n, synapse_pb_Safety *m);
 int snprint_status(char *buf, size_t n, synapse_pb_Status *m);
 int snprint_timestamp(char *buf, size_t n, synapse_pb_Timestamp *m);
+int snprint_topic_stats(char *buf, size_t n, struct synapse_topic_stats_report *m);
 int snprint_twist(char *buf, size_t n, synapse_pb_Twist *m);
 int snprint_vector3(char *buf, size_t n, synapse_pb_Vector3 *m);
 int snprint_wheel_odometry(char *buf, size_t n, synapse_pb_WheelOdometry *m);
@@ -5,6 +5,11 @@
 #ifndef SYNAPSE_TOPIC_LIST_H
 #define SYNAPSE_TOPIC_LIST_H
 
+#include <stdint.h>
+
+#include <zephyr/sys/util.h>
+
+#include <zros/zros_pub.h>
 #include <zros/zros_topic.h>
 
 #include <synapse_pb/actuators.pb.h>
@@ -26,6 +31,8 @@
 #include <synapse_pb/vector3.pb.h>
 #include <synapse_pb/wheel_odometry.pb.h>
 
+#include "synapse_esc_telemetry.h"
+
 /********************************************************************
  * helper
  ********************************************************************/
@@ -39,42 +46,140 @@ const char *fuel_str(synapse_pb_Status_Fuel fuel);
 const char *status_safety_str(synapse_pb_Status_Safety safety);
 const char *link_status_str(synapse_pb_Status_LinkStatus status);
 
+/********************************************************************
+ * topic schema
+ *
+ * Every topic is listed once here as
+ * (name, message type, shell printer, frame, route flags), where the printer
+ * is snprint_<printer>. The message type is usually a synapse_pb message; a
+ * plain struct also works for topics with no message in the protocol yet,
+ * those are shared with other cores over ipc but cannot be routed. Frames
+ * received with msg tag synapse_pb_Frame_<frame>_tag are published on the
+ * topic, with the SYNAPSE_FRAME_ROUTE_* flags; leave frame empty for topics
+ * that are not received. Declarations, definitions, broker registration, the
+ * topic info table, the frame routes and the zros topic shell commands are
+ * all expanded from this list with FOR_EACH, so adding a topic only takes a
+ * new entry. FOR_EACH limits the schema to 64 topics.
+ ********************************************************************/
+#define SYNAPSE_TOPIC_SCHEMA                                                                       \
+	(accel_ff, synapse_pb_Vector3, vector3, , 0),                                              \
+	(accel_sp, synapse_pb_Vector3, vector3, , 0),                                              \
+	(actuators, synapse_pb_Actuators, actuators, , 0),                                         \
+	(altimeter, synapse_pb_Altimeter, altimeter, , 0),                                         \
+	(angular_velocity_ff, synapse_pb_Vector3, vector3, , 0),                                   \
+	(angular_velocity_sp, synapse_pb_Vector3, vector3, , 0),                                   \
+	(attitude_sp, synapse_pb_Quaternion, quaternion, , 0),                                     \
+	(battery_state, synapse_pb_BatteryState, battery_state, battery_state,                     \
+	 SYNAPSE_FRAME_ROUTE_SIM),                                                                 \
+	(bezier_trajectory, synapse_pb_BezierTrajectory, bezier_trajectory, , 0),                  \
+	(bezier_trajectory_ethernet, synapse_pb_BezierTrajectory, bezier_trajectory,               \
+	 bezier_trajectory, 0),                                                                    \
+	(clock_offset_ethernet, synapse_pb_ClockOffset, clock_offset, clock_offset, 0),            \
+	(cmd_vel, synapse_pb_Twist, twist, , 0),                                                   \
+	(cmd_vel_ethernet, synapse_pb_Twist, twist, twist, 0),                                     \
+	(esc_telemetry, struct synapse_esc_telemetry, esc_telemetry, , 0),                         \
+	(force_sp, synapse_pb_Vector3, vector3, , 0),                                              \
+	(imu, synapse_pb_Imu, imu, imu, SYNAPSE_FRAME_ROUTE_SIM),                                  \
+	(imu_q31_array, synapse_pb_ImuQ31Array, imu_q31_array, , 0),                               \
+	(input, synapse_pb_Input, input, , 0),                                                     \
+	(input_ethernet, synapse_pb_Input, input, input, 0),                                       \
+	(input_sbus, synapse_pb_Input, input, , 0),                                                \
+	(led_array, synapse_pb_LEDArray, ledarray, , 0),                                           \
+	(magnetic_field, synapse_pb_MagneticField, magnetic_field, magnetic_field,                 \
+	 SYNAPSE_FRAME_ROUTE_SIM),                                                                 \
+	(moment_ff, synapse_pb_Vector3, vector3, , 0),                                             \
+	(moment_sp, synapse_pb_Vector3, vector3, , 0),                                             \
+	(nav_sat_fix, synapse_pb_NavSatFix, navsatfix, nav_sat_fix, SYNAPSE_FRAME_ROUTE_SIM),      \
+	(odometry_estimator, synapse_pb_Odometry, odometry, , 0),                                  \
+	(odometry_ethernet, synapse_pb_Odometry, odometry, odometry, 0),                           \
+	(orientation_sp, synapse_pb_Quaternion, quaternion, , 0),                                  \
+	(position_sp, synapse_pb_Vector3, vector3, , 0),                                           \
+	(pwm, synapse_pb_Pwm, pwm, , 0),                                                           \
+	(safety, synapse_pb_Safety, safety, , 0),                                                  \
+	(status, synapse_pb_Status, status, , 0),                                                  \
+	(topic_stats, struct synapse_topic_stats_report, topic_stats, , 0),                        \
+	(velocity_sp, synapse_pb_Vector3, vector3, , 0),                                           \
+	(wheel_odometry, synapse_pb_WheelOdometry, wheel_odometry, wheel_odometry,                 \
+	 SYNAPSE_FRAME_ROUTE_SIM)
+
 /********************************************************************
  * topics
  ********************************************************************/
-ZROS_TOPIC_DECLARE(topic_accel_ff, synapse_pb_Vector3);
-ZROS_TOPIC_DECLARE(topic_accel_sp, synapse_pb_Vector3);
-ZROS_TOPIC_DECLARE(topic_actuators, synapse_pb_Actuators);
-ZROS_TOPIC_DECLARE(topic_altimeter, synapse_pb_Altimeter);
-ZROS_TOPIC_DECLARE(topic_angular_velocity_ff, synapse_pb_Vector3);
-ZROS_TOPIC_DECLARE(topic_angular_velocity_sp, synapse_pb_Vector3);
-ZROS_TOPIC_DECLARE(topic_attitude_sp, synapse_pb_Quaternion);
-ZROS_TOPIC_DECLARE(topic_battery_state, synapse_pb_BatteryState);
-ZROS_TOPIC_DECLARE(topic_bezier_trajectory, synapse_pb_BezierTrajectory);
-ZROS_TOPIC_DECLARE(topic_bezier_trajectory_ethernet, synapse_pb_BezierTrajectory);
-ZROS_TOPIC_DECLARE(topic_clock_offset_ethernet, synapse_pb_Time);
-ZROS_TOPIC_DECLARE(topic_cmd_vel, synapse_pb_Twist);
-ZROS_TOPIC_DECLARE(topic_cmd_vel_ethernet, synapse_pb_Twist);
-ZROS_TOPIC_DECLARE(topic_force_sp, synapse_pb_Vector3);
-ZROS_TOPIC_DECLARE(topic_imu, synapse_pb_Imu);
-ZROS_TOPIC_DECLARE(topic_imu_q31_array, synapse_pb_ImuQ31Array);
-ZROS_TOPIC_DECLARE(topic_input, synapse_pb_Input);
-ZROS_TOPIC_DECLARE(topic_input_sbus, synapse_pb_Input);
-ZROS_TOPIC_DECLARE(topic_input_ethernet, synapse_pb_Input);
-ZROS_TOPIC_DECLARE(topic_led_array, synapse_pb_LEDArray);
-ZROS_TOPIC_DECLARE(topic_magnetic_field, synapse_pb_MagneticField);
-ZROS_TOPIC_DECLARE(topic_moment_ff, synapse_pb_Vector3);
-ZROS_TOPIC_DECLARE(topic_moment_sp, synapse_pb_Vector3);
-ZROS_TOPIC_DECLARE(topic_nav_sat_fix, synapse_pb_NavSatFix);
-ZROS_TOPIC_DECLARE(topic_odometry_estimator, synapse_pb_Odometry);
-ZROS_TOPIC_DECLARE(topic_odometry_ethernet, synapse_pb_Odometry);
-ZROS_TOPIC_DECLARE(topic_orientation_sp, synapse_pb_Vector3);
-ZROS_TOPIC_DECLARE(topic_position_sp, synapse_pb_Vector3);
-ZROS_TOPIC_DECLARE(topic_pwm, synapse_pb_Pwm);
-ZROS_TOPIC_DECLARE(topic_safety, synapse_pb_Safety);
-ZROS_TOPIC_DECLARE(topic_status, synapse_pb_Status);
-ZROS_TOPIC_DECLARE(topic_velocity_sp, synapse_pb_Vector3);
-ZROS_TOPIC_DECLARE(topic_wheel_odometry, synapse_pb_WheelOdometry);
+#define Z_SYNAPSE_TOPIC_DECLARE(entry) Z_SYNAPSE_TOPIC_DECLARE_ entry
+#define Z_SYNAPSE_TOPIC_DECLARE_(name, type, printer, frame, flags)                                \
+	ZROS_TOPIC_DECLARE(topic_##name, type)
+#define Z_SYNAPSE_TOPIC_ID(entry)                                  Z_SYNAPSE_TOPIC_ID_ entry
+#define Z_SYNAPSE_TOPIC_ID_(name, type, printer, frame, flags)     SYNAPSE_TOPIC_##name
+#define Z_SYNAPSE_TOPIC_MEMBER(entry)                              Z_SYNAPSE_TOPIC_MEMBER_ entry
+#define Z_SYNAPSE_TOPIC_MEMBER_(name, type, printer, frame, flags) type name
+
+// index of every topic in synapse_topic_info
+enum synapse_topic_id {
+	FOR_EACH(Z_SYNAPSE_TOPIC_ID, (,), SYNAPSE_TOPIC_SCHEMA),
+	SYNAPSE_TOPIC_COUNT,
+};
+
+// publish statistics of a topic, see synapse_topic_stats.h
+struct synapse_topic_stats {
+	// messages published
+	uint64_t count;
+	// bytes published, message struct size times count
+	uint64_t bytes;
+	// smoothed publish period
+	uint32_t period_us;
+	// smoothed mean deviation of the publish period
+	uint32_t jitter_us;
+	// uptime ticks of the last publish, 0 if none
+	int64_t last_ticks;
+};
+
+// statistics of every topic, indexed by topic id, published on topic_stats
+struct synapse_topic_stats_report {
+	// uptime of the report, on the clock of last_ticks
+	synapse_pb_Timestamp stamp;
+	struct synapse_topic_stats topic[SYNAPSE_TOPIC_COUNT];
+};
+
+FOR_EACH(Z_SYNAPSE_TOPIC_DECLARE, (;), SYNAPSE_TOPIC_SCHEMA);
+
+// large enough to hold a message of any topic
+union synapse_topic_msg {
+	FOR_EACH(Z_SYNAPSE_TOPIC_MEMBER, (;), SYNAPSE_TOPIC_SCHEMA);
+};
+
+struct synapse_topic_info {
+	const char *name;
+	struct zros_topic *topic;
+	size_t size;
+};
+
+extern const struct synapse_topic_info synapse_topic_info[SYNAPSE_TOPIC_COUNT];
+
+/********************************************************************
+ * publish
+ *
+ * Publish through these instead of zros_pub_update and zros_topic_publish,
+ * so the publish is counted by the topic statistics.
+ ********************************************************************/
+void synapse_topic_stats_publish(enum synapse_topic_id id);
+
+static inline int synapse_pub_update(struct zros_pub *pub, enum synapse_topic_id id)
+{
+	int rc = zros_pub_update(pub);
+	if (IS_ENABLED(CONFIG_CEREBRI_SYNAPSE_TOPIC_STATS) && rc == 0) {
+		synapse_topic_stats_publish(id);
+	}
+	return rc;
+}
+
+static inline int synapse_topic_publish(enum synapse_topic_id id, void *msg)
+{
+	int rc = zros_topic_publish(synapse_topic_info[id].topic, msg);
+	if (IS_ENABLED(CONFIG_CEREBRI_SYNAPSE_TOPIC_STATS) && rc == 0) {
+		synapse_topic_stats_publish(id);
+	}
+	return rc;
+}
 
 #endif // SYNAPSE_TOPIC_LIST_H_
 // vi: ts=4 sw=4 et
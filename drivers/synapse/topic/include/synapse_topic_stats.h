@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2024 CogniPilot Foundation
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef SYNAPSE_TOPIC_STATS_H
+#define SYNAPSE_TOPIC_STATS_H
+
+#include <synapse_topic_list.h>
+
+/*
+ * Topic statistics, CONFIG_CEREBRI_SYNAPSE_TOPIC_STATS.
+ *
+ * synapse_pub_update and synapse_topic_publish update the statistics of the
+ * topic in the publishing thread, so every publish is counted and periods
+ * are measured when the message is published. The statistics of all topics
+ * are published on topic_stats every CONFIG_CEREBRI_SYNAPSE_TOPIC_STATS_PERIOD_MS
+ * and shown by zros topic stats and zros topic hz.
+ */
+
+int synapse_topic_stats_get(enum synapse_topic_id id, struct synapse_topic_stats *stats);
+
+#endif // SYNAPSE_TOPIC_STATS_H
+// vi: ts=4 sw=4 et
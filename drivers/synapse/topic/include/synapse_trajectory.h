@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2024 CogniPilot Foundation
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef SYNAPSE_TRAJECTORY_H
+#define SYNAPSE_TRAJECTORY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+
+#include <synapse_pb/bezier_trajectory.pb.h>
+
+#include "synapse_bezier_index.h"
+
+/*
+ * Chunk of a streamed bezier trajectory.
+ *
+ * Chunks of one trajectory share an id and are numbered from seq 0, each
+ * segment starting where the previous one stopped. The chunk with commit
+ * set completes the trajectory, which becomes active once time reaches its
+ * time_start. A seq 0 chunk that starts where the followed trajectory stops
+ * continues it.
+ */
+struct synapse_trajectory_chunk {
+	uint32_t id;
+	uint32_t seq;
+	bool commit;
+	synapse_pb_BezierTrajectory segment;
+};
+
+/*
+ * Queue a chunk for the trajectory follower, returns -ENOMEM if
+ * CONFIG_CEREBRI_SYNAPSE_TRAJECTORY_QUEUE_SIZE chunks are already queued.
+ * The segment is copied into a free queue slot by the calling thread.
+ */
+int synapse_trajectory_submit(uint32_t id, uint32_t seq, bool commit,
+			      const synapse_pb_BezierTrajectory *segment);
+
+/*
+ * Double buffered bezier trajectory, owned by the thread that follows it.
+ * There is one chunk queue, so an image has at most one follower.
+ *
+ * Every queued chunk is drained by synapse_trajectory_update and its curves
+ * are appended to the staging buffer, the unfinished curves of the followed
+ * trajectory are copied once when a chunk continues it. A retransmitted
+ * chunk is ignored, a chunk out of sequence abandons the staged trajectory
+ * and is counted as dropped. The committed trajectory is swapped in by
+ * pointer between two control ticks, so the followed curve never changes
+ * mid tick and it is never copied on a tick.
+ */
+struct synapse_trajectory {
+	synapse_pb_BezierTrajectory buf[2];
+	synapse_pb_BezierTrajectory *active;
+	synapse_pb_BezierTrajectory *staging;
+	struct synapse_bezier_index index[2];
+	int active_index;
+	// id and next seq of the last trajectory received
+	uint32_t id;
+	uint32_t next_seq;
+	// chunks are being staged
+	bool open;
+	// staging holds a committed trajectory waiting for its time_start
+	bool pending;
+	uint32_t chunks;
+	uint32_t dropped;
+};
+
+void synapse_trajectory_init(struct synapse_trajectory *traj);
+
+// event ready when a chunk is queued, for the k_poll of the follower
+struct k_poll_event synapse_trajectory_event(void);
+
+// stage every queued chunk, returns the number staged or the first error,
+// -ENOMEM if the staging slot is full, -EINVAL if a segment is malformed or
+// not contiguous and -EILSEQ if a chunk is out of sequence
+int synapse_trajectory_update(struct synapse_trajectory *traj, int64_t time_ns);
+
+// swap in the committed trajectory once time_ns reaches its start, then find
+// the current curve as synapse_bezier_index_find
+int synapse_trajectory_find(struct synapse_trajectory *traj, int64_t time_ns, double *t,
+			    double *T);
+
+static inline const synapse_pb_BezierTrajectory_Curve *
+synapse_trajectory_curve(const struct synapse_trajectory *traj, int i)
+{
+	return &traj->active->curves[i];
+}
+
+static inline int64_t synapse_trajectory_time_start(const struct synapse_trajectory *traj)
+{
+	return traj->index[traj->active_index].time_start_ns;
+}
+
+#endif // SYNAPSE_TRAJECTORY_H
+// vi: ts=4 sw=4 et
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2024 CogniPilot Foundation
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+
+#include "synapse_bezier_index.h"
+
+int64_t timestamp_to_ns(const synapse_pb_Timestamp *ts)
+{
+	return ts->seconds * (int64_t)NSEC_PER_SEC + ts->nanos;
+}
+
+int synapse_bezier_index_build(struct synapse_bezier_index *index,
+			       const synapse_pb_BezierTrajectory *traj)
+{
+	int count = MIN(traj->curves_count, SYNAPSE_BEZIER_INDEX_MAX_CURVES);
+
+	index->count = 0;
+	index->cursor = 0;
+	index->time_start_ns = timestamp_to_ns(&traj->time_start);
+
+	int64_t time_leg_start_ns = index->time_start_ns;
+	for (int i = 0; i < count; i++) {
+		int64_t time_stop_ns = timestamp_to_ns(&traj->curves[i].time_stop);
+		if (time_stop_ns <= time_leg_start_ns) {
+			return -EINVAL;
+		}
+		index->time_stop_ns[i] = time_stop_ns;
+		index->T[i] = (time_stop_ns - time_leg_start_ns) * 1e-9;
+		time_leg_start_ns = time_stop_ns;
+	}
+	index->count = count;
+	return 0;
+}
+
+static inline int64_t leg_start_ns(const struct synapse_bezier_index *index, int i)
+{
+	return i == 0 ? index->time_start_ns : index->time_stop_ns[i - 1];
+}
+
+static inline bool in_leg(const struct synapse_bezier_index *index, int i, int64_t time_ns)
+{
+	return i < index->count && time_ns >= leg_start_ns(index, i) &&
+	       time_ns < index->time_stop_ns[i];
+}
+
+int synapse_bezier_index_find(struct synapse_bezier_index *index, int64_t time_ns, double *t,
+			      double *T)
+{
+	if (time_ns < index->time_start_ns) {
+		return -EAGAIN;
+	}
+	if (index->count == 0 || time_ns >= index->time_stop_ns[index->count - 1]) {
+		return -ERANGE;
+	}
+
+	// time normally moves forward, so try the current and the next curve first
+	int i = index->cursor;
+	if (!in_leg(index, i, time_ns)) {
+		i++;
+		if (!in_leg(index, i, time_ns)) {
+			// first curve that stops after time_ns
+			int lo = 0;
+			int hi = index->count - 1;
+			while (lo < hi) {
+				int mid = lo + (hi - lo) / 2;
+				if (index->time_stop_ns[mid] <= time_ns) {
+					lo = mid + 1;
+				} else {
+					hi = mid;
+				}
+			}
+			i = lo;
+		}
+	}
+
+	index->cursor = i;
+	*t = (time_ns - leg_start_ns(index, i)) * 1e-9;
+	*T = index->T[i];
+	return i;
+}
+
+// vi: ts=4 sw=4 et
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2024 CogniPilot Foundation
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+
+#include <zephyr/sys/atomic.h>
+
+#include "synapse_frame.h"
+#include "synapse_trajectory.h"
+
+#define Z_SYNAPSE_FRAME_ROUTE(entry) Z_SYNAPSE_FRAME_ROUTE_ entry
+#define Z_SYNAPSE_FRAME_ROUTE_(_name, _type, _printer, _frame, _flags)                             \
+	COND_CODE_1(IS_EMPTY(_frame), (),                                                          \
+		    ([synapse_pb_Frame_##_frame##_tag] = {                                         \
+			     .topic = &topic_##_name,                                              \
+			     .id = SYNAPSE_TOPIC_##_name,                                          \
+			     .offset = offsetof(synapse_pb_Frame, msg._frame),                     \
+			     .flags = _flags,                                                      \
+		     },))
+
+// route of every frame tag listed in the topic schema, indexed by tag
+static const struct synapse_frame_route g_routes[] = {
+	FOR_EACH(Z_SYNAPSE_FRAME_ROUTE, (), SYNAPSE_TOPIC_SCHEMA)
+};
+
+const struct synapse_frame_route *synapse_frame_route(pb_size_t tag)
+{
+	if (tag >= ARRAY_SIZE(g_routes) || g_routes[tag].topic == NULL) {
+		return NULL;
+	}
+	return &g_routes[tag];
+}
+
+int synapse_frame_publish(synapse_pb_Frame *frame, bool sim)
+{
+	const struct synapse_frame_route *route = synapse_frame_route(frame->which_msg);
+	if (route == NULL) {
+		return -ENOENT;
+	}
+	if ((route->flags & SYNAPSE_FRAME_ROUTE_SIM) && !sim) {
+		return -EPERM;
+	}
+	int rc = synapse_topic_publish(route->id, (uint8_t *)frame + route->offset);
+	if (rc == 0 && frame->which_msg == synapse_pb_Frame_bezier_trajectory_tag) {
+		// frames have no sequence number, each is a committed trajectory
+		static atomic_t id;
+		rc = synapse_trajectory_submit(atomic_inc(&id) + 1, 0, true,
+					       &frame->msg.bezier_trajectory);
+	}
+	return rc;
+}
+
+// vi: ts=4 sw=4 et
@@ -10,6 +10,8 @@
 
 #include "synapse_shell_print.h"
 
+CASADI_FUNC_DEFINE(quat_to_eulerB321);
+
 int snprintf_cat(char *buf, int n, char const *fmt, ...)
 {
 	if (n <= 0) {
@@ -144,6 +146,23 @@ int snprint_bezier_trajectory(char *buf, size_t n, synapse_pb_BezierTrajectory *
 	return offset;
 }
 
+int snprint_esc_telemetry(char *buf, size_t n, struct synapse_esc_telemetry *m)
+{
+	size_t offset = 0;
+	offset += snprint_timestamp(buf + offset, n - offset, &m->stamp);
+	for (int i = 0; i < m->motor_count; i++) {
+		const struct synapse_esc_telemetry_motor *motor = &m->motor[i];
+		offset += snprintf_cat(buf + offset, n - offset,
+				       "motor %d: rpm %8.1f latency %5u us error rate %5.3f crc %u "
+				       "frame %u no response %u%s\n",
+				       i, (double)motor->rpm, motor->cmd_age_us,
+				       (double)motor->error_rate, motor->crc_errors,
+				       motor->frame_errors, motor->no_response,
+				       motor->valid ? "" : " STALE");
+	}
+	return offset;
+}
+
 int snprint_status(char *buf, size_t n, synapse_pb_Status *m)
 {
 	size_t offset = 0;
@@ -339,6 +358,23 @@ int snprint_imu_q31_array(char *buf, size_t n, synapse_pb_ImuQ31Array *m)
 	return offset;
 }
 
+int snprint_topic_stats(char *buf, size_t n, struct synapse_topic_stats_report *m)
+{
+	size_t offset = 0;
+	offset += snprint_timestamp(buf + offset, n - offset, &m->stamp);
+	for (int i = 0; i < SYNAPSE_TOPIC_COUNT; i++) {
+		const struct synapse_topic_stats *stats = &m->topic[i];
+		if (stats->count == 0) {
+			continue;
+		}
+		offset += snprintf_cat(buf + offset, n - offset, "%-28s %8.1f Hz %6u us\n",
+				       synapse_topic_info[i].name,
+				       stats->period_us > 0 ? 1e6 / stats->period_us : 0.0,
+				       stats->jitter_us);
+	}
+	return offset;
+}
+
 int snprint_wheel_odometry(char *buf, size_t n, synapse_pb_WheelOdometry *m)
 {
 	size_t offset = 0;
@@ -177,78 +177,28 @@ const char *fuel_str(synapse_pb_Status_Fuel fuel)
 /********************************************************************
  * topics
  ********************************************************************/
-ZROS_TOPIC_DEFINE(accel_ff, synapse_pb_Vector3);
-ZROS_TOPIC_DEFINE(accel_sp, synapse_pb_Vector3);
-ZROS_TOPIC_DEFINE(actuators, synapse_pb_Actuators);
-ZROS_TOPIC_DEFINE(altimeter, synapse_pb_Altimeter);
-ZROS_TOPIC_DEFINE(angular_velocity_ff, synapse_pb_Vector3);
-ZROS_TOPIC_DEFINE(angular_velocity_sp, synapse_pb_Vector3);
-ZROS_TOPIC_DEFINE(attitude_sp, synapse_pb_Quaternion);
-ZROS_TOPIC_DEFINE(battery_state, synapse_pb_BatteryState);
-ZROS_TOPIC_DEFINE(bezier_trajectory, synapse_pb_BezierTrajectory);
-ZROS_TOPIC_DEFINE(bezier_trajectory_ethernet, synapse_pb_BezierTrajectory);
-ZROS_TOPIC_DEFINE(clock_offset_ethernet, synapse_pb_ClockOffset);
-ZROS_TOPIC_DEFINE(cmd_vel, synapse_pb_Twist);
-ZROS_TOPIC_DEFINE(cmd_vel_ethernet, synapse_pb_Twist);
-ZROS_TOPIC_DEFINE(force_sp, synapse_pb_Vector3);
-ZROS_TOPIC_DEFINE(imu, synapse_pb_Imu);
-ZROS_TOPIC_DEFINE(imu_q31_array, synapse_pb_ImuQ31Array);
-ZROS_TOPIC_DEFINE(input, synapse_pb_Input);
-ZROS_TOPIC_DEFINE(input_ethernet, synapse_pb_Input);
-ZROS_TOPIC_DEFINE(input_sbus, synapse_pb_Input);
-ZROS_TOPIC_DEFINE(led_array, synapse_pb_LEDArray);
-ZROS_TOPIC_DEFINE(magnetic_field, synapse_pb_MagneticField);
-ZROS_TOPIC_DEFINE(moment_ff, synapse_pb_Vector3);
-ZROS_TOPIC_DEFINE(moment_sp, synapse_pb_Vector3);
-ZROS_TOPIC_DEFINE(nav_sat_fix, synapse_pb_NavSatFix);
-ZROS_TOPIC_DEFINE(odometry_estimator, synapse_pb_Odometry);
-ZROS_TOPIC_DEFINE(odometry_ethernet, synapse_pb_Odometry);
-ZROS_TOPIC_DEFINE(orientation_sp, synapse_pb_Quaternion);
-ZROS_TOPIC_DEFINE(position_sp, synapse_pb_Vector3);
-ZROS_TOPIC_DEFINE(pwm, synapse_pb_Pwm);
-ZROS_TOPIC_DEFINE(safety, synapse_pb_Safety);
-ZROS_TOPIC_DEFINE(status, synapse_pb_Status);
-ZROS_TOPIC_DEFINE(velocity_sp, synapse_pb_Vector3);
-ZROS_TOPIC_DEFINE(wheel_odometry, synapse_pb_WheelOdometry);
+#define Z_SYNAPSE_TOPIC_DEFINE(entry) Z_SYNAPSE_TOPIC_DEFINE_ entry
+#define Z_SYNAPSE_TOPIC_DEFINE_(name, type, printer, frame, flags)                                 \
+	ZROS_TOPIC_DEFINE(name, type)
+
+FOR_EACH(Z_SYNAPSE_TOPIC_DEFINE, (;), SYNAPSE_TOPIC_SCHEMA);
+
+#define Z_SYNAPSE_TOPIC_INFO(entry) Z_SYNAPSE_TOPIC_INFO_ entry
+#define Z_SYNAPSE_TOPIC_INFO_(_name, _type, _printer, _frame, _flags)                              \
+	[SYNAPSE_TOPIC_##_name] = {                                                                \
+		.name = #_name,                                                                    \
+		.topic = &topic_##_name,                                                           \
+		.size = sizeof(_type),                                                             \
+	}
 
-static struct zros_topic *topic_list[] = {
-	&topic_accel_ff,
-	&topic_accel_sp,
-	&topic_actuators,
-	&topic_altimeter,
-	&topic_angular_velocity_ff,
-	&topic_angular_velocity_sp,
-	&topic_attitude_sp,
-	&topic_battery_state,
-	&topic_bezier_trajectory,
-	&topic_bezier_trajectory_ethernet,
-	&topic_clock_offset_ethernet,
-	&topic_cmd_vel,
-	&topic_cmd_vel_ethernet,
-	&topic_imu,
-	&topic_imu_q31_array,
-	&topic_input,
-	&topic_input_ethernet,
-	&topic_input_sbus,
-	&topic_led_array,
-	&topic_magnetic_field,
-	&topic_moment_ff,
-	&topic_nav_sat_fix,
-	&topic_odometry_estimator,
-	&topic_odometry_ethernet,
-	&topic_orientation_sp,
-	&topic_position_sp,
-	&topic_pwm,
-	&topic_safety,
-	&topic_status,
-	&topic_velocity_sp,
-	&topic_wheel_odometry,
+const struct synapse_topic_info synapse_topic_info[SYNAPSE_TOPIC_COUNT] = {
+	FOR_EACH(Z_SYNAPSE_TOPIC_INFO, (,), SYNAPSE_TOPIC_SCHEMA),
 };
 
 static int set_topic_list()
 {
-	for (size_t i = 0; i < ARRAY_SIZE(topic_list); i++) {
-		zros_broker_add_topic(topic_list[i]);
+	for (size_t i = 0; i < ARRAY_SIZE(synapse_topic_info); i++) {
+		zros_broker_add_topic(synapse_topic_info[i].topic);
 	}
 	return 0;
 }
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2024 CogniPilot Foundation
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/spinlock.h>
+
+#include <zros/private/zros_node_struct.h>
+#include <zros/private/zros_pub_struct.h>
+#include <zros/zros_node.h>
+#include <zros/zros_pub.h>
+
+#include "synapse_topic_stats.h"
+
+LOG_MODULE_REGISTER(synapse_topic_stats, CONFIG_CEREBRI_SYNAPSE_TOPIC_LOG_LEVEL);
+
+// smoothing of period and jitter, 1/16 as for rfc 3550 interarrival jitter
+#define STATS_SHIFT 4
+
+struct context {
+	struct zros_node node;
+	struct zros_pub pub;
+	bool pub_ready;
+	struct synapse_topic_stats_report report;
+	struct synapse_topic_stats stats[SYNAPSE_TOPIC_COUNT];
+	struct k_spinlock lock;
+	struct k_work_delayable work;
+};
+
+static struct context g_ctx = {};
+
+int synapse_topic_stats_get(enum synapse_topic_id id, struct synapse_topic_stats *stats)
+{
+	if (id >= SYNAPSE_TOPIC_COUNT) {
+		return -EINVAL;
+	}
+	K_SPINLOCK(&g_ctx.lock) {
+		*stats = g_ctx.stats[id];
+	}
+	return 0;
+}
+
+void synapse_topic_stats_publish(enum synapse_topic_id id)
+{
+	int64_t now = k_uptime_ticks();
+	k_spinlock_key_t key = k_spin_lock(&g_ctx.lock);
+	struct synapse_topic_stats *stats = &g_ctx.stats[id];
+
+	if (stats->count > 0) {
+		int32_t dt_us = k_ticks_to_us_floor64(now - stats->last_ticks);
+		if (stats->count == 1) {
+			stats->period_us = dt_us;
+		} else {
+			int32_t d = dt_us - (int32_t)stats->period_us;
+			stats->period_us += d >> STATS_SHIFT;
+			stats->jitter_us += (abs(d) - (int32_t)stats->jitter_us) >> STATS_SHIFT;
+		}
+	}
+	stats->count++;
+	stats->bytes += synapse_topic_info[id].size;
+	stats->last_ticks = now;
+
+	k_spin_unlock(&g_ctx.lock, key);
+}
+
+static void synapse_topic_stats_report(struct k_work *work)
+{
+	struct context *ctx =
+		CONTAINER_OF(k_work_delayable_from_work(work), struct context, work);
+
+	// topics are added to the broker after this module is initialized
+	if (!ctx->pub_ready) {
+		zros_node_init(&ctx->node, "topic_stats");
+		zros_pub_init(&ctx->pub, &ctx->node, &topic_topic_stats, &ctx->report);
+		ctx->pub_ready = true;
+	}
+
+	K_SPINLOCK(&ctx->lock) {
+		stamp_msg(&ctx->report.stamp, k_uptime_ticks());
+		memcpy(ctx->report.topic, ctx->stats, sizeof(ctx->stats));
+	}
+	synapse_pub_update(&ctx->pub, SYNAPSE_TOPIC_topic_stats);
+
+	k_work_reschedule(&ctx->work, K_MSEC(CONFIG_CEREBRI_SYNAPSE_TOPIC_STATS_PERIOD_MS));
+}
+
+static int synapse_topic_stats_sys_init(void)
+{
+	k_work_init_delayable(&g_ctx.work, synapse_topic_stats_report);
+	k_work_schedule(&g_ctx.work, K_MSEC(CONFIG_CEREBRI_SYNAPSE_TOPIC_STATS_PERIOD_MS));
+	LOG_INF("init");
+	return 0;
+}
+
+SYS_INIT(synapse_topic_stats_sys_init, APPLICATION, 0);
+
+// vi: ts=4 sw=4 et
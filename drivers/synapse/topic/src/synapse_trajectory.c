@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2024 CogniPilot Foundation
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "synapse_trajectory.h"
+
+// chunks are filled in place in a free slab block and queued by pointer
+K_MEM_SLAB_DEFINE_STATIC(g_chunk_slab, sizeof(struct synapse_trajectory_chunk),
+			 CONFIG_CEREBRI_SYNAPSE_TRAJECTORY_QUEUE_SIZE, 8);
+K_MSGQ_DEFINE(g_chunk_queue, sizeof(struct synapse_trajectory_chunk *),
+	      CONFIG_CEREBRI_SYNAPSE_TRAJECTORY_QUEUE_SIZE, 4);
+
+int synapse_trajectory_submit(uint32_t id, uint32_t seq, bool commit,
+			      const synapse_pb_BezierTrajectory *segment)
+{
+	struct synapse_trajectory_chunk *chunk;
+	if (k_mem_slab_alloc(&g_chunk_slab, (void **)&chunk, K_NO_WAIT) < 0) {
+		return -ENOMEM;
+	}
+	chunk->id = id;
+	chunk->seq = seq;
+	chunk->commit = commit;
+	chunk->segment = *segment;
+	// the queue holds as many pointers as the slab has blocks
+	k_msgq_put(&g_chunk_queue, &chunk, K_NO_WAIT);
+	return 0;
+}
+
+void synapse_trajectory_init(struct synapse_trajectory *traj)
+{
+	for (int i = 0; i < ARRAY_SIZE(traj->buf); i++) {
+		traj->buf[i] =
+			(synapse_pb_BezierTrajectory)synapse_pb_BezierTrajectory_init_default;
+	}
+	for (int i = 0; i < ARRAY_SIZE(traj->index); i++) {
+		traj->index[i] = (struct synapse_bezier_index){};
+	}
+	traj->active = &traj->buf[0];
+	traj->staging = &traj->buf[1];
+	traj->active_index = 0;
+	traj->id = 0;
+	traj->next_seq = 0;
+	traj->open = false;
+	traj->pending = false;
+	traj->chunks = 0;
+	traj->dropped = 0;
+}
+
+struct k_poll_event synapse_trajectory_event(void)
+{
+	struct k_poll_event event;
+	k_poll_event_init(&event, K_POLL_TYPE_MSGQ_DATA_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY,
+			  &g_chunk_queue);
+	return event;
+}
+
+static int64_t last_stop_ns(const synapse_pb_BezierTrajectory *t)
+{
+	if (t->curves_count == 0) {
+		return timestamp_to_ns(&t->time_start);
+	}
+	return timestamp_to_ns(&t->curves[t->curves_count - 1].time_stop);
+}
+
+static int append(synapse_pb_BezierTrajectory *dst, const synapse_pb_BezierTrajectory *src,
+		  int first)
+{
+	int count = src->curves_count - first;
+	if (dst->curves_count + count > SYNAPSE_BEZIER_INDEX_MAX_CURVES) {
+		return -ENOMEM;
+	}
+	memcpy(&dst->curves[dst->curves_count], &src->curves[first],
+	       count * sizeof(src->curves[0]));
+	dst->curves_count += count;
+	return 0;
+}
+
+// start staging a trajectory with the first chunk
+static void stage_first(struct synapse_trajectory *traj, const synapse_pb_BezierTrajectory *segment,
+			int64_t time_ns)
+{
+	const synapse_pb_BezierTrajectory *active = traj->active;
+	synapse_pb_BezierTrajectory *staging = traj->staging;
+	int64_t start_ns = timestamp_to_ns(&segment->time_start);
+
+	if (traj->pending && start_ns == last_stop_ns(staging)) {
+		// continuation of the committed trajectory that is not active yet
+		return;
+	}
+
+	staging->has_stamp = segment->has_stamp;
+	staging->stamp = segment->stamp;
+	staging->curves_count = 0;
+	if (active->curves_count > 0 && start_ns == last_stop_ns(active)) {
+		// continuation of the followed trajectory, keep its unfinished curves
+		int first = 0;
+		while (first < active->curves_count &&
+		       timestamp_to_ns(&active->curves[first].time_stop) <= time_ns) {
+			first++;
+		}
+		staging->time_start =
+			first == 0 ? active->time_start : active->curves[first - 1].time_stop;
+		append(staging, active, first);
+	} else {
+		staging->time_start = segment->time_start;
+	}
+}
+
+static int receive(struct synapse_trajectory *traj, const struct synapse_trajectory_chunk *chunk,
+		   int64_t time_ns)
+{
+	const synapse_pb_BezierTrajectory *segment = &chunk->segment;
+	// the last trajectory received, open, committed or already followed
+	bool known = chunk->id == traj->id && traj->next_seq > 0;
+
+	if (known && chunk->seq < traj->next_seq) {
+		// retransmitted, already received
+		return 0;
+	}
+
+	if (chunk->seq == 0) {
+		// a new trajectory replaces what is staged
+		stage_first(traj, segment, time_ns);
+		traj->id = chunk->id;
+		traj->next_seq = 0;
+		traj->open = true;
+		traj->pending = false;
+	} else if (!known || !traj->open || chunk->seq != traj->next_seq) {
+		// a chunk was lost or reordered, the staged trajectory is incomplete
+		traj->open = false;
+		traj->dropped++;
+		return -EILSEQ;
+	} else if (timestamp_to_ns(&segment->time_start) != last_stop_ns(traj->staging)) {
+		traj->open = false;
+		traj->dropped++;
+		return -EINVAL;
+	}
+
+	int rc = append(traj->staging, segment, 0);
+	if (rc < 0) {
+		traj->open = false;
+		traj->dropped++;
+		return rc;
+	}
+	traj->next_seq = chunk->seq + 1;
+	traj->chunks++;
+
+	if (chunk->commit) {
+		traj->open = false;
+		rc = synapse_bezier_index_build(&traj->index[!traj->active_index], traj->staging);
+		if (rc < 0) {
+			traj->dropped++;
+			return rc;
+		}
+		traj->pending = true;
+	}
+	return 1;
+}
+
+int synapse_trajectory_update(struct synapse_trajectory *traj, int64_t time_ns)
+{
+	struct synapse_trajectory_chunk *chunk;
+	int staged = 0;
+	int err = 0;
+
+	while (k_msgq_get(&g_chunk_queue, &chunk, K_NO_WAIT) == 0) {
+		int rc = receive(traj, chunk, time_ns);
+		k_mem_slab_free(&g_chunk_slab, chunk);
+		if (rc < 0 && err == 0) {
+			err = rc;
+		} else if (rc > 0) {
+			staged++;
+		}
+	}
+	return err < 0 ? err : staged;
+}
+
+int synapse_trajectory_find(struct synapse_trajectory *traj, int64_t time_ns, double *t,
+			    double *T)
+{
+	if (traj->pending && time_ns >= traj->index[!traj->active_index].time_start_ns) {
+		synapse_pb_BezierTrajectory *active = traj->active;
+		traj->active = traj->staging;
+		traj->staging = active;
+		traj->active_index = !traj->active_index;
+		traj->pending = false;
+	}
+	return synapse_bezier_index_find(&traj->index[traj->active_index], time_ns, t, T);
+}
+
+// vi: ts=4 sw=4 et
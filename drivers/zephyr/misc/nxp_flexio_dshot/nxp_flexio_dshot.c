@@ -25,6 +25,10 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME, CONFIG_NXP_FLEXIO_DSHOT_LOG_LEVEL);
 #define NIBBLES_SIZE             4u
 #define DSHOT_NUMBER_OF_NIBBLES  3u
 
+/* T0H/T1H expansion of a packet nibble, most significant bit first in the lowest 3 bits */
+static const uint16_t dshot_expand[16] = {0x249, 0x649, 0x2C9, 0x6C9, 0x259, 0x659, 0x2D9, 0x6D9,
+					  0x24B, 0x64B, 0x2CB, 0x6CB, 0x25B, 0x65B, 0x2DB, 0x6DB};
+
 static const uint32_t gcr_decode[32] = {0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x9, 0xA,
 					0xB, 0x0, 0xD, 0xE, 0xF, 0x0, 0x0, 0x2, 0x3, 0x0, 0x5,
 					0x6, 0x7, 0x0, 0x0, 0x8, 0x1, 0x0, 0x4, 0xC, 0x0};
@@ -62,6 +66,8 @@ struct nxp_flexio_dshot_data {
 	uint32_t dshot_timer_mask;
 	uint32_t bdshot_recv_mask;
 	uint32_t bdshot_parsed_recv_mask;
+	uint32_t trigger_cyc;
+	struct k_spinlock lock;
 };
 
 struct nxp_flexio_dshot_channel_config {
@@ -74,6 +80,7 @@ struct nxp_flexio_dshot_channel_config {
 	bool bdshot;
 	uint32_t raw_response;
 	uint16_t erpm;
+	uint32_t latency_cyc;
 	uint32_t crc_error_cnt;
 	uint32_t frame_error_cnt;
 	uint32_t no_response_cnt;
@@ -276,7 +283,11 @@ void nxp_flexio_dshot_trigger(const struct device *dev)
 		}
 	}
 
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
 	data->bdshot_recv_mask = 0x0;
+	data->bdshot_parsed_recv_mask = 0x0;
+	data->trigger_cyc = k_cycle_get_32();
+	k_spin_unlock(&data->lock, key);
 
 	FLEXIO_ClearTimerStatusFlags(flexio_base, data->dshot_timer_mask);
 	FLEXIO_EnableShifterStatusInterrupts(flexio_base, data->dshot_mask);
@@ -293,22 +304,10 @@ uint8_t nxp_flexio_dshot_channel_count(const struct device *dev)
 /* Expand packet from 16 bits 48 to get T0H and T1H timing */
 uint64_t nxp_flexio_dshot_expand_data(uint16_t packet)
 {
-	unsigned int mask;
-	unsigned int index = 0;
-	uint64_t expanded = 0x0;
-
-	for (mask = 0x8000; mask != 0; mask >>= 1) {
-		if (packet & mask) {
-			expanded = expanded | ((uint64_t)0x3 << index);
-
-		} else {
-			expanded = expanded | ((uint64_t)0x1 << index);
-		}
-
-		index = index + 3;
-	}
-
-	return expanded;
+	return (uint64_t)dshot_expand[packet >> 12] |
+	       ((uint64_t)dshot_expand[(packet >> 8) & 0xF] << 12) |
+	       ((uint64_t)dshot_expand[(packet >> 4) & 0xF] << 24) |
+	       ((uint64_t)dshot_expand[packet & 0xF] << 36);
 }
 
 /**
@@ -316,6 +315,35 @@ uint64_t nxp_flexio_dshot_expand_data(uint16_t packet)
  *steps of throttle resolution) bit 	12		- dshot telemetry
  *enable/disable bits 	13-16	- XOR checksum
  **/
+static void nxp_flexio_dshot_pack(struct nxp_flexio_dshot_channel_config *dshot_info,
+				  uint16_t throttle, bool telemetry)
+{
+	uint16_t packet = 0;
+	uint16_t csum_data;
+
+	packet |= throttle << DSHOT_THROTTLE_POSITION;
+	packet |= ((uint16_t)telemetry & 0x01) << DSHOT_TELEMETRY_POSITION;
+
+	if (dshot_info->bdshot) {
+		csum_data = ~packet;
+
+	} else {
+		csum_data = packet;
+	}
+
+	/* XOR checksum of the 3 data nibbles */
+	csum_data >>= NIBBLES_SIZE;
+	csum_data ^= (csum_data >> NIBBLES_SIZE) ^ (csum_data >> (2 * NIBBLES_SIZE));
+
+	packet |= (csum_data & 0x0F);
+
+	uint64_t dshot_expanded = nxp_flexio_dshot_expand_data(packet);
+
+	dshot_info->data_seg1 = (uint32_t)(dshot_expanded & 0xFFFFFF);
+	dshot_info->irq_data = (uint32_t)(dshot_expanded >> 24);
+	dshot_info->state = DSHOT_START;
+}
+
 void nxp_flexio_dshot_data_set(const struct device *dev, unsigned channel, uint16_t throttle,
 			       bool telemetry)
 {
@@ -325,131 +353,144 @@ void nxp_flexio_dshot_data_set(const struct device *dev, unsigned channel, uint1
 	FLEXIO_Type *flexio_base = (FLEXIO_Type *)(config->flexio_base);
 
 	if (channel < config->channel->dshot_channel_count && dshot_info->init) {
-		uint16_t csum_data;
-		uint16_t packet = 0;
-		uint16_t checksum = 0;
-
-		packet |= throttle << DSHOT_THROTTLE_POSITION;
-		packet |= ((uint16_t)telemetry & 0x01) << DSHOT_TELEMETRY_POSITION;
+		nxp_flexio_dshot_pack(dshot_info, throttle, telemetry);
 
 		if (dshot_info->bdshot) {
-			csum_data = ~packet;
+			flexio_base->TIMCTL[config->child->res.timer_index[channel]] = 0;
+			FLEXIO_DisableShifterStatusInterrupts(flexio_base, data->dshot_mask);
+
+			nxp_flexio_dshot_output(dev, channel);
 
-		} else {
-			csum_data = packet;
+			FLEXIO_ClearTimerStatusFlags(flexio_base, data->dshot_timer_mask);
 		}
+	}
+}
 
-		/* XOR checksum calculation */
-		csum_data >>= NIBBLES_SIZE;
+void nxp_flexio_dshot_update(const struct device *dev, const uint16_t *throttle, uint8_t count,
+			     bool telemetry)
+{
+	const struct nxp_flexio_dshot_config *config = dev->config;
+	struct nxp_flexio_dshot_data *data = dev->data;
+	FLEXIO_Type *flexio_base = (FLEXIO_Type *)(config->flexio_base);
+	struct nxp_flexio_dshot_channel_config *dshot_info;
+	bool bdshot = false;
 
-		for (unsigned i = 0; i < DSHOT_NUMBER_OF_NIBBLES; i++) {
-			checksum ^= (csum_data & 0x0F); // XOR data by nibbles
-			csum_data >>= NIBBLES_SIZE;
-		}
+	count = MIN(count, config->channel->dshot_channel_count);
 
-		packet |= (checksum & 0x0F);
+	for (uint8_t channel = 0; channel < count; channel++) {
+		bdshot |= config->channel->dshot_info[channel].bdshot;
+	}
 
-		uint64_t dshot_expanded = nxp_flexio_dshot_expand_data(packet);
+	/* Stop receiving telemetry once, before any channel is switched back to transmit */
+	if (bdshot) {
+		FLEXIO_DisableShifterStatusInterrupts(flexio_base, data->dshot_mask);
+	}
 
-		dshot_info->data_seg1 = (uint32_t)(dshot_expanded & 0xFFFFFF);
-		dshot_info->irq_data = (uint32_t)(dshot_expanded >> 24);
-		dshot_info->state = DSHOT_START;
+	for (uint8_t channel = 0; channel < count; channel++) {
+		dshot_info = &config->channel->dshot_info[channel];
+
+		if (!dshot_info->init) {
+			continue;
+		}
+
+		nxp_flexio_dshot_pack(dshot_info, throttle[channel], telemetry);
 
 		if (dshot_info->bdshot) {
 			flexio_base->TIMCTL[config->child->res.timer_index[channel]] = 0;
-			FLEXIO_DisableShifterStatusInterrupts(flexio_base, data->dshot_mask);
-
 			nxp_flexio_dshot_output(dev, channel);
-
-			FLEXIO_ClearTimerStatusFlags(flexio_base, data->dshot_timer_mask);
 		}
 	}
+
+	if (bdshot) {
+		FLEXIO_ClearTimerStatusFlags(flexio_base, data->dshot_timer_mask);
+	}
+
+	nxp_flexio_dshot_trigger(dev);
 }
 
-int up_bdshot_decode_erpm(const struct device *dev)
+/* Decode one bidirectional response, GCR is decoded 5 bits at a time from gcr_decode */
+static void nxp_flexio_bdshot_decode(struct nxp_flexio_dshot_data *data,
+				     struct nxp_flexio_dshot_channel_config *dshot_info,
+				     uint8_t channel)
 {
-	const struct nxp_flexio_dshot_config *config = dev->config;
-	struct nxp_flexio_dshot_data *data = dev->data;
-	struct nxp_flexio_child *child = (struct nxp_flexio_child *)(config->child);
-	uint32_t value;
+	uint32_t value = ~dshot_info->raw_response & 0xFFFFF;
 	uint32_t decode_data;
 	uint32_t csum_data;
 	uint8_t exponent;
 	uint16_t period;
 	uint16_t erpm;
-	uint32_t shifter_flag;
 
-	data->bdshot_parsed_recv_mask = 0;
+	/* if lowest significant isn't 1 we've got a framing error */
+	if ((value & 0x1) == 0) {
+		dshot_info->frame_error_cnt++;
+		return;
+	}
 
-	// Decode each individual channel
-	for (uint8_t channel = 0; (channel < config->channel->dshot_channel_count); channel++) {
-		shifter_flag = 1 << child->res.shifter_index[channel];
-		if (data->bdshot_recv_mask & shifter_flag) {
-			value = ~config->channel->dshot_info[channel].raw_response & 0xFFFFF;
-
-			/* if lowest significant isn't 1 we've got a framing error */
-			if (value & 0x1) {
-				/* Decode RLL */
-				value = (value ^ (value >> 1));
-
-				/* Decode GCR */
-				decode_data = gcr_decode[value & 0x1fU];
-				decode_data |= gcr_decode[(value >> 5U) & 0x1fU] << 4U;
-				decode_data |= gcr_decode[(value >> 10U) & 0x1fU] << 8U;
-				decode_data |= gcr_decode[(value >> 15U) & 0x1fU] << 12U;
-
-				/* Calculate checksum */
-				csum_data = decode_data;
-				csum_data = csum_data ^ (csum_data >> 8U);
-				csum_data = csum_data ^ (csum_data >> NIBBLES_SIZE);
-
-				if ((csum_data & 0xFU) != 0xFU) {
-					config->channel->dshot_info[channel].crc_error_cnt++;
-
-				} else {
-					decode_data = (decode_data >> 4) & 0xFFF;
-
-					if (decode_data == 0xFFF) {
-						erpm = 0;
-
-					} else {
-						/* 3 bit: exponent */
-						exponent = ((decode_data >> 9U) & 0x7U);
-						/* 9 bit: period base */
-						period = (decode_data & 0x1ffU);
-						period = period << exponent; /* Period in usec */
-						erpm = ((1000000U * 60U / 100U + period / 2U) /
-							period);
-					}
-
-					config->channel->dshot_info[channel].erpm = erpm;
-					data->bdshot_parsed_recv_mask |= (1 << channel);
-					config->channel->dshot_info[channel].last_no_response_cnt =
-						config->channel->dshot_info[channel]
-							.no_response_cnt;
-				}
-
-			} else {
-				config->channel->dshot_info[channel].frame_error_cnt++;
-			}
-		}
+	/* Decode RLL */
+	value = (value ^ (value >> 1));
+
+	/* Decode GCR */
+	decode_data = gcr_decode[value & 0x1fU];
+	decode_data |= gcr_decode[(value >> 5U) & 0x1fU] << 4U;
+	decode_data |= gcr_decode[(value >> 10U) & 0x1fU] << 8U;
+	decode_data |= gcr_decode[(value >> 15U) & 0x1fU] << 12U;
+
+	/* Calculate checksum */
+	csum_data = decode_data;
+	csum_data = csum_data ^ (csum_data >> 8U);
+	csum_data = csum_data ^ (csum_data >> NIBBLES_SIZE);
+
+	if ((csum_data & 0xFU) != 0xFU) {
+		dshot_info->crc_error_cnt++;
+		return;
+	}
+
+	decode_data = (decode_data >> 4) & 0xFFF;
+
+	if (decode_data == 0xFFF) {
+		erpm = 0;
+
+	} else {
+		/* 3 bit: exponent */
+		exponent = ((decode_data >> 9U) & 0x7U);
+		/* 9 bit: period base */
+		period = (decode_data & 0x1ffU);
+		period = period << exponent; /* Period in usec */
+		erpm = period > 0 ? (1000000U * 60U / 100U + period / 2U) / period : 0;
 	}
 
-	return data->bdshot_parsed_recv_mask != 0;
+	dshot_info->erpm = erpm;
+	dshot_info->latency_cyc = k_cycle_get_32() - data->trigger_cyc;
+	data->bdshot_parsed_recv_mask |= (1 << channel);
+	dshot_info->last_no_response_cnt = dshot_info->no_response_cnt;
 }
 
-// TEMP helper function before moving over to sensor api
-int up_bdshot_get_erpm(const struct device *dev, uint8_t channel, int *erpm)
+int nxp_flexio_dshot_telemetry_get(const struct device *dev, unsigned channel,
+				   struct nxp_flexio_dshot_telemetry *telemetry)
 {
 	const struct nxp_flexio_dshot_config *config = dev->config;
 	struct nxp_flexio_dshot_data *data = dev->data;
 
-	if (data->bdshot_parsed_recv_mask & (1 << channel)) {
-		*erpm = (int)config->channel->dshot_info[channel].erpm;
-		return 0;
+	if (channel >= config->channel->dshot_channel_count) {
+		return -EINVAL;
 	}
 
-	return -1;
+	struct nxp_flexio_dshot_channel_config *dshot_info = &config->channel->dshot_info[channel];
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+	telemetry->erpm = dshot_info->erpm;
+	telemetry->latency_us = k_cyc_to_us_floor32(dshot_info->latency_cyc);
+	telemetry->crc_error_cnt = dshot_info->crc_error_cnt;
+	telemetry->frame_error_cnt = dshot_info->frame_error_cnt;
+	telemetry->no_response_cnt = dshot_info->no_response_cnt;
+	bool received = data->bdshot_parsed_recv_mask & (1 << channel);
+
+	k_spin_unlock(&data->lock, key);
+
+	if (!dshot_info->bdshot) {
+		return -ENOTSUP;
+	}
+	return received ? 0 : -EAGAIN;
 }
 
 static int nxp_flexio_dshot_isr(void *user_data)
@@ -483,13 +524,9 @@ static int nxp_flexio_dshot_isr(void *user_data)
 
 				data->bdshot_recv_mask |= shifter_flag;
 
-				if (data->bdshot_recv_mask == data->dshot_mask) {
-					// Received telemetry on all channels
-					// Schedule workqueue?
-					// up_bdshot_erpm(dev);
-
-					// Trigger RTIO stream?
-				}
+				k_spinlock_key_t key = k_spin_lock(&data->lock);
+				nxp_flexio_bdshot_decode(data, dshot_info, channel);
+				k_spin_unlock(&data->lock, key);
 			}
 		}
 	}
@@ -535,8 +572,7 @@ static int nxp_flexio_dshot_isr(void *user_data)
 
 static int nxp_flexio_dshot_sample_fetch(const struct device *dev, enum sensor_channel chan)
 {
-	up_bdshot_decode_erpm(dev);
-
+	/* responses are decoded as they arrive in the isr */
 	return 0;
 }
 
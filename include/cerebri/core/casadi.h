@@ -1,13 +1,55 @@
 #ifndef CEREBRI_CORE_CASADI_H
 #define CEREBRI_CORE_CASADI_H
 
+#include <string.h>
+
+#include <zephyr/sys/iterable_sections.h>
+
+/*
+ * Static CasADi workspaces.
+ *
+ * CASADI_FUNC_DEFINE(name) is placed once at file scope for every generated
+ * function a module calls. It reserves the arg/res/iw/w arrays sized from the
+ * generated name_SZ_* macros, registers their size for the casadi_ws shell
+ * command and defines a name_call(void) wrapper that evaluates the function
+ * on that workspace. The workspace belongs to the translation unit, so it must
+ * only be used from the single thread that owns the module.
+ *
+ * Inside the function body, CASADI_FUNC_ARGS(name) binds args/res to the
+ * workspace and clears them, so a slot the call site leaves unset is NULL on
+ * every call rather than a pointer left by an earlier call.
+ * CASADI_FUNC_CALL(name) evaluates it.
+ */
+
+struct casadi_workspace_info {
+	const char *name;
+	const char *file;
+	size_t size;
+};
+
+#define CASADI_FUNC_DEFINE(name)                                                                   \
+	static struct {                                                                            \
+		const casadi_real *arg[name##_SZ_ARG];                                             \
+		casadi_real *res[name##_SZ_RES];                                                   \
+		casadi_int iw[name##_SZ_IW];                                                       \
+		casadi_real w[name##_SZ_W];                                                        \
+	} name##_ws;                                                                               \
+	static inline int name##_call(void)                                                        \
+	{                                                                                          \
+		return name(name##_ws.arg, name##_ws.res, name##_ws.iw, name##_ws.w, 0);           \
+	}                                                                                          \
+	static const STRUCT_SECTION_ITERABLE(casadi_workspace_info, name##_ws_info) = {            \
+		.name = #name,                                                                     \
+		.file = __FILE__,                                                                  \
+		.size = sizeof(name##_ws),                                                         \
+	}
+
 #define CASADI_FUNC_ARGS(name)                                                                     \
-	casadi_int iw[name##_SZ_IW];                                                               \
-	casadi_real w[name##_SZ_W];                                                                \
-	const casadi_real *args[name##_SZ_ARG];                                                    \
-	casadi_real *res[name##_SZ_RES];                                                           \
-	int mem = 0;
+	const casadi_real **args = name##_ws.arg;                                                  \
+	casadi_real **res = name##_ws.res;                                                         \
+	memset(name##_ws.arg, 0, sizeof(name##_ws.arg));                                           \
+	memset(name##_ws.res, 0, sizeof(name##_ws.res));
 
-#define CASADI_FUNC_CALL(name) name(args, res, iw, w, mem);
+#define CASADI_FUNC_CALL(name) name##_call();
 
 #endif // CEREBRI_CORE_CASADI_H
@@ -0,0 +1,48 @@
+/*
+ * Copyright CogniPilot Foundation 2024
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef CEREBRI_CORE_FRESHNESS_H
+#define CEREBRI_CORE_FRESHNESS_H
+
+#include <zephyr/kernel.h>
+
+/*
+ * Freshness of a cached subscription message.
+ *
+ * A consumer calls freshness_update every time it copies a new message from
+ * its subscription and freshness_check before using the copy. The copy is
+ * stale once it is older than max age, or before the first message. Every
+ * freshness registered with freshness_init is listed with its age by the
+ * freshness shell command, init again re-registers it once.
+ */
+
+struct freshness {
+	sys_snode_t node;
+	const char *name;
+	int64_t max_age_ticks;
+	int64_t last_ticks;
+	bool received;
+	bool stale;
+	uint64_t stale_count;
+};
+
+void freshness_init(struct freshness *fresh, const char *name, uint32_t max_age_ms);
+
+void freshness_fini(struct freshness *fresh);
+
+static inline void freshness_update(struct freshness *fresh)
+{
+	fresh->last_ticks = k_uptime_ticks();
+	fresh->received = true;
+}
+
+// ticks since the last update, -1 if never updated
+int64_t freshness_age(const struct freshness *fresh);
+
+// true if updated within max age, counts and logs transitions to stale
+bool freshness_check(struct freshness *fresh);
+
+// vi: ts=4 sw=4 et
+
+#endif // CEREBRI_CORE_FRESHNESS_H
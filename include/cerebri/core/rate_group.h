@@ -0,0 +1,51 @@
+#ifndef CEREBRI_CORE_RATE_GROUP_H
+#define CEREBRI_CORE_RATE_GROUP_H
+
+#include <zephyr/kernel.h>
+
+/*
+ * Rate group scheduler.
+ *
+ * A single 1 kHz timer releases four rate groups, each served by its own
+ * thread at rate monotonic priority. Tasks added to a group run in order of
+ * ascending priority every time the group is released, and must return
+ * before the group is released again. A release that finds the group still
+ * busy counts as an overrun, a task finishing later than its deadline after
+ * release counts as a miss. The rate_group shell command reports both along
+ * with the worst case utilization of every group.
+ */
+
+enum rate_group_id {
+	RATE_GROUP_1000_HZ,
+	RATE_GROUP_250_HZ,
+	RATE_GROUP_50_HZ,
+	RATE_GROUP_10_HZ,
+	RATE_GROUP_COUNT,
+};
+
+struct rate_task;
+
+typedef void (*rate_task_handler_t)(struct rate_task *task);
+
+struct rate_task {
+	sys_snode_t node;
+	const char *name;
+	rate_task_handler_t handler;
+	int priority;
+	uint32_t deadline_cyc;
+	uint32_t max_cyc;
+	uint64_t sum_cyc;
+	uint64_t count;
+	uint64_t misses;
+};
+
+void rate_task_init(struct rate_task *task, const char *name, rate_task_handler_t handler,
+		    int priority, uint32_t deadline_us);
+
+int rate_group_add(enum rate_group_id id, struct rate_task *task);
+
+void rate_group_remove(enum rate_group_id id, struct rate_task *task);
+
+// vi: ts=4 sw=4 et
+
+#endif // CEREBRI_CORE_RATE_GROUP_H
@@ -0,0 +1,85 @@
+#ifndef CEREBRI_CORE_SENSOR_BUS_H
+#define CEREBRI_CORE_SENSOR_BUS_H
+
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/kernel.h>
+#include <zephyr/rtio/rtio.h>
+
+/*
+ * Slow sensor bus.
+ *
+ * A group reads one or more sensor iodevs, defined with SENSOR_DT_READ_IODEV,
+ * every period. The bus is a task of the 50 Hz rate group, so group periods
+ * are rounded up to a multiple of 20 ms. All reads are submitted to a single
+ * rtio context. Reads completing inline are handled in the same release,
+ * asynchronous reads in the next one. Once every read of a group completed
+ * the group handler runs in the rate group thread, the read buffers are only
+ * valid inside the handler. A failed read is skipped for an exponentially
+ * growing number of periods, its result is then -EAGAIN. The sensor_bus
+ * shell command reports the bus time and utilization of every device.
+ */
+
+#define SENSOR_BUS_MAX_READS  4
+#define SENSOR_BUS_MAX_GROUPS 8
+#define SENSOR_BUS_PERIOD_MS  20
+
+struct sensor_bus_group;
+
+typedef void (*sensor_bus_handler_t)(struct sensor_bus_group *group);
+
+struct sensor_bus_read {
+	struct sensor_bus_group *group;
+	struct rtio_iodev *iodev;
+	// result and data of the last round, valid in the handler
+	int result;
+	uint8_t *buf;
+	uint32_t buf_len;
+	bool pending;
+	uint8_t fail_streak;
+	uint16_t backoff;
+	uint32_t submit_cyc;
+	// written by the rtio callback chained to the read
+	uint32_t complete_cyc;
+	uint64_t reads;
+	uint64_t errors;
+	uint64_t busy_us;
+	uint32_t max_us;
+};
+
+struct sensor_bus_group {
+	sys_snode_t node;
+	const char *name;
+	sensor_bus_handler_t handler;
+	uint32_t divider;
+	uint32_t countdown;
+	int64_t start_ticks;
+	size_t count;
+	size_t pending;
+	struct sensor_bus_read read[SENSOR_BUS_MAX_READS];
+	uint64_t rounds;
+	uint64_t overruns;
+};
+
+void sensor_bus_group_init(struct sensor_bus_group *group, const char *name,
+			   sensor_bus_handler_t handler, uint32_t period_ms);
+
+// add a read to a group before the group is added to the bus
+int sensor_bus_group_add_read(struct sensor_bus_group *group, struct rtio_iodev *iodev);
+
+int sensor_bus_add(struct sensor_bus_group *group);
+
+void sensor_bus_remove(struct sensor_bus_group *group);
+
+static inline const struct device *sensor_bus_device(const struct rtio_iodev *iodev)
+{
+	const struct sensor_read_config *cfg = iodev->data;
+	return cfg->sensor;
+}
+
+// decode the first sample of a channel, value holds three elements for three axis channels
+int sensor_bus_decode(const struct sensor_bus_read *read, enum sensor_channel chan,
+		      float *value);
+
+// vi: ts=4 sw=4 et
+
+#endif // CEREBRI_CORE_SENSOR_BUS_H
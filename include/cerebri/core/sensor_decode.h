@@ -0,0 +1,20 @@
+#ifndef CEREBRI_CORE_SENSOR_DECODE_H
+#define CEREBRI_CORE_SENSOR_DECODE_H
+
+#include <zephyr/drivers/sensor.h>
+
+/*
+ * Decoding of encoded sensor reads without struct sensor_value.
+ *
+ * The driver decoder yields q31 samples with one shift per channel, the
+ * shift is turned into a single float scale that is applied to every axis,
+ * so no double arithmetic is needed on targets with a single precision fpu.
+ */
+
+// decode the first sample of a channel, value holds three elements for three axis channels
+int sensor_decode_float(const struct device *dev, const uint8_t *buf, enum sensor_channel chan,
+			float *value);
+
+// vi: ts=4 sw=4 et
+
+#endif // CEREBRI_CORE_SENSOR_DECODE_H
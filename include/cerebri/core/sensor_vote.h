@@ -0,0 +1,76 @@
+#ifndef CEREBRI_CORE_SENSOR_VOTE_H
+#define CEREBRI_CORE_SENSOR_VOTE_H
+
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/kernel.h>
+
+/*
+ * Arbitration between redundant instances of a sensor.
+ *
+ * Samples of each instance are recorded with sensor_vote_set, either from
+ * a sensor bus handler or by sensor_vote_fetch, which fetches every instance
+ * synchronously. sensor_vote_update votes on the latest samples. The
+ * instances sampled within max age take the per axis median, instances
+ * further than max deviation from it on any axis are outliers. The output is
+ * the health weighted mean of the agreeing instances, or the healthiest
+ * instance if none agree. Health rises with every agreeing sample and halves
+ * on an outlier or a failed read. sensor_vote_fetch skips a failed instance
+ * for an exponentially growing number of updates, so a dead sensor does not
+ * cost a blocking bus transaction every update. Every vote is listed by the
+ * sensor_vote shell command with its per instance counters. All arithmetic is
+ * single precision.
+ */
+
+#define SENSOR_VOTE_MAX_INSTANCES 4
+#define SENSOR_VOTE_MAX_AXES      3
+
+struct sensor_vote_instance {
+	const struct device *dev;
+	float value[SENSOR_VOTE_MAX_AXES];
+	int64_t last_ticks;
+	bool received;
+	uint8_t health;
+	uint8_t fail_streak;
+	uint16_t backoff;
+	uint32_t fetch_errors;
+	uint32_t outliers;
+	uint32_t selected;
+};
+
+struct sensor_vote {
+	sys_snode_t node;
+	const char *name;
+	enum sensor_channel chan;
+	size_t axes;
+	size_t count;
+	int64_t max_age_ticks;
+	float max_deviation;
+	struct sensor_vote_instance instance[SENSOR_VOTE_MAX_INSTANCES];
+	uint64_t votes;
+	uint64_t no_data;
+};
+
+// max deviation <= 0 disables outlier exclusion
+void sensor_vote_init(struct sensor_vote *vote, const char *name, enum sensor_channel chan,
+		      size_t axes, uint32_t max_age_ms, float max_deviation);
+
+void sensor_vote_fini(struct sensor_vote *vote);
+
+// add an instance, devices that are missing or not ready are skipped with -ENODEV
+int sensor_vote_add(struct sensor_vote *vote, const struct device *dev);
+
+// record a sample of instance i, value holds one element per axis
+void sensor_vote_set(struct sensor_vote *vote, size_t i, const float *value);
+
+// record a failed read of instance i
+void sensor_vote_error(struct sensor_vote *vote, size_t i, int rc);
+
+// synchronously fetch all instances
+void sensor_vote_fetch(struct sensor_vote *vote);
+
+// vote on the latest samples, -ENODATA if no instance is fresh
+int sensor_vote_update(struct sensor_vote *vote, float *value);
+
+// vi: ts=4 sw=4 et
+
+#endif // CEREBRI_CORE_SENSOR_VOTE_H
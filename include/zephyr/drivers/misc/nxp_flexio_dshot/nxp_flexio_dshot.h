@@ -35,6 +35,17 @@ extern "C" {
  * @{
  */
 
+/** Bidirectional dshot telemetry of one channel */
+struct nxp_flexio_dshot_telemetry {
+	/** Electrical rpm / 100 of the last valid response */
+	uint16_t erpm;
+	/** Time from the trigger to the decoded response */
+	uint32_t latency_us;
+	uint32_t crc_error_cnt;
+	uint32_t frame_error_cnt;
+	uint32_t no_response_cnt;
+};
+
 void nxp_flexio_dshot_data_set(const struct device *dev, unsigned channel, uint16_t throttle,
 			       bool telemetry);
 
@@ -42,6 +53,28 @@ void nxp_flexio_dshot_trigger(const struct device *dev);
 
 uint8_t nxp_flexio_dshot_channel_count(const struct device *dev);
 
+/**
+ * @brief Pack the frames of the first count channels and start all of them with one trigger
+ *
+ * Checksums and bit timings of every channel are computed before the
+ * transfer starts, so all motors are commanded in the same FlexIO cycle.
+ */
+void nxp_flexio_dshot_update(const struct device *dev, const uint16_t *throttle, uint8_t count,
+			     bool telemetry);
+
+/**
+ * @brief Get the telemetry of a channel
+ *
+ * Responses are decoded in the isr. Counters are always filled in.
+ *
+ * @retval 0 a valid response was received since the last trigger
+ * @retval -EAGAIN no valid response since the last trigger
+ * @retval -ENOTSUP channel is not bidirectional
+ * @retval -EINVAL invalid channel
+ */
+int nxp_flexio_dshot_telemetry_get(const struct device *dev, unsigned channel,
+				   struct nxp_flexio_dshot_telemetry *telemetry);
+
 /**
  * @}
  */
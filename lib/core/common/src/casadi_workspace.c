@@ -0,0 +1,35 @@
+/*
+ * Copyright CogniPilot Foundation 2024
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+
+#include <cerebri/core/casadi.h>
+
+static const char *file_basename(const char *path)
+{
+	const char *p = strrchr(path, '/');
+	return p == NULL ? path : p + 1;
+}
+
+static int shell_casadi_ws(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+	size_t total = 0;
+
+	STRUCT_SECTION_FOREACH(casadi_workspace_info, info) {
+		shell_print(sh, "%-28s %-24s %6zu B", info->name, file_basename(info->file), info->size);
+		total += info->size;
+	}
+	shell_print(sh, "total: %zu B", total);
+	return 0;
+}
+
+SHELL_CMD_REGISTER(casadi_ws, NULL, "Display casadi workspace memory", shell_casadi_ws);
+
+// vi: ts=4 sw=4 et
@@ -0,0 +1,109 @@
+/*
+ * Copyright CogniPilot Foundation 2024
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <inttypes.h>
+
+#include <cerebri/core/freshness.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+
+LOG_MODULE_DECLARE(core_common);
+
+static sys_slist_t g_freshness_list = {.head = NULL, .tail = NULL};
+static struct k_spinlock g_freshness_lock;
+
+void freshness_init(struct freshness *fresh, const char *name, uint32_t max_age_ms)
+{
+	fresh->name = name;
+	fresh->max_age_ticks = k_ms_to_ticks_ceil64(max_age_ms);
+	fresh->last_ticks = 0;
+	fresh->received = false;
+	fresh->stale = true;
+	fresh->stale_count = 0;
+	K_SPINLOCK(&g_freshness_lock) {
+		// init again keeps a single entry
+		sys_slist_find_and_remove(&g_freshness_list, &fresh->node);
+		sys_slist_append(&g_freshness_list, &fresh->node);
+	}
+}
+
+void freshness_fini(struct freshness *fresh)
+{
+	K_SPINLOCK(&g_freshness_lock) {
+		sys_slist_find_and_remove(&g_freshness_list, &fresh->node);
+	}
+}
+
+int64_t freshness_age(const struct freshness *fresh)
+{
+	if (!fresh->received) {
+		return -1;
+	}
+	return k_uptime_ticks() - fresh->last_ticks;
+}
+
+bool freshness_check(struct freshness *fresh)
+{
+	int64_t age = freshness_age(fresh);
+	bool stale = age < 0 || age > fresh->max_age_ticks;
+
+	if (stale && !fresh->stale && fresh->received) {
+		fresh->stale_count++;
+		LOG_WRN("%s stale, age %" PRIu64 " ms", fresh->name, k_ticks_to_ms_floor64(age));
+	} else if (!stale && fresh->stale) {
+		LOG_INF("%s fresh", fresh->name);
+	}
+	fresh->stale = stale;
+	return !stale;
+}
+
+// copy of the i-th listed freshness, so the shell prints without the lock
+static bool freshness_get(size_t i, struct freshness *copy)
+{
+	bool found = false;
+	K_SPINLOCK(&g_freshness_lock) {
+		struct freshness *fresh;
+		SYS_SLIST_FOR_EACH_CONTAINER(&g_freshness_list, fresh, node) {
+			if (i-- == 0) {
+				*copy = *fresh;
+				found = true;
+				break;
+			}
+		}
+	}
+	return found;
+}
+
+static int shell_freshness(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	struct freshness fresh;
+	for (size_t i = 0; freshness_get(i, &fresh); i++) {
+		int64_t age = freshness_age(&fresh);
+		bool stale = age < 0 || age > fresh.max_age_ticks;
+		if (age < 0) {
+			shell_print(sh,
+				    "%-32s age %8s ms max %6" PRIu64 " ms stale %" PRIu64
+				    " never received",
+				    fresh.name, "-", k_ticks_to_ms_floor64(fresh.max_age_ticks),
+				    fresh.stale_count);
+		} else {
+			shell_print(sh,
+				    "%-32s age %8" PRIu64 " ms max %6" PRIu64 " ms stale %" PRIu64
+				    "%s",
+				    fresh.name, k_ticks_to_ms_floor64(age),
+				    k_ticks_to_ms_floor64(fresh.max_age_ticks), fresh.stale_count,
+				    stale ? " STALE" : "");
+		}
+	}
+	return 0;
+}
+
+SHELL_CMD_REGISTER(freshness, NULL, "Display age of subscribed control inputs", shell_freshness);
+
+// vi: ts=4 sw=4 et
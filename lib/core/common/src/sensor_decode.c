@@ -0,0 +1,43 @@
+/*
+ * Copyright CogniPilot Foundation 2024
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+
+#include <cerebri/core/sensor_decode.h>
+
+int sensor_decode_float(const struct device *dev, const uint8_t *buf, enum sensor_channel chan,
+			float *value)
+{
+	const struct sensor_decoder_api *decoder;
+	struct sensor_chan_spec spec = {.chan_type = chan, .chan_idx = 0};
+	uint32_t fit = 0;
+
+	int rc = sensor_get_decoder(dev, &decoder);
+	if (rc < 0) {
+		return rc;
+	}
+
+	if (SENSOR_CHANNEL_3_AXIS(chan)) {
+		struct sensor_three_axis_data data;
+		rc = decoder->decode(buf, spec, &fit, 1, &data);
+		if (rc <= 0) {
+			return rc < 0 ? rc : -ENODATA;
+		}
+		float scale = ldexpf(1.0f, data.shift - 31);
+		for (int j = 0; j < 3; j++) {
+			value[j] = data.readings[0].values[j] * scale;
+		}
+	} else {
+		struct sensor_q31_data data;
+		rc = decoder->decode(buf, spec, &fit, 1, &data);
+		if (rc <= 0) {
+			return rc < 0 ? rc : -ENODATA;
+		}
+		value[0] = data.readings[0].value * ldexpf(1.0f, data.shift - 31);
+	}
+	return 0;
+}
+
+// vi: ts=4 sw=4 et
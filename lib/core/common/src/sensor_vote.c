@@ -0,0 +1,254 @@
+/*
+ * Copyright CogniPilot Foundation 2024
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <inttypes.h>
+#include <math.h>
+
+#include <cerebri/core/sensor_vote.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+
+LOG_MODULE_DECLARE(core_common);
+
+#define HEALTH_MAX      100
+#define FAIL_STREAK_MAX 8
+
+static sys_slist_t g_sensor_vote_list = {.head = NULL, .tail = NULL};
+static struct k_spinlock g_sensor_vote_lock;
+
+void sensor_vote_init(struct sensor_vote *vote, const char *name, enum sensor_channel chan,
+		      size_t axes, uint32_t max_age_ms, float max_deviation)
+{
+	__ASSERT(axes <= SENSOR_VOTE_MAX_AXES, "too many axes");
+	vote->name = name;
+	vote->chan = chan;
+	vote->axes = axes;
+	vote->count = 0;
+	vote->max_age_ticks = k_ms_to_ticks_ceil64(max_age_ms);
+	vote->max_deviation = max_deviation;
+	vote->votes = 0;
+	vote->no_data = 0;
+	K_SPINLOCK(&g_sensor_vote_lock) {
+		// init again keeps a single entry
+		sys_slist_find_and_remove(&g_sensor_vote_list, &vote->node);
+		sys_slist_append(&g_sensor_vote_list, &vote->node);
+	}
+}
+
+void sensor_vote_fini(struct sensor_vote *vote)
+{
+	K_SPINLOCK(&g_sensor_vote_lock) {
+		sys_slist_find_and_remove(&g_sensor_vote_list, &vote->node);
+	}
+}
+
+int sensor_vote_add(struct sensor_vote *vote, const struct device *dev)
+{
+	if (dev == NULL || !device_is_ready(dev)) {
+		LOG_ERR("%s: device %s not ready", vote->name, dev != NULL ? dev->name : "?");
+		return -ENODEV;
+	}
+	if (vote->count >= SENSOR_VOTE_MAX_INSTANCES) {
+		return -ENOMEM;
+	}
+	struct sensor_vote_instance *inst = &vote->instance[vote->count++];
+	*inst = (struct sensor_vote_instance){
+		.dev = dev,
+		.health = HEALTH_MAX / 2,
+	};
+	LOG_INF("%s: instance %d %s", vote->name, (int)vote->count - 1, dev->name);
+	return 0;
+}
+
+void sensor_vote_set(struct sensor_vote *vote, size_t i, const float *value)
+{
+	struct sensor_vote_instance *inst = &vote->instance[i];
+
+	if (inst->fail_streak > 0) {
+		LOG_INF("%s: %s recovered", vote->name, inst->dev->name);
+		inst->fail_streak = 0;
+	}
+	for (size_t j = 0; j < vote->axes; j++) {
+		inst->value[j] = value[j];
+	}
+	inst->last_ticks = k_uptime_ticks();
+	inst->received = true;
+}
+
+void sensor_vote_error(struct sensor_vote *vote, size_t i, int rc)
+{
+	struct sensor_vote_instance *inst = &vote->instance[i];
+
+	inst->fetch_errors++;
+	inst->health /= 2;
+	if (inst->fail_streak == 0) {
+		LOG_WRN("%s: %s read failed: %d", vote->name, inst->dev->name, rc);
+	}
+	if (inst->fail_streak < FAIL_STREAK_MAX) {
+		inst->fail_streak++;
+	}
+}
+
+void sensor_vote_fetch(struct sensor_vote *vote)
+{
+	for (size_t i = 0; i < vote->count; i++) {
+		struct sensor_vote_instance *inst = &vote->instance[i];
+		struct sensor_value val[SENSOR_VOTE_MAX_AXES] = {};
+		float value[SENSOR_VOTE_MAX_AXES];
+
+		if (inst->backoff > 0) {
+			inst->backoff--;
+			continue;
+		}
+
+		int rc = sensor_sample_fetch(inst->dev);
+		if (rc == 0) {
+			rc = sensor_channel_get(inst->dev, vote->chan, val);
+		}
+		if (rc < 0) {
+			sensor_vote_error(vote, i, rc);
+			inst->backoff = BIT(inst->fail_streak) - 1;
+			continue;
+		}
+
+		for (size_t j = 0; j < vote->axes; j++) {
+			value[j] = sensor_value_to_float(&val[j]);
+		}
+		sensor_vote_set(vote, i, value);
+	}
+}
+
+static float median(float *v, size_t n)
+{
+	// insertion sort, n is at most SENSOR_VOTE_MAX_INSTANCES
+	for (size_t i = 1; i < n; i++) {
+		float x = v[i];
+		size_t j = i;
+		for (; j > 0 && v[j - 1] > x; j--) {
+			v[j] = v[j - 1];
+		}
+		v[j] = x;
+	}
+	return n % 2 ? v[n / 2] : 0.5f * (v[n / 2 - 1] + v[n / 2]);
+}
+
+int sensor_vote_update(struct sensor_vote *vote, float *value)
+{
+	struct sensor_vote_instance *fresh[SENSOR_VOTE_MAX_INSTANCES];
+	size_t n = 0;
+	int64_t now = k_uptime_ticks();
+
+	for (size_t i = 0; i < vote->count; i++) {
+		struct sensor_vote_instance *inst = &vote->instance[i];
+		if (inst->received && now - inst->last_ticks <= vote->max_age_ticks) {
+			fresh[n++] = inst;
+		}
+	}
+
+	if (n == 0) {
+		vote->no_data++;
+		return -ENODATA;
+	}
+
+	float mid[SENSOR_VOTE_MAX_AXES];
+	for (size_t j = 0; j < vote->axes; j++) {
+		float v[SENSOR_VOTE_MAX_INSTANCES];
+		for (size_t i = 0; i < n; i++) {
+			v[i] = fresh[i]->value[j];
+		}
+		mid[j] = median(v, n);
+	}
+
+	// health weighted mean of the instances agreeing with the median
+	float sum[SENSOR_VOTE_MAX_AXES] = {};
+	float weight = 0;
+	for (size_t i = 0; i < n; i++) {
+		struct sensor_vote_instance *inst = fresh[i];
+		bool agree = true;
+		for (size_t j = 0; j < vote->axes && vote->max_deviation > 0; j++) {
+			if (fabsf(inst->value[j] - mid[j]) > vote->max_deviation) {
+				agree = false;
+			}
+		}
+		if (!agree) {
+			inst->outliers++;
+			inst->health /= 2;
+			continue;
+		}
+		if (inst->health < HEALTH_MAX) {
+			inst->health++;
+		}
+		inst->selected++;
+		for (size_t j = 0; j < vote->axes; j++) {
+			sum[j] += (inst->health + 1) * inst->value[j];
+		}
+		weight += inst->health + 1;
+	}
+
+	if (weight > 0) {
+		for (size_t j = 0; j < vote->axes; j++) {
+			value[j] = sum[j] / weight;
+		}
+	} else {
+		// no instances agree, trust the one with the best history
+		struct sensor_vote_instance *best = fresh[0];
+		for (size_t i = 1; i < n; i++) {
+			if (fresh[i]->health > best->health) {
+				best = fresh[i];
+			}
+		}
+		for (size_t j = 0; j < vote->axes; j++) {
+			value[j] = best->value[j];
+		}
+		best->selected++;
+	}
+	vote->votes++;
+	return 0;
+}
+
+// copy of the i-th listed vote, so the shell prints without the lock
+static bool sensor_vote_get(size_t i, struct sensor_vote *copy)
+{
+	bool found = false;
+	K_SPINLOCK(&g_sensor_vote_lock) {
+		struct sensor_vote *vote;
+		SYS_SLIST_FOR_EACH_CONTAINER(&g_sensor_vote_list, vote, node) {
+			if (i-- == 0) {
+				*copy = *vote;
+				found = true;
+				break;
+			}
+		}
+	}
+	return found;
+}
+
+static int shell_sensor_vote(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	int64_t now = k_uptime_ticks();
+	struct sensor_vote vote;
+	for (size_t v = 0; sensor_vote_get(v, &vote); v++) {
+		shell_print(sh, "%s votes %" PRIu64 " no data %" PRIu64, vote.name, vote.votes,
+			    vote.no_data);
+		for (size_t i = 0; i < vote.count; i++) {
+			struct sensor_vote_instance *inst = &vote.instance[i];
+			bool stale =
+				!inst->received || now - inst->last_ticks > vote.max_age_ticks;
+			shell_print(sh,
+				    "  %-20s health %3u errors %6u outliers %6u selected %8u%s",
+				    inst->dev->name, inst->health, inst->fetch_errors,
+				    inst->outliers, inst->selected, stale ? " STALE" : "");
+		}
+	}
+	return 0;
+}
+
+SHELL_CMD_REGISTER(sensor_vote, NULL, "Display redundant sensor arbitration", shell_sensor_vote);
+
+// vi: ts=4 sw=4 et
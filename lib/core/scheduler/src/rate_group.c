@@ -0,0 +1,246 @@
+/*
+ * Copyright CogniPilot Foundation 2024
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <inttypes.h>
+
+#include <cerebri/core/rate_group.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/atomic.h>
+
+LOG_MODULE_REGISTER(core_scheduler, CONFIG_CEREBRI_CORE_SCHEDULER_LOG_LEVEL);
+
+#define BASE_RATE_HZ 1000
+
+BUILD_ASSERT(CONFIG_SYS_CLOCK_TICKS_PER_SEC % BASE_RATE_HZ == 0,
+	     "rate groups require a system tick rate that is a multiple of 1 kHz");
+
+struct rate_group {
+	const char *name;
+	uint32_t divider;
+	sys_slist_t tasks;
+	struct k_mutex lock;
+	struct k_sem release;
+	atomic_t busy;
+	uint32_t release_cyc;
+	uint64_t releases;
+	uint64_t overruns;
+	uint32_t max_cyc;
+	uint64_t sum_cyc;
+	uint64_t count;
+	struct k_thread thread;
+};
+
+#define RATE_GROUP_INITIALIZER(_id, _name, _divider)                                               \
+	[_id] = {                                                                                  \
+		.name = _name,                                                                     \
+		.divider = _divider,                                                               \
+		.tasks = {.head = NULL, .tail = NULL},                                             \
+		.lock = Z_MUTEX_INITIALIZER(g_groups[_id].lock),                                   \
+		.release = Z_SEM_INITIALIZER(g_groups[_id].release, 0, 1),                         \
+		.busy = ATOMIC_INIT(0),                                                            \
+	}
+
+static struct rate_group g_groups[RATE_GROUP_COUNT] = {
+	RATE_GROUP_INITIALIZER(RATE_GROUP_1000_HZ, "rate_1000hz", 1),
+	RATE_GROUP_INITIALIZER(RATE_GROUP_250_HZ, "rate_250hz", 4),
+	RATE_GROUP_INITIALIZER(RATE_GROUP_50_HZ, "rate_50hz", 20),
+	RATE_GROUP_INITIALIZER(RATE_GROUP_10_HZ, "rate_10hz", 100),
+};
+
+static K_THREAD_STACK_ARRAY_DEFINE(g_stacks, RATE_GROUP_COUNT,
+				   CONFIG_CEREBRI_CORE_SCHEDULER_STACK_SIZE);
+
+static uint32_t g_ticks;
+
+void rate_task_init(struct rate_task *task, const char *name, rate_task_handler_t handler,
+		    int priority, uint32_t deadline_us)
+{
+	task->name = name;
+	task->handler = handler;
+	task->priority = priority;
+	task->deadline_cyc = k_us_to_cyc_ceil32(deadline_us);
+	task->max_cyc = 0;
+	task->sum_cyc = 0;
+	task->count = 0;
+	task->misses = 0;
+}
+
+int rate_group_add(enum rate_group_id id, struct rate_task *task)
+{
+	if (id >= RATE_GROUP_COUNT) {
+		return -EINVAL;
+	}
+	struct rate_group *group = &g_groups[id];
+
+	// keep tasks sorted by priority, equal priorities in order of addition
+	k_mutex_lock(&group->lock, K_FOREVER);
+	sys_snode_t *prev = NULL;
+	struct rate_task *it;
+	SYS_SLIST_FOR_EACH_CONTAINER(&group->tasks, it, node) {
+		if (it->priority > task->priority) {
+			break;
+		}
+		prev = &it->node;
+	}
+	sys_slist_insert(&group->tasks, prev, &task->node);
+	k_mutex_unlock(&group->lock);
+	LOG_DBG("%s added to %s", task->name, group->name);
+	return 0;
+}
+
+void rate_group_remove(enum rate_group_id id, struct rate_task *task)
+{
+	if (id >= RATE_GROUP_COUNT) {
+		return;
+	}
+	struct rate_group *group = &g_groups[id];
+	k_mutex_lock(&group->lock, K_FOREVER);
+	sys_slist_find_and_remove(&group->tasks, &task->node);
+	k_mutex_unlock(&group->lock);
+}
+
+static void rate_group_timer_handler(struct k_timer *timer)
+{
+	ARG_UNUSED(timer);
+	g_ticks++;
+	uint32_t now_cyc = k_cycle_get_32();
+	for (int i = 0; i < RATE_GROUP_COUNT; i++) {
+		struct rate_group *group = &g_groups[i];
+		if (g_ticks % group->divider != 0) {
+			continue;
+		}
+		group->releases++;
+		if (!atomic_cas(&group->busy, 0, 1)) {
+			// previous release has not finished, skip this one
+			group->overruns++;
+			continue;
+		}
+		group->release_cyc = now_cyc;
+		k_sem_give(&group->release);
+	}
+}
+
+K_TIMER_DEFINE(g_rate_group_timer, rate_group_timer_handler, NULL);
+
+static void rate_group_run(void *p0, void *p1, void *p2)
+{
+	struct rate_group *group = p0;
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+
+	while (true) {
+		k_sem_take(&group->release, K_FOREVER);
+		uint32_t release_cyc = group->release_cyc;
+
+		uint32_t exec_cyc = 0;
+
+		k_mutex_lock(&group->lock, K_FOREVER);
+		struct rate_task *task;
+		SYS_SLIST_FOR_EACH_CONTAINER(&group->tasks, task, node) {
+			uint32_t start_cyc = k_cycle_get_32();
+			task->handler(task);
+			uint32_t end_cyc = k_cycle_get_32();
+			uint32_t delta_cyc = end_cyc - start_cyc;
+			exec_cyc += delta_cyc;
+			task->count++;
+			task->sum_cyc += delta_cyc;
+			if (delta_cyc > task->max_cyc) {
+				task->max_cyc = delta_cyc;
+			}
+			if (end_cyc - release_cyc > task->deadline_cyc) {
+				task->misses++;
+			}
+		}
+		k_mutex_unlock(&group->lock);
+
+		group->count++;
+		group->sum_cyc += exec_cyc;
+		if (exec_cyc > group->max_cyc) {
+			group->max_cyc = exec_cyc;
+		}
+		atomic_clear(&group->busy);
+	}
+}
+
+static int rate_group_sys_init(void)
+{
+	for (int i = 0; i < RATE_GROUP_COUNT; i++) {
+		struct rate_group *group = &g_groups[i];
+		// rate monotonic, faster groups get higher priority
+		int priority = CONFIG_CEREBRI_CORE_SCHEDULER_PRIORITY + i;
+		k_tid_t tid = k_thread_create(&group->thread, g_stacks[i],
+					      K_THREAD_STACK_SIZEOF(g_stacks[i]), rate_group_run,
+					      group, NULL, NULL, priority, 0, K_FOREVER);
+		k_thread_name_set(tid, group->name);
+		k_thread_start(tid);
+	}
+	k_timer_start(&g_rate_group_timer, K_USEC(USEC_PER_SEC / BASE_RATE_HZ),
+		      K_USEC(USEC_PER_SEC / BASE_RATE_HZ));
+	LOG_INF("init");
+	return 0;
+}
+
+SYS_INIT(rate_group_sys_init, APPLICATION, 0);
+
+static uint32_t cyc_to_us(uint64_t cyc)
+{
+	return k_cyc_to_us_floor64(cyc);
+}
+
+static int shell_rate_group(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	// Liu and Layland utilization bound n(2^(1/n) - 1) for n groups
+	static const uint32_t bound_permille[] = {1000, 1000, 828, 779, 756};
+	uint32_t total_permille = 0;
+	int active = 0;
+
+	for (int i = 0; i < RATE_GROUP_COUNT; i++) {
+		struct rate_group *group = &g_groups[i];
+		uint32_t period_us = group->divider * (USEC_PER_SEC / BASE_RATE_HZ);
+		uint32_t max_us = cyc_to_us(group->max_cyc);
+		uint32_t avg_us = group->count ? cyc_to_us(group->sum_cyc / group->count) : 0;
+		uint32_t util_permille = 1000 * max_us / period_us;
+
+		if (!sys_slist_is_empty(&group->tasks)) {
+			active++;
+			total_permille += util_permille;
+		}
+
+		shell_print(sh,
+			    "%-12s prio %3d period %6u us avg %6u us max %6u us util %3u.%u%% "
+			    "releases %" PRIu64 " overruns %" PRIu64,
+			    group->name, CONFIG_CEREBRI_CORE_SCHEDULER_PRIORITY + i, period_us,
+			    avg_us, max_us, util_permille / 10, util_permille % 10,
+			    group->releases, group->overruns);
+
+		k_mutex_lock(&group->lock, K_FOREVER);
+		struct rate_task *task;
+		SYS_SLIST_FOR_EACH_CONTAINER(&group->tasks, task, node) {
+			shell_print(sh,
+				    "  %-22s prio %3d deadline %6u us avg %6u us max %6u us "
+				    "misses %" PRIu64,
+				    task->name, task->priority, cyc_to_us(task->deadline_cyc),
+				    task->count ? cyc_to_us(task->sum_cyc / task->count) : 0,
+				    cyc_to_us(task->max_cyc), task->misses);
+		}
+		k_mutex_unlock(&group->lock);
+	}
+
+	shell_print(sh, "worst case utilization %u.%u%%, rate monotonic bound %u.%u%%: %s",
+		    total_permille / 10, total_permille % 10, bound_permille[active] / 10,
+		    bound_permille[active] % 10,
+		    total_permille <= bound_permille[active] ? "schedulable" : "not guaranteed");
+	return 0;
+}
+
+SHELL_CMD_REGISTER(rate_group, NULL, "Display rate group schedule", shell_rate_group);
+
+// vi: ts=4 sw=4 et
@@ -0,0 +1,287 @@
+/*
+ * Copyright CogniPilot Foundation 2024
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <inttypes.h>
+
+#include <cerebri/core/rate_group.h>
+#include <cerebri/core/sensor_bus.h>
+#include <cerebri/core/sensor_decode.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+
+LOG_MODULE_REGISTER(core_sensor_bus, CONFIG_CEREBRI_CORE_SENSOR_BUS_LOG_LEVEL);
+
+#define FAIL_STREAK_MAX 8
+
+// every read is chained to a callback timestamping its completion
+RTIO_DEFINE_WITH_MEMPOOL(g_sensor_bus_rtio, 2 * CONFIG_CEREBRI_CORE_SENSOR_BUS_QUEUE_SIZE,
+			 2 * CONFIG_CEREBRI_CORE_SENSOR_BUS_QUEUE_SIZE,
+			 2 * CONFIG_CEREBRI_CORE_SENSOR_BUS_QUEUE_SIZE,
+			 CONFIG_CEREBRI_CORE_SENSOR_BUS_BLOCK_SIZE, sizeof(void *));
+
+static struct rate_task g_sensor_bus_task;
+static sys_slist_t g_sensor_bus_groups = {.head = NULL, .tail = NULL};
+static size_t g_sensor_bus_group_count;
+static K_MUTEX_DEFINE(g_sensor_bus_lock);
+
+void sensor_bus_group_init(struct sensor_bus_group *group, const char *name,
+			   sensor_bus_handler_t handler, uint32_t period_ms)
+{
+	group->name = name;
+	group->handler = handler;
+	group->divider = MAX(DIV_ROUND_UP(period_ms, SENSOR_BUS_PERIOD_MS), 1);
+	group->count = 0;
+	group->pending = 0;
+	group->rounds = 0;
+	group->overruns = 0;
+}
+
+int sensor_bus_group_add_read(struct sensor_bus_group *group, struct rtio_iodev *iodev)
+{
+	if (group->count >= SENSOR_BUS_MAX_READS) {
+		return -ENOMEM;
+	}
+	group->read[group->count++] = (struct sensor_bus_read){
+		.group = group,
+		.iodev = iodev,
+	};
+	return 0;
+}
+
+int sensor_bus_add(struct sensor_bus_group *group)
+{
+	k_mutex_lock(&g_sensor_bus_lock, K_FOREVER);
+	if (g_sensor_bus_group_count >= SENSOR_BUS_MAX_GROUPS) {
+		k_mutex_unlock(&g_sensor_bus_lock);
+		return -ENOMEM;
+	}
+	group->start_ticks = k_uptime_ticks();
+	// read on the next release
+	group->countdown = 1;
+	sys_slist_append(&g_sensor_bus_groups, &group->node);
+	g_sensor_bus_group_count++;
+	k_mutex_unlock(&g_sensor_bus_lock);
+	LOG_DBG("%s added", group->name);
+	return 0;
+}
+
+void sensor_bus_remove(struct sensor_bus_group *group)
+{
+	k_mutex_lock(&g_sensor_bus_lock, K_FOREVER);
+	if (sys_slist_find_and_remove(&g_sensor_bus_groups, &group->node)) {
+		g_sensor_bus_group_count--;
+	}
+	k_mutex_unlock(&g_sensor_bus_lock);
+}
+
+int sensor_bus_decode(const struct sensor_bus_read *read, enum sensor_channel chan,
+		      float *value)
+{
+	if (read->result < 0) {
+		return read->result;
+	}
+	return sensor_decode_float(sensor_bus_device(read->iodev), read->buf, chan, value);
+}
+
+static void group_complete(struct sensor_bus_group *group)
+{
+	group->rounds++;
+	group->handler(group);
+	for (size_t i = 0; i < group->count; i++) {
+		struct sensor_bus_read *read = &group->read[i];
+		if (read->buf != NULL) {
+			rtio_release_buffer(&g_sensor_bus_rtio, read->buf, read->buf_len);
+			read->buf = NULL;
+			read->buf_len = 0;
+		}
+	}
+}
+
+static void read_complete(struct sensor_bus_read *read, int result)
+{
+	// a failed read cancels its chained callback, it completed no later than now
+	uint32_t complete_cyc = result < 0 ? k_cycle_get_32() : read->complete_cyc;
+	uint32_t busy_us = k_cyc_to_us_floor32(complete_cyc - read->submit_cyc);
+
+	read->pending = false;
+	read->result = result;
+	read->reads++;
+	read->busy_us += busy_us;
+	read->max_us = MAX(read->max_us, busy_us);
+
+	if (result < 0) {
+		read->errors++;
+		if (read->fail_streak == 0) {
+			LOG_WRN("%s: %s read failed: %d", read->group->name,
+				sensor_bus_device(read->iodev)->name, result);
+		}
+		if (read->fail_streak < FAIL_STREAK_MAX) {
+			read->fail_streak++;
+		}
+		read->backoff = BIT(read->fail_streak) - 1;
+	} else if (read->fail_streak > 0) {
+		LOG_INF("%s: %s recovered", read->group->name,
+			sensor_bus_device(read->iodev)->name);
+		read->fail_streak = 0;
+	}
+
+	if (--read->group->pending == 0) {
+		group_complete(read->group);
+	}
+}
+
+static void read_done_callback(struct rtio *r, const struct rtio_sqe *sqe, void *arg0)
+{
+	ARG_UNUSED(r);
+	ARG_UNUSED(sqe);
+	struct sensor_bus_read *read = arg0;
+	read->complete_cyc = k_cycle_get_32();
+}
+
+static int read_submit(struct sensor_bus_read *read)
+{
+	struct rtio_sqe *sqe = rtio_sqe_acquire(&g_sensor_bus_rtio);
+	struct rtio_sqe *done_sqe = rtio_sqe_acquire(&g_sensor_bus_rtio);
+	if (sqe == NULL || done_sqe == NULL) {
+		rtio_sqe_drop_all(&g_sensor_bus_rtio);
+		return -ENOMEM;
+	}
+	rtio_sqe_prep_read_with_pool(sqe, read->iodev, RTIO_PRIO_NORM, read);
+	sqe->flags |= RTIO_SQE_CHAINED;
+	// no userdata, its completion is skipped
+	rtio_sqe_prep_callback(done_sqe, read_done_callback, read, NULL);
+	return rtio_submit(&g_sensor_bus_rtio, 0);
+}
+
+static void group_submit(struct sensor_bus_group *group)
+{
+	// hold the count up while submitting, reads without async support complete inline
+	group->pending = 1;
+	for (size_t i = 0; i < group->count; i++) {
+		struct sensor_bus_read *read = &group->read[i];
+		read->buf = NULL;
+		read->buf_len = 0;
+		if (read->backoff > 0) {
+			read->backoff--;
+			read->result = -EAGAIN;
+			continue;
+		}
+		read->pending = true;
+		read->submit_cyc = k_cycle_get_32();
+		group->pending++;
+		int rc = read_submit(read);
+		if (rc < 0) {
+			read_complete(read, rc);
+		}
+	}
+	if (--group->pending == 0) {
+		group_complete(group);
+	}
+}
+
+static void consume_completions(void)
+{
+	struct rtio_cqe *cqe;
+	while ((cqe = rtio_cqe_consume(&g_sensor_bus_rtio)) != NULL) {
+		struct sensor_bus_read *read = cqe->userdata;
+		int result = cqe->result;
+		if (read == NULL) {
+			rtio_cqe_release(&g_sensor_bus_rtio, cqe);
+			continue;
+		}
+		if (result >= 0) {
+			result = rtio_cqe_get_mempool_buffer(&g_sensor_bus_rtio, cqe, &read->buf,
+							     &read->buf_len);
+		}
+		rtio_cqe_release(&g_sensor_bus_rtio, cqe);
+		read_complete(read, result);
+	}
+}
+
+static void sensor_bus_task_handler(struct rate_task *task)
+{
+	ARG_UNUSED(task);
+	struct sensor_bus_group *due[SENSOR_BUS_MAX_GROUPS];
+	size_t n = 0;
+
+	// asynchronous reads submitted in earlier releases
+	consume_completions();
+
+	// the lock only covers the list, reads may block on the synchronous fallback
+	k_mutex_lock(&g_sensor_bus_lock, K_FOREVER);
+	struct sensor_bus_group *group;
+	SYS_SLIST_FOR_EACH_CONTAINER(&g_sensor_bus_groups, group, node) {
+		if (--group->countdown > 0) {
+			continue;
+		}
+		group->countdown = group->divider;
+		if (group->pending > 0) {
+			// previous round still on the bus, skip this one
+			group->overruns++;
+			continue;
+		}
+		due[n++] = group;
+	}
+	k_mutex_unlock(&g_sensor_bus_lock);
+
+	for (size_t i = 0; i < n; i++) {
+		group_submit(due[i]);
+	}
+
+	// reads without async support completed inline
+	consume_completions();
+}
+
+static int sensor_bus_sys_init(void)
+{
+	rate_task_init(&g_sensor_bus_task, "sensor_bus", sensor_bus_task_handler, 0,
+		       SENSOR_BUS_PERIOD_MS * USEC_PER_MSEC);
+	rate_group_add(RATE_GROUP_50_HZ, &g_sensor_bus_task);
+	LOG_INF("init");
+	return 0;
+}
+
+SYS_INIT(sensor_bus_sys_init, APPLICATION, 0);
+
+static int shell_sensor_bus(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	int64_t now = k_uptime_ticks();
+	uint32_t total_permille = 0;
+
+	k_mutex_lock(&g_sensor_bus_lock, K_FOREVER);
+	struct sensor_bus_group *group;
+	SYS_SLIST_FOR_EACH_CONTAINER(&g_sensor_bus_groups, group, node) {
+		uint64_t elapsed_us = k_ticks_to_us_floor64(now - group->start_ticks);
+		shell_print(sh, "%-16s period %6u ms rounds %" PRIu64 " overruns %" PRIu64,
+			    group->name, group->divider * SENSOR_BUS_PERIOD_MS, group->rounds,
+			    group->overruns);
+		for (size_t i = 0; i < group->count; i++) {
+			const struct sensor_bus_read *read = &group->read[i];
+			uint32_t util_permille =
+				elapsed_us > 0 ? 1000 * read->busy_us / elapsed_us : 0;
+			total_permille += util_permille;
+			shell_print(sh,
+				    "  %-20s avg %6" PRIu64 " us max %6u us util %3u.%u%% "
+				    "reads %" PRIu64 " errors %" PRIu64,
+				    sensor_bus_device(read->iodev)->name,
+				    read->reads ? read->busy_us / read->reads : 0, read->max_us,
+				    util_permille / 10, util_permille % 10, read->reads,
+				    read->errors);
+		}
+	}
+	k_mutex_unlock(&g_sensor_bus_lock);
+
+	shell_print(sh, "total bus utilization %u.%u%%", total_permille / 10, total_permille % 10);
+	return 0;
+}
+
+SHELL_CMD_REGISTER(sensor_bus, NULL, "Display sensor bus utilization", shell_sensor_bus);
+
+// vi: ts=4 sw=4 et
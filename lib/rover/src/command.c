@@ -22,7 +22,7 @@
 #define MY_STACK_SIZE 8192
 #define MY_PRIORITY   4
 
-LOG_MODULE_REGISTER(melm_command, CONFIG_CEREBRI_MELM_LOG_LEVEL);
+LOG_MODULE_REGISTER(rover_command, CONFIG_CEREBRI_ROVER_LOG_LEVEL);
 
 static K_THREAD_STACK_DEFINE(g_my_stack_area, MY_STACK_SIZE);
 
@@ -35,6 +35,9 @@ struct context {
 	struct zros_sub sub_status, sub_cmd_vel, sub_input;
 	struct zros_pub pub_actuators;
 	const double wheel_radius;
+#if defined(CONFIG_CEREBRI_ROVER_ACKERMANN)
+	const double max_turn_angle;
+#endif
 	const double max_velocity;
 	struct k_sem running;
 	size_t stack_size;
@@ -51,17 +54,20 @@ static struct context g_ctx = {
 	.sub_status = {},
 	.sub_cmd_vel = {},
 	.pub_actuators = {},
-	.wheel_radius = CONFIG_CEREBRI_MELM_WHEEL_RADIUS_MM / 1000.0,
-	.max_velocity = CONFIG_CEREBRI_MELM_MAX_VELOCITY_MM_S / 1000.0,
+	.wheel_radius = CONFIG_CEREBRI_ROVER_WHEEL_RADIUS_MM / 1000.0,
+#if defined(CONFIG_CEREBRI_ROVER_ACKERMANN)
+	.max_turn_angle = CONFIG_CEREBRI_ROVER_MAX_TURN_ANGLE_MRAD / 1000.0,
+#endif
+	.max_velocity = CONFIG_CEREBRI_ROVER_MAX_VELOCITY_MM_S / 1000.0,
 	.running = Z_SEM_INITIALIZER(g_ctx.running, 1, 1),
 	.stack_size = MY_STACK_SIZE,
 	.stack_area = g_my_stack_area,
 	.thread_data = {},
 };
 
-static void melm_command_init(struct context *ctx)
+static void rover_command_init(struct context *ctx)
 {
-	zros_node_init(&ctx->node, "melm_command");
+	zros_node_init(&ctx->node, "rover_command");
 	zros_sub_init(&ctx->sub_status, &ctx->node, &topic_status, &ctx->status, 10);
 	zros_sub_init(&ctx->sub_input, &ctx->node, &topic_input, &ctx->input, 10);
 	zros_sub_init(&ctx->sub_cmd_vel, &ctx->node, &topic_cmd_vel, &ctx->cmd_vel, 10);
@@ -70,7 +76,7 @@ static void melm_command_init(struct context *ctx)
 	LOG_INF("init");
 }
 
-static void melm_command_fini(struct context *ctx)
+static void rover_command_fini(struct context *ctx)
 {
 	zros_sub_fini(&ctx->sub_status);
 	zros_sub_fini(&ctx->sub_input);
@@ -81,7 +87,7 @@ static void melm_command_fini(struct context *ctx)
 	LOG_INF("fini");
 }
 
-static void melm_stop(struct context *ctx)
+static void rover_stop(struct context *ctx)
 {
 	for (int i = 0; i < ctx->input.channel_count; i++) {
 		ctx->input.channel[i] = 0;
@@ -96,13 +102,13 @@ static void melm_stop(struct context *ctx)
 	ctx->cmd_vel.linear.z = 0;
 }
 
-static void melm_command_run(void *p0, void *p1, void *p2)
+static void rover_command_run(void *p0, void *p1, void *p2)
 {
 	struct context *ctx = p0;
 	ARG_UNUSED(p1);
 	ARG_UNUSED(p2);
 
-	melm_command_init(ctx);
+	rover_command_init(ctx);
 
 	double dt = 0;
 	int64_t ticks_last = k_uptime_ticks();
@@ -119,7 +125,7 @@ static void melm_command_run(void *p0, void *p1, void *p2)
 		rc = k_poll(events, ARRAY_SIZE(events), K_MSEC(1000));
 
 		if (rc != 0) {
-			melm_stop(ctx);
+			rover_stop(ctx);
 		}
 
 		bool update_status = zros_sub_update_available(&ctx->sub_status);
@@ -152,6 +158,15 @@ static void melm_command_run(void *p0, void *p1, void *p2)
 			double omega_fwd = ctx->max_velocity *
 					   (double)ctx->input.channel[CH_LEFT_STICK_UP] /
 					   ctx->wheel_radius;
+
+			bool armed = ctx->status.arming == synapse_pb_Status_Arming_ARMING_ARMED;
+
+#if defined(CONFIG_CEREBRI_ROVER_ACKERMANN)
+			double turn_angle = -ctx->max_turn_angle *
+					    (double)ctx->input.channel[CH_RIGHT_STICK_RIGHT];
+
+			rover_set_actuators(&ctx->actuators, turn_angle, omega_fwd, armed);
+#elif defined(CONFIG_CEREBRI_ROVER_DIFFERENTIAL)
 			double omega_diff = -ctx->max_velocity *
 					    (double)ctx->input.channel[CH_RIGHT_STICK_RIGHT] /
 					    ctx->wheel_radius;
@@ -159,26 +174,25 @@ static void melm_command_run(void *p0, void *p1, void *p2)
 			double omega_left = omega_fwd - omega_diff;
 			double omega_right = omega_fwd + omega_diff;
 
-			bool armed = ctx->status.arming == synapse_pb_Status_Arming_ARMING_ARMED;
-
-			melm_set_actuators(&ctx->actuators, omega_left, omega_right, armed);
-			zros_pub_update(&ctx->pub_actuators);
+			rover_set_actuators(&ctx->actuators, omega_left, omega_right, armed);
+#endif
+			synapse_pub_update(&ctx->pub_actuators, SYNAPSE_TOPIC_actuators);
 		}
 	}
 
-	melm_command_fini(ctx);
+	rover_command_fini(ctx);
 }
 
 static int start(struct context *ctx)
 {
 	k_tid_t tid = k_thread_create(&ctx->thread_data, ctx->stack_area, ctx->stack_size,
-				      melm_command_run, ctx, NULL, NULL, MY_PRIORITY, 0, K_FOREVER);
-	k_thread_name_set(tid, "melm_command");
+				      rover_command_run, ctx, NULL, NULL, MY_PRIORITY, 0, K_FOREVER);
+	k_thread_name_set(tid, "rover_command");
 	k_thread_start(tid);
 	return 0;
 }
 
-static int melm_command_cmd_handler(const struct shell *sh, size_t argc, char **argv, void *data)
+static int rover_command_cmd_handler(const struct shell *sh, size_t argc, char **argv, void *data)
 {
 	ARG_UNUSED(argc);
 	struct context *ctx = data;
@@ -201,16 +215,16 @@ static int melm_command_cmd_handler(const struct shell *sh, size_t argc, char **
 	return 0;
 }
 
-SHELL_SUBCMD_DICT_SET_CREATE(sub_melm_command, melm_command_cmd_handler, (start, &g_ctx, "start"),
+SHELL_SUBCMD_DICT_SET_CREATE(sub_rover_command, rover_command_cmd_handler, (start, &g_ctx, "start"),
 			     (stop, &g_ctx, "stop"), (status, &g_ctx, "status"));
 
-SHELL_CMD_REGISTER(melm_command, &sub_melm_command, "melm command arguments", NULL);
+SHELL_CMD_REGISTER(rover_command, &sub_rover_command, "rover command arguments", NULL);
 
-static int melm_command_sys_init(void)
+static int rover_command_sys_init(void)
 {
 	return start(&g_ctx);
 };
 
-SYS_INIT(melm_command_sys_init, APPLICATION, 1);
+SYS_INIT(rover_command_sys_init, APPLICATION, 1);
 
 // vi: ts=4 sw=4 et
@@ -22,7 +22,7 @@
 
 #include <cerebri/core/casadi.h>
 
-#include "app/b3rb/casadi/b3rb.h"
+#include "rover/casadi/rover_estimate.h"
 
 #define MY_STACK_SIZE 4096
 #define MY_PRIORITY   4
@@ -31,10 +31,12 @@
 #define M_PI 3.14159265358979323846
 #endif
 
-LOG_MODULE_REGISTER(b3rb_estimate, CONFIG_CEREBRI_B3RB_LOG_LEVEL);
+LOG_MODULE_REGISTER(rover_estimate, CONFIG_CEREBRI_ROVER_LOG_LEVEL);
 
 static K_THREAD_STACK_DEFINE(g_my_stack_area, MY_STACK_SIZE);
 
+CASADI_FUNC_DEFINE(predict);
+
 // private context
 struct context {
 	struct zros_node node;
@@ -69,16 +71,16 @@ static struct context g_ctx = {
 	.sub_imu = {},
 	.pub_odometry = {},
 	.x = {},
-	.wheel_radius = CONFIG_CEREBRI_B3RB_WHEEL_RADIUS_MM / 1000.0,
+	.wheel_radius = CONFIG_CEREBRI_ROVER_WHEEL_RADIUS_MM / 1000.0,
 	.running = Z_SEM_INITIALIZER(g_ctx.running, 1, 1),
 	.stack_size = MY_STACK_SIZE,
 	.stack_area = g_my_stack_area,
 	.thread_data = {},
 };
 
-static void b3rb_estimate_init(struct context *ctx)
+static void rover_estimate_init(struct context *ctx)
 {
-	zros_node_init(&ctx->node, "b3rb_estimate");
+	zros_node_init(&ctx->node, "rover_estimate");
 	zros_sub_init(&ctx->sub_imu, &ctx->node, &topic_imu, &ctx->imu, 10);
 	zros_sub_init(&ctx->sub_wheel_odometry, &ctx->node, &topic_wheel_odometry,
 		      &ctx->wheel_odometry, 10);
@@ -87,7 +89,7 @@ static void b3rb_estimate_init(struct context *ctx)
 	LOG_INF("init");
 }
 
-static void b3rb_estimate_fini(struct context *ctx)
+static void rover_estimate_fini(struct context *ctx)
 {
 	zros_pub_fini(&ctx->pub_odometry);
 	zros_sub_fini(&ctx->sub_wheel_odometry);
@@ -120,7 +122,7 @@ static void handle_update(struct context *ctx, double *x1)
 	}
 }
 
-static void b3rb_estimate_run(void *p0, void *p1, void *p2)
+static void rover_estimate_run(void *p0, void *p1, void *p2)
 {
 	struct context *ctx = p0;
 	ARG_UNUSED(p1);
@@ -129,7 +131,7 @@ static void b3rb_estimate_run(void *p0, void *p1, void *p2)
 	int rc = 0;
 
 	// LOG_DBG("started");
-	b3rb_estimate_init(ctx);
+	rover_estimate_init(ctx);
 
 	// variables
 	double rotation_last = 0;
@@ -234,24 +236,24 @@ static void b3rb_estimate_run(void *p0, void *p1, void *p2)
 			ctx->odometry.pose.orientation.w = cos(theta / 2);
 			ctx->odometry.twist.angular.z = omega;
 			ctx->odometry.twist.linear.x = u;
-			zros_pub_update(&ctx->pub_odometry);
+			synapse_pub_update(&ctx->pub_odometry, SYNAPSE_TOPIC_odometry_estimator);
 		}
 	}
 
-	b3rb_estimate_fini(ctx);
+	rover_estimate_fini(ctx);
 }
 
 static int start(struct context *ctx)
 {
 	k_tid_t tid =
 		k_thread_create(&ctx->thread_data, ctx->stack_area, ctx->stack_size,
-				b3rb_estimate_run, ctx, NULL, NULL, MY_PRIORITY, 0, K_FOREVER);
-	k_thread_name_set(tid, "b3rb_estimate");
+				rover_estimate_run, ctx, NULL, NULL, MY_PRIORITY, 0, K_FOREVER);
+	k_thread_name_set(tid, "rover_estimate");
 	k_thread_start(tid);
 	return 0;
 }
 
-static int b3rb_estimate_cmd_handler(const struct shell *sh, size_t argc, char **argv, void *data)
+static int rover_estimate_cmd_handler(const struct shell *sh, size_t argc, char **argv, void *data)
 {
 	ARG_UNUSED(argc);
 	struct context *ctx = data;
@@ -274,16 +276,16 @@ static int b3rb_estimate_cmd_handler(const struct shell *sh, size_t argc, char *
 	return 0;
 }
 
-SHELL_SUBCMD_DICT_SET_CREATE(sub_b3rb_estimate, b3rb_estimate_cmd_handler, (start, &g_ctx, "start"),
+SHELL_SUBCMD_DICT_SET_CREATE(sub_rover_estimate, rover_estimate_cmd_handler, (start, &g_ctx, "start"),
 			     (stop, &g_ctx, "stop"), (status, &g_ctx, "status"));
 
-SHELL_CMD_REGISTER(b3rb_estimate, &sub_b3rb_estimate, "b3rb estimate arguments", NULL);
+SHELL_CMD_REGISTER(rover_estimate, &sub_rover_estimate, "rover estimate arguments", NULL);
 
-static int b3rb_estimate_sys_init(void)
+static int rover_estimate_sys_init(void)
 {
 	return start(&g_ctx);
 };
 
-SYS_INIT(b3rb_estimate_sys_init, APPLICATION, 1);
+SYS_INIT(rover_estimate_sys_init, APPLICATION, 1);
 
 // vi: ts=4 sw=4 et
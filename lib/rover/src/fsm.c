@@ -24,7 +24,7 @@
 #define MY_PRIORITY   4
 #define STATE_ANY     -1
 
-LOG_MODULE_REGISTER(b3rb_fsm, CONFIG_CEREBRI_B3RB_LOG_LEVEL);
+LOG_MODULE_REGISTER(rover_fsm, CONFIG_CEREBRI_ROVER_LOG_LEVEL);
 
 static K_THREAD_STACK_DEFINE(g_my_stack_area, MY_STACK_SIZE);
 
@@ -176,9 +176,9 @@ static struct context g_ctx = {
 	.topic_loss_ticks = 1.0 * CONFIG_SYS_CLOCK_TICKS_PER_SEC,
 };
 
-static void b3rb_fsm_init(struct context *ctx)
+static void rover_fsm_init(struct context *ctx)
 {
-	zros_node_init(&ctx->node, "b3rb_fsm");
+	zros_node_init(&ctx->node, "rover_fsm");
 	zros_sub_init(&ctx->sub_battery_state, &ctx->node, &topic_battery_state,
 		      &ctx->battery_state, 10);
 	zros_sub_init(&ctx->sub_safety, &ctx->node, &topic_safety, &ctx->safety, 10);
@@ -194,7 +194,7 @@ static void b3rb_fsm_init(struct context *ctx)
 	LOG_INF("init");
 }
 
-static void b3rb_fsm_fini(struct context *ctx)
+static void rover_fsm_fini(struct context *ctx)
 {
 	zros_sub_fini(&ctx->sub_battery_state);
 	zros_sub_fini(&ctx->sub_safety);
@@ -227,9 +227,9 @@ static void fsm_compute_input(struct status_input *input, struct context *ctx)
 
 #ifdef CONFIG_CEREBRI_SENSE_POWER
 	input->fuel_low =
-		ctx->battery_state.voltage < CONFIG_CEREBRI_B3RB_BATTERY_LOW_MILLIVOLT / 1000.0;
+		ctx->battery_state.voltage < CONFIG_CEREBRI_ROVER_BATTERY_LOW_MILLIVOLT / 1000.0;
 	input->fuel_critical =
-		ctx->battery_state.voltage < CONFIG_CEREBRI_B3RB_BATTERY_MIN_MILLIVOLT / 1000.0;
+		ctx->battery_state.voltage < CONFIG_CEREBRI_ROVER_BATTERY_MIN_MILLIVOLT / 1000.0;
 #else
 	input->fuel_low = false;
 	input->fuel_critical = false;
@@ -428,8 +428,8 @@ static void status_add_extra_info(synapse_pb_Status *status, struct status_input
 	} else {
 		status->fuel = synapse_pb_Status_Fuel_FUEL_NOMINAL;
 	}
-	double bat_max = CONFIG_CEREBRI_B3RB_BATTERY_MAX_MILLIVOLT / 1000.0;
-	double bat_min = CONFIG_CEREBRI_B3RB_BATTERY_MIN_MILLIVOLT / 1000.0;
+	double bat_max = CONFIG_CEREBRI_ROVER_BATTERY_MAX_MILLIVOLT / 1000.0;
+	double bat_min = CONFIG_CEREBRI_ROVER_BATTERY_MIN_MILLIVOLT / 1000.0;
 	status->fuel_percentage =
 		100 * (ctx->battery_state.voltage - bat_min) / (bat_max - bat_min);
 	status->power = ctx->battery_state.voltage * ctx->battery_state.current;
@@ -446,13 +446,13 @@ static void status_add_extra_info(synapse_pb_Status *status, struct status_input
 #endif
 }
 
-static void b3rb_fsm_run(void *p0, void *p1, void *p2)
+static void rover_fsm_run(void *p0, void *p1, void *p2)
 {
 	struct context *ctx = p0;
 	ARG_UNUSED(p1);
 	ARG_UNUSED(p2);
 
-	b3rb_fsm_init(ctx);
+	rover_fsm_init(ctx);
 
 	struct k_poll_event events[] = {
 		*zros_sub_get_event(&ctx->sub_input_sbus),
@@ -473,7 +473,7 @@ static void b3rb_fsm_run(void *p0, void *p1, void *p2)
 		fsm_compute_input(&ctx->status_input, ctx);
 		fsm_update(&ctx->status, &ctx->status_input);
 		status_add_extra_info(&ctx->status, &ctx->status_input, ctx);
-		zros_pub_update(&ctx->pub_status);
+		synapse_pub_update(&ctx->pub_status, SYNAPSE_TOPIC_status);
 
 		struct status_input *in = &ctx->status_input;
 
@@ -539,7 +539,7 @@ static void b3rb_fsm_run(void *p0, void *p1, void *p2)
 		// update topic from correct source
 		if (in->update_topic_from_ethernet) {
 			ctx->cmd_vel = ctx->cmd_vel_ethernet;
-			zros_pub_update(&ctx->pub_cmd_vel);
+			synapse_pub_update(&ctx->pub_cmd_vel, SYNAPSE_TOPIC_cmd_vel);
 		}
 
 		// update ticks
@@ -562,25 +562,25 @@ static void b3rb_fsm_run(void *p0, void *p1, void *p2)
 		// publish control topics
 		if (in->update_topic && in->topic_source_ethernet) {
 			ctx->cmd_vel = ctx->cmd_vel_ethernet;
-			zros_pub_update(&ctx->pub_cmd_vel);
+			synapse_pub_update(&ctx->pub_cmd_vel, SYNAPSE_TOPIC_cmd_vel);
 		} else if (in->update_input && in->topic_source_input) {
-			zros_pub_update(&ctx->pub_input);
+			synapse_pub_update(&ctx->pub_input, SYNAPSE_TOPIC_input);
 		}
 	}
 
-	b3rb_fsm_fini(ctx);
+	rover_fsm_fini(ctx);
 }
 
 static int start(struct context *ctx)
 {
 	k_tid_t tid = k_thread_create(&ctx->thread_data, ctx->stack_area, ctx->stack_size,
-				      b3rb_fsm_run, ctx, NULL, NULL, MY_PRIORITY, 0, K_FOREVER);
-	k_thread_name_set(tid, "b3rb_fsm");
+				      rover_fsm_run, ctx, NULL, NULL, MY_PRIORITY, 0, K_FOREVER);
+	k_thread_name_set(tid, "rover_fsm");
 	k_thread_start(tid);
 	return 0;
 }
 
-static int b3rb_fsm_cmd_handler(const struct shell *sh, size_t argc, char **argv, void *data)
+static int rover_fsm_cmd_handler(const struct shell *sh, size_t argc, char **argv, void *data)
 {
 	ARG_UNUSED(argc);
 	struct context *ctx = data;
@@ -603,16 +603,16 @@ static int b3rb_fsm_cmd_handler(const struct shell *sh, size_t argc, char **argv
 	return 0;
 }
 
-SHELL_SUBCMD_DICT_SET_CREATE(sub_b3rb_fsm, b3rb_fsm_cmd_handler, (start, &g_ctx, "start"),
+SHELL_SUBCMD_DICT_SET_CREATE(sub_rover_fsm, rover_fsm_cmd_handler, (start, &g_ctx, "start"),
 			     (stop, &g_ctx, "stop"), (status, &g_ctx, "status"));
 
-SHELL_CMD_REGISTER(b3rb_fsm, &sub_b3rb_fsm, "b3rb fsm commands", NULL);
+SHELL_CMD_REGISTER(rover_fsm, &sub_rover_fsm, "rover fsm commands", NULL);
 
-static int b3rb_fsm_sys_init(void)
+static int rover_fsm_sys_init(void)
 {
 	return start(&g_ctx);
 };
 
-SYS_INIT(b3rb_fsm_sys_init, APPLICATION, 1);
+SYS_INIT(rover_fsm_sys_init, APPLICATION, 1);
 
 // vi: ts=4 sw=4 et
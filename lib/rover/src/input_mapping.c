@@ -2,7 +2,7 @@
 #include <math.h>
 #include <zephyr/logging/log.h>
 
-LOG_MODULE_DECLARE(b3rb_fsm);
+LOG_MODULE_DECLARE(rover_fsm);
 
 int two_position_switch(float val)
 {
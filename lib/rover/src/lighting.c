@@ -21,7 +21,7 @@
 #define MY_STACK_SIZE 2048
 #define MY_PRIORITY   4
 
-LOG_MODULE_REGISTER(melm_lighting, CONFIG_CEREBRI_MELM_LOG_LEVEL);
+LOG_MODULE_REGISTER(rover_lighting, CONFIG_CEREBRI_ROVER_LOG_LEVEL);
 
 static K_THREAD_STACK_DEFINE(g_my_stack_area, MY_STACK_SIZE);
 
@@ -58,9 +58,9 @@ static struct context g_ctx = {
 	.thread_data = {},
 };
 
-static void melm_lighting_init(struct context *ctx)
+static void rover_lighting_init(struct context *ctx)
 {
-	zros_node_init(&ctx->node, "melm_lighting");
+	zros_node_init(&ctx->node, "rover_lighting");
 	zros_sub_init(&ctx->sub_battery_state, &ctx->node, &topic_battery_state,
 		      &ctx->battery_state, 10);
 	zros_sub_init(&ctx->sub_safety, &ctx->node, &topic_safety, &ctx->safety, 10);
@@ -70,7 +70,7 @@ static void melm_lighting_init(struct context *ctx)
 	LOG_INF("init");
 }
 
-static void melm_lighting_fini(struct context *ctx)
+static void rover_lighting_fini(struct context *ctx)
 {
 	zros_sub_fini(&ctx->sub_battery_state);
 	zros_sub_fini(&ctx->sub_safety);
@@ -90,13 +90,13 @@ static void set_led(const int index, const double *color, const double brightnes
 	led->b = brightness * color[2];
 }
 
-static void melm_lighting_run(void *p0, void *p1, void *p2)
+static void rover_lighting_run(void *p0, void *p1, void *p2)
 {
 	struct context *ctx = p0;
 	ARG_UNUSED(p1);
 	ARG_UNUSED(p2);
 
-	melm_lighting_init(ctx);
+	rover_lighting_init(ctx);
 
 	while (k_sem_take(&ctx->running, K_NO_WAIT) < 0) {
 
@@ -148,7 +148,7 @@ static void melm_lighting_run(void *p0, void *p1, void *p2)
 		const double color_white[] = {1, 1, 1};
 
 		bool battery_critical = ctx->battery_state.voltage <
-					CONFIG_CEREBRI_MELM_BATTERY_MIN_MILLIVOLT / 1000.0;
+					CONFIG_CEREBRI_ROVER_BATTERY_MIN_MILLIVOLT / 1000.0;
 
 		// mode leds
 		for (size_t i = 0; i < ARRAY_SIZE(mode_leds); i++) {
@@ -225,23 +225,23 @@ static void melm_lighting_run(void *p0, void *p1, void *p2)
 		stamp_msg(&ctx->led_array.stamp, k_uptime_ticks());
 		ctx->led_array.led_count = led_msg_index;
 
-		zros_pub_update(&ctx->pub_led_array);
+		synapse_pub_update(&ctx->pub_led_array, SYNAPSE_TOPIC_led_array);
 	}
 
-	melm_lighting_fini(ctx);
+	rover_lighting_fini(ctx);
 }
 
 static int start(struct context *ctx)
 {
 	k_tid_t tid =
 		k_thread_create(&ctx->thread_data, ctx->stack_area, ctx->stack_size,
-				melm_lighting_run, ctx, NULL, NULL, MY_PRIORITY, 0, K_FOREVER);
-	k_thread_name_set(tid, "rdd2_lighting");
+				rover_lighting_run, ctx, NULL, NULL, MY_PRIORITY, 0, K_FOREVER);
+	k_thread_name_set(tid, "rover_lighting");
 	k_thread_start(tid);
 	return 0;
 }
 
-static int melm_lighting_cmd_handler(const struct shell *sh, size_t argc, char **argv, void *data)
+static int rover_lighting_cmd_handler(const struct shell *sh, size_t argc, char **argv, void *data)
 {
 	ARG_UNUSED(argc);
 	struct context *ctx = data;
@@ -268,16 +268,16 @@ static int melm_lighting_cmd_handler(const struct shell *sh, size_t argc, char *
 	return 0;
 }
 
-SHELL_SUBCMD_DICT_SET_CREATE(sub_melm_lighting, melm_lighting_cmd_handler, (start, &g_ctx, "start"),
+SHELL_SUBCMD_DICT_SET_CREATE(sub_rover_lighting, rover_lighting_cmd_handler, (start, &g_ctx, "start"),
 			     (stop, &g_ctx, "stop"), (status, &g_ctx, "status"));
 
-SHELL_CMD_REGISTER(melm_lighting, &sub_melm_lighting, "melm lighting commands", NULL);
+SHELL_CMD_REGISTER(rover_lighting, &sub_rover_lighting, "rover lighting commands", NULL);
 
-static int melm_lighting_sys_init(void)
+static int rover_lighting_sys_init(void)
 {
 	return start(&g_ctx);
 };
 
-SYS_INIT(melm_lighting_sys_init, APPLICATION, 10);
+SYS_INIT(rover_lighting_sys_init, APPLICATION, 10);
 
 // vi: ts=4 sw=4 et
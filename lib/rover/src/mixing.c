@@ -0,0 +1,48 @@
+/*
+ * Copyright CogniPilot Foundation 2023
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "mixing.h"
+
+#if defined(CONFIG_CEREBRI_ROVER_ACKERMANN)
+void rover_set_actuators(synapse_pb_Actuators *msg, double turn_angle, double omega_fwd, bool armed)
+{
+	msg->has_stamp = true;
+	stamp_msg(&msg->stamp, k_uptime_ticks());
+
+	if (!armed) {
+		// stop if not armed
+		turn_angle = 0;
+		omega_fwd = 0;
+	}
+
+	msg->position_count = 1;
+	msg->position[0] = turn_angle;
+
+	msg->velocity_count = 1;
+	msg->velocity[0] = omega_fwd;
+
+	msg->normalized_count = 1;
+	msg->normalized[0] = armed ? 1 : -1;
+}
+#elif defined(CONFIG_CEREBRI_ROVER_DIFFERENTIAL)
+void rover_set_actuators(synapse_pb_Actuators *msg, double omega_left, double omega_right,
+			 bool armed)
+{
+	msg->has_stamp = true;
+	stamp_msg(&msg->stamp, k_uptime_ticks());
+
+	if (!armed) {
+		// stop if not armed
+		omega_left = 0;
+		omega_right = 0;
+	}
+
+	msg->velocity_count = 2;
+	msg->velocity[0] = omega_left;
+	msg->velocity[1] = omega_right;
+}
+#endif
+
+/* vi: ts=4 sw=4 et */
@@ -0,0 +1,19 @@
+/*
+ * Copyright CogniPilot Foundation 2023
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CEREBRI_ROVER_MIXING_H
+#define CEREBRI_ROVER_MIXING_H
+
+#include <synapse_topic_list.h>
+
+#if defined(CONFIG_CEREBRI_ROVER_ACKERMANN)
+void rover_set_actuators(synapse_pb_Actuators *msg, double turn_angle, double omega_fwd, bool armed);
+#elif defined(CONFIG_CEREBRI_ROVER_DIFFERENTIAL)
+void rover_set_actuators(synapse_pb_Actuators *msg, double omega_left, double omega_right,
+			 bool armed);
+#endif
+
+#endif // CEREBRI_ROVER_MIXING_H
+/* vi: ts=4 sw=4 et */
@@ -0,0 +1,396 @@
+/*
+ * Copyright CogniPilot Foundation 2023
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <inttypes.h>
+#include <math.h>
+
+#include <zros/private/zros_node_struct.h>
+#include <zros/private/zros_pub_struct.h>
+#include <zros/private/zros_sub_struct.h>
+#include <zros/zros_node.h>
+#include <zros/zros_pub.h>
+#include <zros/zros_sub.h>
+
+#include <synapse_topic_list.h>
+#include <synapse_trajectory.h>
+
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+
+#include "rover/casadi/rover.h"
+
+#include <cerebri/core/casadi.h>
+#include <cerebri/core/perf_duration.h>
+
+#define MY_STACK_SIZE 4096
+#define MY_PRIORITY   4
+
+LOG_MODULE_REGISTER(rover_position, CONFIG_CEREBRI_ROVER_LOG_LEVEL);
+
+static K_THREAD_STACK_DEFINE(g_my_stack_area, MY_STACK_SIZE);
+
+CASADI_FUNC_DEFINE(bezier6_rover);
+CASADI_FUNC_DEFINE(se2_error);
+#if defined(CONFIG_CEREBRI_ROVER_POSITION_MPC)
+CASADI_FUNC_DEFINE(rover_mpc);
+
+// the vehicle casadi script is generated with this horizon, checked against
+// the size of the rover_mpc du output at init
+#define MPC_HORIZON CONFIG_CEREBRI_ROVER_MPC_HORIZON
+#endif
+
+struct context {
+	struct zros_node node;
+	synapse_pb_Status status;
+	struct synapse_trajectory trajectory;
+	synapse_pb_ClockOffset clock_offset_ethernet;
+	synapse_pb_Odometry odometry_estimator;
+	synapse_pb_Twist cmd_vel;
+	struct zros_sub sub_status, sub_clock_offset_ethernet, sub_odometry_estimator;
+	struct zros_pub pub_cmd_vel;
+	const double wheel_base;
+	const double gain_along_track;
+	const double gain_cross_track;
+	const double gain_heading;
+#if defined(CONFIG_CEREBRI_ROVER_POSITION_MPC)
+	casadi_real mpc_du[2 * MPC_HORIZON];
+	uint32_t mpc_iterations;
+	uint32_t mpc_iterations_max;
+	uint64_t mpc_iterations_sum;
+	uint64_t mpc_solves;
+	struct perf_duration mpc_duration;
+#endif
+	struct k_sem running;
+	size_t stack_size;
+	k_thread_stack_t *stack_area;
+	struct k_thread thread_data;
+};
+
+static struct context g_ctx = {
+	.status = synapse_pb_Status_init_default,
+	.trajectory = {},
+	.clock_offset_ethernet = synapse_pb_ClockOffset_init_default,
+	.odometry_estimator = synapse_pb_Odometry_init_default,
+	.cmd_vel =
+		{
+			.has_angular = true,
+			.has_linear = true,
+			.linear = synapse_pb_Vector3_init_default,
+			.angular = synapse_pb_Vector3_init_default,
+		},
+	.sub_status = {},
+	.sub_clock_offset_ethernet = {},
+	.sub_odometry_estimator = {},
+	.pub_cmd_vel = {},
+	.wheel_base = CONFIG_CEREBRI_ROVER_WHEEL_BASE_MM / 1000.0,
+	.gain_along_track = CONFIG_CEREBRI_ROVER_GAIN_ALONG_TRACK / 1000.0,
+	.gain_cross_track = CONFIG_CEREBRI_ROVER_GAIN_CROSS_TRACK / 1000.0,
+	.gain_heading = CONFIG_CEREBRI_ROVER_GAIN_HEADING / 1000.0,
+#if defined(CONFIG_CEREBRI_ROVER_POSITION_MPC)
+	.mpc_du = {},
+	.mpc_iterations = 0,
+	.mpc_iterations_max = 0,
+	.mpc_iterations_sum = 0,
+	.mpc_solves = 0,
+	.mpc_duration = {},
+#endif
+	.running = Z_SEM_INITIALIZER(g_ctx.running, 1, 1),
+	.stack_size = MY_STACK_SIZE,
+	.stack_area = g_my_stack_area,
+	.thread_data = {},
+};
+
+static void rover_position_init(struct context *ctx)
+{
+	zros_node_init(&ctx->node, "rover_position");
+	zros_sub_init(&ctx->sub_status, &ctx->node, &topic_status, &ctx->status, 10);
+	zros_sub_init(&ctx->sub_clock_offset_ethernet, &ctx->node, &topic_clock_offset_ethernet,
+		      &ctx->clock_offset_ethernet, 10);
+	zros_sub_init(&ctx->sub_odometry_estimator, &ctx->node, &topic_odometry_estimator,
+		      &ctx->odometry_estimator, 10);
+	zros_pub_init(&ctx->pub_cmd_vel, &ctx->node, &topic_cmd_vel, &ctx->cmd_vel);
+	synapse_trajectory_init(&ctx->trajectory);
+#if defined(CONFIG_CEREBRI_ROVER_POSITION_MPC)
+	__ASSERT((size_t)(rover_mpc_sparsity_out(2)[0] * rover_mpc_sparsity_out(2)[1]) ==
+			 ARRAY_SIZE(ctx->mpc_du),
+		 "rover_mpc horizon does not match CONFIG_CEREBRI_ROVER_MPC_HORIZON");
+	perf_duration_init(&ctx->mpc_duration, "rover mpc",
+			   CONFIG_CEREBRI_ROVER_MPC_DEADLINE_US * 1e-6);
+#endif
+	k_sem_take(&ctx->running, K_FOREVER);
+	LOG_INF("init");
+}
+
+static void rover_position_fini(struct context *ctx)
+{
+	zros_sub_fini(&ctx->sub_status);
+	zros_sub_fini(&ctx->sub_clock_offset_ethernet);
+	zros_sub_fini(&ctx->sub_odometry_estimator);
+	zros_pub_fini(&ctx->pub_cmd_vel);
+#if defined(CONFIG_CEREBRI_ROVER_POSITION_MPC)
+	perf_duration_fini(&ctx->mpc_duration);
+#endif
+	zros_node_fini(&ctx->node);
+	k_sem_give(&ctx->running);
+	LOG_INF("fini");
+}
+
+static void rover_position_stop(struct context *ctx)
+{
+	ctx->cmd_vel.linear.x = 0;
+	ctx->cmd_vel.angular.z = 0;
+#if defined(CONFIG_CEREBRI_ROVER_POSITION_MPC)
+	memset(ctx->mpc_du, 0, sizeof(ctx->mpc_du));
+#endif
+}
+
+#if defined(CONFIG_CEREBRI_ROVER_POSITION_MPC)
+// solves the tracking mpc for the curve, warm started from the last solution
+static void rover_position_mpc(struct context *ctx, casadi_real t, casadi_real T,
+			      const casadi_real *PX, const casadi_real *PY, const casadi_real *e)
+{
+	const casadi_real L = ctx->wheel_base;
+	const casadi_real V_max = CONFIG_CEREBRI_ROVER_MAX_VELOCITY_MM_S / 1000.0;
+	const casadi_real delta_max = CONFIG_CEREBRI_ROVER_MAX_TURN_ANGLE_MRAD / 1000.0;
+	const casadi_real q[3] = {
+		CONFIG_CEREBRI_ROVER_MPC_WEIGHT_ALONG_TRACK / 1000.0,
+		CONFIG_CEREBRI_ROVER_MPC_WEIGHT_CROSS_TRACK / 1000.0,
+		CONFIG_CEREBRI_ROVER_MPC_WEIGHT_HEADING / 1000.0,
+	};
+	const casadi_real r[2] = {
+		CONFIG_CEREBRI_ROVER_MPC_WEIGHT_VELOCITY / 1000.0,
+		CONFIG_CEREBRI_ROVER_MPC_WEIGHT_ANGULAR_VELOCITY / 1000.0,
+	};
+	casadi_real V, omega, iterations;
+
+	perf_duration_start(&ctx->mpc_duration);
+
+	/* rover_mpc:(t,T,PX[1x6],PY[1x6],e0[3],L,V_max,delta_max,q[3],r[2],
+	 * du0[2*MPC_HORIZON])->(V,omega,du[2*MPC_HORIZON],iterations) */
+	{
+		CASADI_FUNC_ARGS(rover_mpc);
+		args[0] = &t;
+		args[1] = &T;
+		args[2] = PX;
+		args[3] = PY;
+		args[4] = e;
+		args[5] = &L;
+		args[6] = &V_max;
+		args[7] = &delta_max;
+		args[8] = q;
+		args[9] = r;
+		args[10] = ctx->mpc_du;
+		res[0] = &V;
+		res[1] = &omega;
+		res[2] = ctx->mpc_du;
+		res[3] = &iterations;
+		CASADI_FUNC_CALL(rover_mpc);
+	}
+
+	perf_duration_stop(&ctx->mpc_duration);
+
+	ctx->mpc_iterations = iterations;
+	ctx->mpc_iterations_sum += ctx->mpc_iterations;
+	ctx->mpc_solves++;
+	if (ctx->mpc_iterations > ctx->mpc_iterations_max) {
+		ctx->mpc_iterations_max = ctx->mpc_iterations;
+	}
+
+	ctx->cmd_vel.linear.x = V;
+	ctx->cmd_vel.angular.z = omega;
+}
+#endif
+
+// computes thrust/steering in auto mode
+static void bezier_position_mode(struct context *ctx)
+{
+	// get current time
+	int64_t time_nsec = k_ticks_to_ns_floor64(k_uptime_ticks()) +
+			    timestamp_to_ns(&ctx->clock_offset_ethernet.offset);
+
+	// find current trajectory index, time and duration of the curve
+	double t_leg, T_leg;
+	int curve_index = synapse_trajectory_find(&ctx->trajectory, time_nsec, &t_leg, &T_leg);
+	if (curve_index == -EAGAIN) {
+		LOG_WRN("time current: %" PRId64 " ns < time start: %" PRId64
+			"  ns, time out of range of trajectory\n",
+			time_nsec, synapse_trajectory_time_start(&ctx->trajectory));
+		rover_position_stop(ctx);
+		return;
+	} else if (curve_index < 0) {
+		LOG_DBG("curve index exceeds bounds");
+		rover_position_stop(ctx);
+		return;
+	}
+
+	casadi_real T = T_leg;
+	casadi_real t = t_leg;
+	casadi_real x, y, psi, V, omega = 0;
+	casadi_real e[3] = {}; // e_x, e_y, e_theta
+
+	const synapse_pb_BezierTrajectory_Curve *curve =
+		synapse_trajectory_curve(&ctx->trajectory, curve_index);
+
+	// the kernels may be single precision, so positions are taken relative to the start of
+	// the curve in double first, the curve and the tracking error are translation invariant
+	const double origin_x = curve->x[0];
+	const double origin_y = curve->y[0];
+	casadi_real PX[6], PY[6];
+	for (int i = 0; i < 6; i++) {
+		PX[i] = curve->x[i] - origin_x;
+		PY[i] = curve->y[i] - origin_y;
+	}
+
+	/* bezier6_rover:(t,T,PX[1x6],PY[1x6],L)->(x,y,psi,V,omega) */
+	{
+		CASADI_FUNC_ARGS(bezier6_rover);
+		args[0] = &t;
+		args[1] = &T;
+		args[2] = PX;
+		args[3] = PY;
+		res[0] = &x;
+		res[1] = &y;
+		res[2] = &psi;
+		res[3] = &V;
+		res[4] = &omega;
+		CASADI_FUNC_CALL(bezier6_rover);
+	}
+
+	/* se2_error:(p[3],r[3])->(error[3]) */
+	{
+		casadi_real p[3], r[3];
+
+		// vehicle position
+		p[0] = ctx->odometry_estimator.pose.position.x - origin_x;
+		p[1] = ctx->odometry_estimator.pose.position.y - origin_y;
+		p[2] = 2 * atan2(ctx->odometry_estimator.pose.orientation.z,
+				 ctx->odometry_estimator.pose.orientation.w);
+
+		// reference position
+		r[0] = x;
+		r[1] = y;
+		r[2] = psi;
+
+		// call function
+		CASADI_FUNC_ARGS(se2_error);
+		args[0] = p;
+		args[1] = r;
+		res[0] = e;
+		CASADI_FUNC_CALL(se2_error);
+	}
+
+#if defined(CONFIG_CEREBRI_ROVER_POSITION_MPC)
+	rover_position_mpc(ctx, t, T, PX, PY, e);
+#else
+	// compute twist
+	ctx->cmd_vel.linear.x = V + ctx->gain_along_track * e[0];
+	ctx->cmd_vel.angular.z = omega + ctx->gain_cross_track * e[1] + ctx->gain_heading * e[2];
+#endif
+}
+
+static void rover_position_run(void *p0, void *p1, void *p2)
+{
+	LOG_INF("init");
+	struct context *ctx = p0;
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+
+	rover_position_init(ctx);
+
+	struct k_poll_event events[] = {
+		*zros_sub_get_event(&ctx->sub_odometry_estimator),
+	};
+
+	while (true) {
+
+		int rc = 0;
+		rc = k_poll(events, ARRAY_SIZE(events), K_MSEC(1000));
+		if (rc != 0) {
+			LOG_DBG("pos not receiving estimator odometry");
+			continue;
+		}
+
+		int64_t traj_time_nsec = k_ticks_to_ns_floor64(k_uptime_ticks()) +
+					 timestamp_to_ns(&ctx->clock_offset_ethernet.offset);
+		if (synapse_trajectory_update(&ctx->trajectory, traj_time_nsec) < 0) {
+			LOG_ERR("bezier trajectory chunk rejected");
+		}
+
+		if (zros_sub_update_available(&ctx->sub_status)) {
+			zros_sub_update(&ctx->sub_status);
+		}
+
+		if (zros_sub_update_available(&ctx->sub_odometry_estimator)) {
+			zros_sub_update(&ctx->sub_odometry_estimator);
+		}
+
+		if (zros_sub_update_available(&ctx->sub_clock_offset_ethernet)) {
+			zros_sub_update(&ctx->sub_clock_offset_ethernet);
+		}
+
+		if (ctx->status.mode == synapse_pb_Status_Mode_MODE_BEZIER) {
+			bezier_position_mode(ctx);
+			synapse_pub_update(&ctx->pub_cmd_vel, SYNAPSE_TOPIC_cmd_vel);
+		}
+	}
+
+	rover_position_fini(ctx);
+}
+
+static int start(struct context *ctx)
+{
+	k_tid_t tid =
+		k_thread_create(&ctx->thread_data, ctx->stack_area, ctx->stack_size,
+				rover_position_run, ctx, NULL, NULL, MY_PRIORITY, 0, K_FOREVER);
+	k_thread_name_set(tid, "rover_position");
+	k_thread_start(tid);
+	return 0;
+}
+
+static int rover_position_cmd_handler(const struct shell *sh, size_t argc, char **argv, void *data)
+{
+	ARG_UNUSED(argc);
+	struct context *ctx = data;
+
+	if (strcmp(argv[0], "start") == 0) {
+		if (k_sem_count_get(&g_ctx.running) == 0) {
+			shell_print(sh, "already running");
+		} else {
+			start(ctx);
+		}
+	} else if (strcmp(argv[0], "stop") == 0) {
+		if (k_sem_count_get(&g_ctx.running) == 0) {
+			k_sem_give(&g_ctx.running);
+		} else {
+			shell_print(sh, "not running");
+		}
+	} else if (strcmp(argv[0], "status") == 0) {
+		shell_print(sh, "running: %d", (int)k_sem_count_get(&g_ctx.running) == 0);
+		shell_print(sh, "trajectory chunks: %u dropped: %u pending: %d",
+			    ctx->trajectory.chunks, ctx->trajectory.dropped,
+			    ctx->trajectory.pending);
+#if defined(CONFIG_CEREBRI_ROVER_POSITION_MPC)
+		shell_print(sh,
+			    "mpc solves: %" PRIu64 " iterations last: %u max: %u avg: %" PRIu64,
+			    ctx->mpc_solves, ctx->mpc_iterations, ctx->mpc_iterations_max,
+			    ctx->mpc_solves ? ctx->mpc_iterations_sum / ctx->mpc_solves : 0);
+#endif
+	}
+	return 0;
+}
+
+SHELL_SUBCMD_DICT_SET_CREATE(sub_rover_position, rover_position_cmd_handler, (start, &g_ctx, "start"),
+			     (stop, &g_ctx, "stop"), (status, &g_ctx, "status"));
+
+SHELL_CMD_REGISTER(rover_position, &sub_rover_position, "rover position arguments", NULL);
+
+static int rover_position_sys_init(void)
+{
+	return start(&g_ctx);
+};
+
+SYS_INIT(rover_position_sys_init, APPLICATION, 1);
+
+// vi: ts=4 sw=4 et
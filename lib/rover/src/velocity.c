@@ -3,7 +3,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
-#include "app/b3rb/casadi/b3rb.h"
+#include "rover/casadi/rover.h"
 #include "math.h"
 
 #include <zephyr/kernel.h>
@@ -18,16 +18,23 @@
 #include <zros/zros_sub.h>
 
 #include <cerebri/core/casadi.h>
+#include <cerebri/core/freshness.h>
 
 #include "mixing.h"
 
 #define MY_STACK_SIZE 3072
 #define MY_PRIORITY   4
 
-LOG_MODULE_REGISTER(b3rb_velocity, CONFIG_CEREBRI_B3RB_LOG_LEVEL);
+LOG_MODULE_REGISTER(rover_velocity, CONFIG_CEREBRI_ROVER_LOG_LEVEL);
 
 static K_THREAD_STACK_DEFINE(g_my_stack_area, MY_STACK_SIZE);
 
+#if defined(CONFIG_CEREBRI_ROVER_ACKERMANN)
+CASADI_FUNC_DEFINE(ackermann_steering);
+#elif defined(CONFIG_CEREBRI_ROVER_DIFFERENTIAL)
+CASADI_FUNC_DEFINE(differential_steering);
+#endif
+
 struct context {
 	struct zros_node node;
 	synapse_pb_Twist cmd_vel;
@@ -35,8 +42,12 @@ struct context {
 	synapse_pb_Actuators actuators;
 	struct zros_sub sub_status, sub_cmd_vel;
 	struct zros_pub pub_actuators;
+	struct freshness fresh_cmd_vel;
 	const double wheel_radius;
 	const double wheel_base;
+#if defined(CONFIG_CEREBRI_ROVER_DIFFERENTIAL)
+	const double wheel_separation;
+#endif
 	struct k_sem running;
 	size_t stack_size;
 	k_thread_stack_t *stack_area;
@@ -51,26 +62,33 @@ static struct context g_ctx = {
 	.sub_status = {},
 	.sub_cmd_vel = {},
 	.pub_actuators = {},
-	.wheel_radius = CONFIG_CEREBRI_B3RB_WHEEL_RADIUS_MM / 1000.0,
-	.wheel_base = CONFIG_CEREBRI_B3RB_WHEEL_BASE_MM / 1000.0,
+	.fresh_cmd_vel = {},
+	.wheel_radius = CONFIG_CEREBRI_ROVER_WHEEL_RADIUS_MM / 1000.0,
+	.wheel_base = CONFIG_CEREBRI_ROVER_WHEEL_BASE_MM / 1000.0,
+#if defined(CONFIG_CEREBRI_ROVER_DIFFERENTIAL)
+	.wheel_separation = CONFIG_CEREBRI_ROVER_WHEEL_SEPARATION_MM / 1000.0,
+#endif
 	.running = Z_SEM_INITIALIZER(g_ctx.running, 1, 1),
 	.stack_size = MY_STACK_SIZE,
 	.stack_area = g_my_stack_area,
 	.thread_data = {},
 };
 
-static void b3rb_velocity_init(struct context *ctx)
+static void rover_velocity_init(struct context *ctx)
 {
-	zros_node_init(&ctx->node, "b3rb_velocity");
+	zros_node_init(&ctx->node, "rover_velocity");
 	zros_sub_init(&ctx->sub_cmd_vel, &ctx->node, &topic_cmd_vel, &ctx->cmd_vel, 10);
 	zros_sub_init(&ctx->sub_status, &ctx->node, &topic_status, &ctx->status, 10);
 	zros_pub_init(&ctx->pub_actuators, &ctx->node, &topic_actuators, &ctx->actuators);
+	freshness_init(&ctx->fresh_cmd_vel, "rover_velocity cmd_vel",
+		       CONFIG_CEREBRI_ROVER_CMD_VEL_MAX_AGE_MS);
 	k_sem_take(&ctx->running, K_FOREVER);
 	LOG_INF("init");
 }
 
-static void b3rb_velocity_fini(struct context *ctx)
+static void rover_velocity_fini(struct context *ctx)
 {
+	freshness_fini(&ctx->fresh_cmd_vel);
 	zros_pub_fini(&ctx->pub_actuators);
 	zros_sub_fini(&ctx->sub_status);
 	zros_sub_fini(&ctx->sub_cmd_vel);
@@ -80,16 +98,18 @@ static void b3rb_velocity_fini(struct context *ctx)
 }
 
 // computes actuators from cmd_vel
-static void b3rb_velocity_update(struct context *ctx)
+static void rover_velocity_update(struct context *ctx)
 {
+#if defined(CONFIG_CEREBRI_ROVER_ACKERMANN)
 	double turn_angle = 0;
 	double omega_fwd = 0;
-	double V = ctx->cmd_vel.linear.x;
-	double omega = ctx->cmd_vel.angular.z;
-	double delta = 0;
+	casadi_real L = ctx->wheel_base;
+	casadi_real V = ctx->cmd_vel.linear.x;
+	casadi_real omega = ctx->cmd_vel.angular.z;
+	casadi_real delta = 0;
 
 	CASADI_FUNC_ARGS(ackermann_steering);
-	args[0] = &ctx->wheel_base;
+	args[0] = &L;
 	args[1] = &omega;
 	args[2] = &V;
 	res[0] = &delta;
@@ -99,32 +119,54 @@ static void b3rb_velocity_update(struct context *ctx)
 	if (fabs(V) > 0.01) {
 		turn_angle = delta;
 	}
+#elif defined(CONFIG_CEREBRI_ROVER_DIFFERENTIAL)
+	double V = ctx->cmd_vel.linear.x;
+	casadi_real L = ctx->wheel_base;
+	casadi_real w = ctx->wheel_separation;
+	casadi_real omega = ctx->cmd_vel.angular.z;
+	casadi_real Vw = 0; // differential wheel velocity
+
+	CASADI_FUNC_ARGS(differential_steering);
+	args[0] = &L;
+	args[1] = &omega;
+	args[2] = &w;
+	res[0] = &Vw;
+	CASADI_FUNC_CALL(differential_steering);
+
+	double omega_left = (V - Vw) / ctx->wheel_radius;
+	double omega_right = (V + Vw) / ctx->wheel_radius;
+#endif
 
 	bool armed = ctx->status.arming == synapse_pb_Status_Arming_ARMING_ARMED;
 
-	b3rb_set_actuators(&ctx->actuators, turn_angle, omega_fwd, armed);
+#if defined(CONFIG_CEREBRI_ROVER_ACKERMANN)
+	rover_set_actuators(&ctx->actuators, turn_angle, omega_fwd, armed);
+#elif defined(CONFIG_CEREBRI_ROVER_DIFFERENTIAL)
+	rover_set_actuators(&ctx->actuators, omega_left, omega_right, armed);
+#endif
 
 	// publish
-	zros_pub_update(&ctx->pub_actuators);
+	synapse_pub_update(&ctx->pub_actuators, SYNAPSE_TOPIC_actuators);
 }
 
-static void b3rb_velocity_run(void *p0, void *p1, void *p2)
+static void rover_velocity_run(void *p0, void *p1, void *p2)
 {
 	struct context *ctx = p0;
 	ARG_UNUSED(p1);
 	ARG_UNUSED(p2);
 
-	b3rb_velocity_init(ctx);
+	rover_velocity_init(ctx);
 
 	while (k_sem_take(&ctx->running, K_NO_WAIT) < 0) {
 		struct k_poll_event events[] = {
 			*zros_sub_get_event(&ctx->sub_cmd_vel),
 		};
-		int rc = k_poll(events, ARRAY_SIZE(events), K_MSEC(1000));
+		// wake up at the cmd_vel deadline to stop the vehicle
+		int rc = k_poll(events, ARRAY_SIZE(events),
+				K_MSEC(CONFIG_CEREBRI_ROVER_CMD_VEL_MAX_AGE_MS));
 
 		if (rc < 0) {
 			LOG_DBG("not receiving cmd_vel");
-			continue;
 		}
 
 		if (zros_sub_update_available(&ctx->sub_status)) {
@@ -133,28 +175,34 @@ static void b3rb_velocity_run(void *p0, void *p1, void *p2)
 
 		if (zros_sub_update_available(&ctx->sub_cmd_vel)) {
 			zros_sub_update(&ctx->sub_cmd_vel);
+			freshness_update(&ctx->fresh_cmd_vel);
+		}
+
+		// never keep driving on an old command
+		if (!freshness_check(&ctx->fresh_cmd_vel)) {
+			ctx->cmd_vel = (synapse_pb_Twist)synapse_pb_Twist_init_default;
 		}
 
 		// handle modes
 		if (ctx->status.mode != synapse_pb_Status_Mode_MODE_ACTUATORS) {
-			b3rb_velocity_update(ctx);
+			rover_velocity_update(ctx);
 		}
 	}
 
-	b3rb_velocity_fini(ctx);
+	rover_velocity_fini(ctx);
 }
 
 static int start(struct context *ctx)
 {
 	k_tid_t tid =
 		k_thread_create(&ctx->thread_data, ctx->stack_area, ctx->stack_size,
-				b3rb_velocity_run, ctx, NULL, NULL, MY_PRIORITY, 0, K_FOREVER);
-	k_thread_name_set(tid, "b3rb_velocity");
+				rover_velocity_run, ctx, NULL, NULL, MY_PRIORITY, 0, K_FOREVER);
+	k_thread_name_set(tid, "rover_velocity");
 	k_thread_start(tid);
 	return 0;
 }
 
-static int b3rb_velocity_cmd_handler(const struct shell *sh, size_t argc, char **argv, void *data)
+static int rover_velocity_cmd_handler(const struct shell *sh, size_t argc, char **argv, void *data)
 {
 	ARG_UNUSED(argc);
 	struct context *ctx = data;
@@ -177,16 +225,16 @@ static int b3rb_velocity_cmd_handler(const struct shell *sh, size_t argc, char *
 	return 0;
 }
 
-SHELL_SUBCMD_DICT_SET_CREATE(sub_b3rb_velocity, b3rb_velocity_cmd_handler, (start, &g_ctx, "start"),
+SHELL_SUBCMD_DICT_SET_CREATE(sub_rover_velocity, rover_velocity_cmd_handler, (start, &g_ctx, "start"),
 			     (stop, &g_ctx, "stop"), (status, &g_ctx, "status"));
 
-SHELL_CMD_REGISTER(b3rb_velocity, &sub_b3rb_velocity, "b3rb velocity arguments", NULL);
+SHELL_CMD_REGISTER(rover_velocity, &sub_rover_velocity, "rover velocity arguments", NULL);
 
-static int b3rb_velocity_sys_init(void)
+static int rover_velocity_sys_init(void)
 {
 	return start(&g_ctx);
 };
 
-SYS_INIT(b3rb_velocity_sys_init, APPLICATION, 1);
+SYS_INIT(rover_velocity_sys_init, APPLICATION, 1);
 
 // vi: ts=4 sw=4 et
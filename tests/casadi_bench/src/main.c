@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2024 CogniPilot Foundation
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/random/random.h>
+
+#if defined(CONFIG_ARCH_POSIX)
+#include <time.h>
+#endif
+
+#include "casadi/b3rb.h"
+#include "casadi/b3rb_estimate.h"
+#include "casadi/bezier.h"
+#include "casadi/rdd2.h"
+#include "casadi/rdd2_loglinear.h"
+#include "lib/core/common/casadi/common.h"
+
+LOG_MODULE_REGISTER(casadi_bench, CONFIG_CASADI_BENCH_LOG_LEVEL);
+
+#define BENCH_INPUT_SETS  8
+#define BENCH_MAX_ARG     64
+#define BENCH_MAX_NNZ     512
+#define BENCH_MAX_IW      256
+#define BENCH_MAX_W       4096
+#define BENCH_STACK_SIZE  8192
+#define BENCH_PRIORITY    5
+
+/********************************************************************
+ * kernel table
+ ********************************************************************/
+typedef int casadi_eval_t(const casadi_real **arg, casadi_real **res, casadi_int *iw,
+			  casadi_real *w, int mem);
+
+struct kernel {
+	const char *name;
+	casadi_eval_t *eval;
+	casadi_int (*n_in)(void);
+	casadi_int (*n_out)(void);
+	const casadi_int *(*sparsity_in)(casadi_int i);
+	const casadi_int *(*sparsity_out)(casadi_int i);
+	int (*work)(casadi_int *sz_arg, casadi_int *sz_res, casadi_int *sz_iw, casadi_int *sz_w);
+};
+
+#define KERNEL(fn)                                                                                 \
+	{                                                                                          \
+		.name = #fn, .eval = fn, .n_in = fn##_n_in, .n_out = fn##_n_out,                   \
+		.sparsity_in = fn##_sparsity_in, .sparsity_out = fn##_sparsity_out,                \
+		.work = fn##_work,                                                                 \
+	}
+
+static const struct kernel kernels[] = {
+	// rdd2.py
+	KERNEL(strapdown_ins_propagate),
+	KERNEL(attitude_control),
+	KERNEL(attitude_rate_control),
+	KERNEL(position_control),
+	KERNEL(control_allocation),
+	KERNEL(joy_acro),
+	KERNEL(joy_auto_level),
+	// rdd2_loglinear.py
+	KERNEL(se23_error),
+	KERNEL(so3_attitude_control),
+	KERNEL(se23_position_control),
+	KERNEL(se23_attitude_control),
+	// bezier.py
+	KERNEL(bezier7_solve),
+	KERNEL(bezier7_traj),
+	KERNEL(bezier3_solve),
+	KERNEL(bezier3_traj),
+	KERNEL(dcm_to_quat),
+	KERNEL(f_ref),
+	KERNEL(bezier_multirotor),
+	// b3rb.py
+	KERNEL(bezier6_solve),
+	KERNEL(bezier6_traj),
+	KERNEL(bezier6_rover),
+	KERNEL(ackermann_steering),
+	KERNEL(differential_steering),
+	KERNEL(se2_U),
+	KERNEL(se2_U_inv),
+	KERNEL(se2_error),
+	KERNEL(predict),
+	KERNEL(rover_mpc),
+	// common.py
+	KERNEL(butterworth_2_filter),
+	KERNEL(quat_to_eulerB321),
+	KERNEL(eulerB321_to_quat),
+};
+
+/********************************************************************
+ * timing, native_sim does not advance time while code runs, so the
+ * host monotonic clock is used there
+ ********************************************************************/
+#if defined(CONFIG_ARCH_POSIX)
+static inline uint64_t bench_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline uint64_t bench_to_ns(uint64_t t)
+{
+	return t;
+}
+#else
+static inline uint64_t bench_now(void)
+{
+	return k_cycle_get_32();
+}
+
+static inline uint64_t bench_to_ns(uint64_t t)
+{
+	return k_cyc_to_ns_floor64(t);
+}
+#endif
+
+/********************************************************************
+ * benchmark
+ ********************************************************************/
+struct result {
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+	size_t stack_used;
+	size_t workspace;
+};
+
+static K_THREAD_STACK_DEFINE(g_bench_stack, BENCH_STACK_SIZE);
+static struct k_thread g_bench_thread;
+
+static casadi_real g_in[BENCH_INPUT_SETS][BENCH_MAX_NNZ];
+static casadi_real g_out[BENCH_MAX_NNZ];
+static const casadi_real *g_arg[BENCH_INPUT_SETS][BENCH_MAX_ARG];
+static casadi_real *g_res[BENCH_MAX_ARG];
+static casadi_int g_iw[BENCH_MAX_IW];
+static casadi_real g_w[BENCH_MAX_W];
+
+// number of nonzeros of a compressed casadi sparsity pattern
+static casadi_int sparsity_nnz(const casadi_int *sp)
+{
+	casadi_int nrow = sp[0];
+	casadi_int ncol = sp[1];
+	// dense patterns are compressed to nrow, ncol, 1
+	if (sp[2] == 1) {
+		return nrow * ncol;
+	}
+	return sp[2 + ncol];
+}
+
+static casadi_real random_real(void)
+{
+	return (casadi_real)(int32_t)sys_rand32_get() / 2147483648.0;
+}
+
+static int bench_setup(const struct kernel *k, struct result *r)
+{
+	casadi_int sz_arg, sz_res, sz_iw, sz_w;
+	k->work(&sz_arg, &sz_res, &sz_iw, &sz_w);
+
+	r->workspace = (sz_arg + sz_res) * sizeof(void *) + sz_iw * sizeof(casadi_int) +
+		       sz_w * sizeof(casadi_real);
+
+	if (sz_arg > BENCH_MAX_ARG || sz_res > BENCH_MAX_ARG || sz_iw > BENCH_MAX_IW ||
+	    sz_w > BENCH_MAX_W) {
+		LOG_ERR("%s: workspace exceeds benchmark buffers", k->name);
+		return -ENOMEM;
+	}
+
+	for (int set = 0; set < BENCH_INPUT_SETS; set++) {
+		casadi_int offset = 0;
+		for (casadi_int i = 0; i < k->n_in(); i++) {
+			casadi_int nnz = sparsity_nnz(k->sparsity_in(i));
+			if (offset + nnz > BENCH_MAX_NNZ) {
+				LOG_ERR("%s: inputs exceed benchmark buffers", k->name);
+				return -ENOMEM;
+			}
+			g_arg[set][i] = &g_in[set][offset];
+			for (casadi_int j = 0; j < nnz; j++) {
+				g_in[set][offset + j] = random_real();
+			}
+			offset += nnz;
+		}
+	}
+
+	casadi_int offset = 0;
+	for (casadi_int i = 0; i < k->n_out(); i++) {
+		casadi_int nnz = sparsity_nnz(k->sparsity_out(i));
+		if (offset + nnz > BENCH_MAX_NNZ) {
+			LOG_ERR("%s: outputs exceed benchmark buffers", k->name);
+			return -ENOMEM;
+		}
+		g_res[i] = &g_out[offset];
+		offset += nnz;
+	}
+	return 0;
+}
+
+static void bench_entry(void *p0, void *p1, void *p2)
+{
+	const struct kernel *k = p0;
+	struct result *r = p1;
+	ARG_UNUSED(p2);
+
+	r->min = UINT32_MAX;
+	r->max = 0;
+	r->sum = 0;
+
+	for (int it = 0; it < CONFIG_CASADI_BENCH_ITERATIONS; it++) {
+		const casadi_real **arg = g_arg[it % BENCH_INPUT_SETS];
+		uint64_t start = bench_now();
+		if (k->eval != NULL) {
+			k->eval(arg, g_res, g_iw, g_w, 0);
+		}
+		uint32_t delta = bench_now() - start;
+		r->sum += delta;
+		if (delta < r->min) {
+			r->min = delta;
+		}
+		if (delta > r->max) {
+			r->max = delta;
+		}
+	}
+}
+
+static int bench_run(const struct kernel *k, struct result *r)
+{
+	size_t unused = 0;
+
+	// a fresh thread per kernel so the stack high water mark belongs to it
+	k_thread_create(&g_bench_thread, g_bench_stack, K_THREAD_STACK_SIZEOF(g_bench_stack),
+			bench_entry, (void *)k, r, NULL, BENCH_PRIORITY, 0, K_NO_WAIT);
+	k_thread_join(&g_bench_thread, K_FOREVER);
+
+	int rc = k_thread_stack_space_get(&g_bench_thread, &unused);
+	if (rc != 0) {
+		return rc;
+	}
+	r->stack_used = K_THREAD_STACK_SIZEOF(g_bench_stack) - unused;
+	return 0;
+}
+
+static void bench_print(const char *name, const struct result *r)
+{
+	uint64_t avg = r->sum / CONFIG_CASADI_BENCH_ITERATIONS;
+#if defined(CONFIG_ARCH_POSIX)
+	printf("%-24s %10s %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %8zu %8zu\n", name, "-",
+	       bench_to_ns(r->min), bench_to_ns(avg), bench_to_ns(r->max), r->stack_used,
+	       r->workspace);
+#else
+	printf("%-24s %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %8zu %8zu\n", name,
+	       avg, bench_to_ns(r->min), bench_to_ns(avg), bench_to_ns(r->max), r->stack_used,
+	       r->workspace);
+#endif
+}
+
+int main(void)
+{
+	struct result r = {};
+	static const struct kernel noop = {.name = "(thread baseline)"};
+
+	printf("%-24s %10s %10s %10s %10s %8s %8s\n", "kernel", "avg cyc", "min ns", "avg ns",
+	       "max ns", "stack B", "work B");
+
+	// stack used by the benchmark thread itself, subtract from the kernels below
+	if (bench_run(&noop, &r) == 0) {
+		bench_print(noop.name, &r);
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(kernels); i++) {
+		r = (struct result){};
+		if (bench_setup(&kernels[i], &r) != 0) {
+			continue;
+		}
+		if (bench_run(&kernels[i], &r) != 0) {
+			LOG_ERR("%s: failed to read stack usage", kernels[i].name);
+			continue;
+		}
+		bench_print(kernels[i].name, &r);
+	}
+
+	printf("casadi bench: done\n");
+	return 0;
+}
+
+// vi: ts=4 sw=4 et
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2024 CogniPilot Foundation
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+
+#include <cerebri/core/casadi.h>
+
+#include "casadi/b3rb_f32.h"
+
+#include "kernels_f32.h"
+
+CASADI_FUNC_DEFINE(bezier6_rover_f32);
+CASADI_FUNC_DEFINE(se2_error_f32);
+CASADI_FUNC_DEFINE(ackermann_steering_f32);
+CASADI_FUNC_DEFINE(differential_steering_f32);
+
+int bezier6_rover_f32_eval(double t, double T, const double PX[6], const double PY[6],
+			   double out[5])
+{
+	casadi_real t_f = t;
+	casadi_real T_f = T;
+	casadi_real PX_f[6], PY_f[6];
+	casadi_real out_f[5];
+
+	for (int i = 0; i < 6; i++) {
+		PX_f[i] = PX[i];
+		PY_f[i] = PY[i];
+	}
+
+	CASADI_FUNC_ARGS(bezier6_rover_f32);
+	args[0] = &t_f;
+	args[1] = &T_f;
+	args[2] = PX_f;
+	args[3] = PY_f;
+	for (int i = 0; i < 5; i++) {
+		res[i] = &out_f[i];
+	}
+	int rc = bezier6_rover_f32_call();
+
+	for (int i = 0; i < 5; i++) {
+		out[i] = out_f[i];
+	}
+	return rc;
+}
+
+int se2_error_f32_eval(const double p[3], const double r[3], double e[3])
+{
+	casadi_real p_f[3], r_f[3], e_f[3];
+
+	for (int i = 0; i < 3; i++) {
+		p_f[i] = p[i];
+		r_f[i] = r[i];
+	}
+
+	CASADI_FUNC_ARGS(se2_error_f32);
+	args[0] = p_f;
+	args[1] = r_f;
+	res[0] = e_f;
+	int rc = se2_error_f32_call();
+
+	for (int i = 0; i < 3; i++) {
+		e[i] = e_f[i];
+	}
+	return rc;
+}
+
+int ackermann_steering_f32_eval(double L, double omega, double V, double *delta)
+{
+	casadi_real L_f = L;
+	casadi_real omega_f = omega;
+	casadi_real V_f = V;
+	casadi_real delta_f = 0;
+
+	CASADI_FUNC_ARGS(ackermann_steering_f32);
+	args[0] = &L_f;
+	args[1] = &omega_f;
+	args[2] = &V_f;
+	res[0] = &delta_f;
+	int rc = ackermann_steering_f32_call();
+
+	*delta = delta_f;
+	return rc;
+}
+
+int differential_steering_f32_eval(double L, double omega, double w, double *Vw)
+{
+	casadi_real L_f = L;
+	casadi_real omega_f = omega;
+	casadi_real w_f = w;
+	casadi_real Vw_f = 0;
+
+	CASADI_FUNC_ARGS(differential_steering_f32);
+	args[0] = &L_f;
+	args[1] = &omega_f;
+	args[2] = &w_f;
+	res[0] = &Vw_f;
+	int rc = differential_steering_f32_call();
+
+	*Vw = Vw_f;
+	return rc;
+}
+
+// vi: ts=4 sw=4 et
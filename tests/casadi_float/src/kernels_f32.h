@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2024 CogniPilot Foundation
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef CASADI_FLOAT_KERNELS_F32_H
+#define CASADI_FLOAT_KERNELS_F32_H
+
+/*
+ * Double precision entry points to the single precision kernels. The float
+ * kernels live in their own translation unit because the generated headers
+ * define casadi_real, which can only be set once per translation unit.
+ */
+
+int bezier6_rover_f32_eval(double t, double T, const double PX[6], const double PY[6],
+			   double out[5]);
+
+int se2_error_f32_eval(const double p[3], const double r[3], double e[3]);
+
+int ackermann_steering_f32_eval(double L, double omega, double V, double *delta);
+
+int differential_steering_f32_eval(double L, double omega, double w, double *Vw);
+
+#endif // CASADI_FLOAT_KERNELS_F32_H
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2024 CogniPilot Foundation
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include <cerebri/core/casadi.h>
+
+#include "casadi/b3rb.h"
+
+#include "kernels_f32.h"
+
+LOG_MODULE_REGISTER(casadi_float, CONFIG_CASADI_FLOAT_LOG_LEVEL);
+
+// a float result is accepted if |f - d| <= ATOL + RTOL * |d|
+#define ATOL 1e-4
+#define RTOL 1e-4
+
+CASADI_FUNC_DEFINE(bezier6_rover);
+CASADI_FUNC_DEFINE(se2_error);
+CASADI_FUNC_DEFINE(ackermann_steering);
+CASADI_FUNC_DEFINE(differential_steering);
+
+/********************************************************************
+ * inputs, representative of b3rb/melm bezier legs and steering commands
+ ********************************************************************/
+struct bezier_input {
+	double t;
+	double T;
+	double PX[6];
+	double PY[6];
+};
+
+static const struct bezier_input bezier_inputs[] = {
+	{.t = 2.5, .T = 5, .PX = {0, 1, 2, 3, 4, 5}, .PY = {0, 0, 0, 0, 0, 0}},
+	{.t = 0.1, .T = 8, .PX = {0, 2, 4, 6, 7, 8}, .PY = {0, 0, 1, 3, 5, 8}},
+	{.t = 4.0, .T = 8, .PX = {0, 2, 4, 6, 7, 8}, .PY = {0, 0, 1, 3, 5, 8}},
+	{.t = 7.9, .T = 8, .PX = {0, 2, 4, 6, 7, 8}, .PY = {0, 0, 1, 3, 5, 8}},
+	{.t = 3.0,
+	 .T = 6,
+	 .PX = {40, 41, 42.5, 44, 45, 46},
+	 .PY = {-30, -29, -27, -26, -25.5, -25}},
+	{.t = 1.2,
+	 .T = 3,
+	 .PX = {-12.3, -12.0, -11.2, -10.9, -10.8, -10.8},
+	 .PY = {7.1, 7.6, 8.4, 9.5, 10.1, 10.4}},
+};
+
+struct se2_input {
+	double p[3];
+	double r[3];
+};
+
+static const struct se2_input se2_inputs[] = {
+	{.p = {0, 0, 0}, .r = {0.1, -0.05, 0.02}},
+	{.p = {1, 2, 3.1}, .r = {1.1, 2.05, -3.1}},
+	{.p = {40.2, -29.7, 0.7}, .r = {40.5, -29.5, 0.75}},
+	{.p = {-10.9, 9.6, 1.9}, .r = {-10.95, 9.5, 1.85}},
+};
+
+struct steering_input {
+	double L;
+	double omega;
+	double V;
+};
+
+static const struct steering_input steering_inputs[] = {
+	{.L = 0.22, .omega = 0.5, .V = 1.0},
+	{.L = 0.22, .omega = -1.2, .V = 0.3},
+	{.L = 0.22, .omega = 0.0, .V = 2.0},
+	{.L = 0.22, .omega = 2.5, .V = 0.05},
+};
+
+/********************************************************************
+ * comparison
+ ********************************************************************/
+static int compare(const char *name, size_t sample, const double *d, const double *f, size_t n,
+		   double *max_err)
+{
+	int failures = 0;
+	for (size_t i = 0; i < n; i++) {
+		double err = fabs(f[i] - d[i]);
+		if (err > *max_err) {
+			*max_err = err;
+		}
+		if (!isfinite(f[i]) || err > ATOL + RTOL * fabs(d[i])) {
+			LOG_ERR("%s sample %zu out %zu: double %12.8f float %12.8f", name, sample, i,
+				d[i], f[i]);
+			failures++;
+		}
+	}
+	return failures;
+}
+
+static int test_bezier6_rover(void)
+{
+	int failures = 0;
+	double max_err = 0;
+	for (size_t k = 0; k < ARRAY_SIZE(bezier_inputs); k++) {
+		const struct bezier_input *in = &bezier_inputs[k];
+		double out_d[5], out_f[5];
+
+		/* bezier6_rover:(t,T,PX[1x6],PY[1x6])->(x,y,psi,V,omega) */
+		CASADI_FUNC_ARGS(bezier6_rover);
+		args[0] = &in->t;
+		args[1] = &in->T;
+		args[2] = in->PX;
+		args[3] = in->PY;
+		for (int i = 0; i < 5; i++) {
+			res[i] = &out_d[i];
+		}
+		CASADI_FUNC_CALL(bezier6_rover);
+
+		bezier6_rover_f32_eval(in->t, in->T, in->PX, in->PY, out_f);
+		failures += compare("bezier6_rover", k, out_d, out_f, 5, &max_err);
+	}
+	LOG_INF("bezier6_rover max error: %g", max_err);
+	return failures;
+}
+
+static int test_se2_error(void)
+{
+	int failures = 0;
+	double max_err = 0;
+	for (size_t k = 0; k < ARRAY_SIZE(se2_inputs); k++) {
+		const struct se2_input *in = &se2_inputs[k];
+		double e_d[3], e_f[3];
+
+		/* se2_error:(p[3],r[3])->(error[3]) */
+		CASADI_FUNC_ARGS(se2_error);
+		args[0] = in->p;
+		args[1] = in->r;
+		res[0] = e_d;
+		CASADI_FUNC_CALL(se2_error);
+
+		se2_error_f32_eval(in->p, in->r, e_f);
+		failures += compare("se2_error", k, e_d, e_f, 3, &max_err);
+	}
+	LOG_INF("se2_error max error: %g", max_err);
+	return failures;
+}
+
+static int test_steering(void)
+{
+	int failures = 0;
+	double max_err_ackermann = 0;
+	double max_err_differential = 0;
+	const double w = 0.25;
+	for (size_t k = 0; k < ARRAY_SIZE(steering_inputs); k++) {
+		const struct steering_input *in = &steering_inputs[k];
+		double delta_d, delta_f, Vw_d, Vw_f;
+
+		/* ackermann_steering:(L,omega,V)->(delta) */
+		{
+			CASADI_FUNC_ARGS(ackermann_steering);
+			args[0] = &in->L;
+			args[1] = &in->omega;
+			args[2] = &in->V;
+			res[0] = &delta_d;
+			CASADI_FUNC_CALL(ackermann_steering);
+		}
+
+		/* differential_steering:(L,omega,w)->(Vw) */
+		{
+			CASADI_FUNC_ARGS(differential_steering);
+			args[0] = &in->L;
+			args[1] = &in->omega;
+			args[2] = &w;
+			res[0] = &Vw_d;
+			CASADI_FUNC_CALL(differential_steering);
+		}
+
+		ackermann_steering_f32_eval(in->L, in->omega, in->V, &delta_f);
+		differential_steering_f32_eval(in->L, in->omega, w, &Vw_f);
+		failures += compare("ackermann_steering", k, &delta_d, &delta_f, 1,
+				    &max_err_ackermann);
+		failures += compare("differential_steering", k, &Vw_d, &Vw_f, 1,
+				    &max_err_differential);
+	}
+	LOG_INF("ackermann_steering max error: %g", max_err_ackermann);
+	LOG_INF("differential_steering max error: %g", max_err_differential);
+	return failures;
+}
+
+int main(void)
+{
+	int failures = 0;
+	failures += test_bezier6_rover();
+	failures += test_se2_error();
+	failures += test_steering();
+
+	if (failures == 0) {
+		LOG_INF("casadi float: PASS");
+	} else {
+		LOG_ERR("casadi float: FAIL (%d)", failures);
+	}
+	return 0;
+}
+
+// vi: ts=4 sw=4 et